@@ -0,0 +1,40 @@
+TARGET = StackInterpreter
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++17
+
+# You can make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+include(core.pri)
+
+SOURCES += \
+    src/console_output_sink.cpp \
+    src/customoptions.cpp \
+    src/dialog_input_source.cpp \
+    src/mainwindow.cpp \
+    src/memory_inspector.cpp \
+    src/view_models.cpp \
+    src/vm_worker.cpp \
+    main.cpp
+
+HEADERS += \
+    headers/console_output_sink.h \
+    headers/customoptions.h \
+    headers/dialog_input_source.h \
+    headers/mainwindow.h \
+    headers/memory_inspector.h \
+    headers/view_models.h \
+    headers/vm_worker.h
+
+FORMS += \
+    GUI/mainwindow.ui
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
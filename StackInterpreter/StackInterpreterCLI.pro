@@ -0,0 +1,16 @@
+TARGET = StackInterpreterCLI
+
+QT       = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+include(core.pri)
+
+SOURCES += \
+    main_cli.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,60 @@
+TEMPLATE = lib
+TARGET = StackInterpreterCore
+
+QT       = core
+
+CONFIG += c++17 staticlib
+
+# Keeps one indirect jump per opcode in the threaded run loop (GCC merges the identical dispatch tails otherwise)
+*-g++*: QMAKE_CXXFLAGS += -fno-crossjumping
+
+SOURCES += \
+    src/asmexporter.cpp \
+    src/assembler.cpp \
+    src/buffered_writer.cpp \
+    src/cppexporter.cpp \
+    src/input_source.cpp \
+    src/instruction_handler.cpp \
+    src/instructions.cpp \
+    src/interpreter.cpp \
+    src/jit.cpp \
+    src/memory.cpp \
+    src/native_compiler.cpp \
+    src/nativecppexporter.cpp \
+    src/optimizer.cpp \
+    src/output_sink.cpp \
+    src/peephole.cpp \
+    src/profiler.cpp \
+    src/program.cpp \
+    src/region.cpp \
+    src/stack.cpp \
+    src/trace.cpp \
+    src/trap.cpp \
+    src/verifier.cpp
+
+HEADERS += \
+    headers/asmexporter.h \
+    headers/assembler.h \
+    headers/buffered_writer.h \
+    headers/cppexporter.h \
+    headers/exporter.h \
+    headers/input_source.h \
+    headers/instruction_handler.h \
+    headers/instructions.h \
+    headers/interpreter.h \
+    headers/jit.h \
+    headers/memory.h \
+    headers/native_compiler.h \
+    headers/nativecppexporter.h \
+    headers/optimizer.h \
+    headers/output_sink.h \
+    headers/peephole.h \
+    headers/profiler.h \
+    headers/program.h \
+    headers/region.h \
+    headers/snapshot.h \
+    headers/stack.h \
+    headers/superinstructions.h \
+    headers/trace.h \
+    headers/trap.h \
+    headers/verifier.h
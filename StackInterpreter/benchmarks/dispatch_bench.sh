@@ -0,0 +1,29 @@
+#!/bin/sh
+# Compares the InstructionHandler switch dispatch with the Interpreter run loop on a loop heavy program.
+# Usage: dispatch_bench.sh path/to/StackInterpreterCLI [iterations]
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI [iterations]"}
+ITERATIONS=${2:-1000000}
+PROGRAM=$(mktemp /tmp/dispatch_bench.XXXXXX)
+trap 'rm -f "$PROGRAM"' EXIT
+
+cat > "$PROGRAM" <<PROGRAM_SOURCE
+    PUSHI $ITERATIONS
+loop:
+    PUSHI 3
+    PUSHI 4
+    ADD
+    DUP
+    MUL
+    PUSH 0
+    POP 0
+    DROP
+    PUSHI 1
+    SUB
+    DUP
+    JNZ loop
+    HLT
+PROGRAM_SOURCE
+
+for dispatch in switch threaded; do
+    "$CLI" --dispatch $dispatch "$PROGRAM" || exit 1
+done
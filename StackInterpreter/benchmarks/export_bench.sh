@@ -0,0 +1,21 @@
+#!/bin/sh
+# Exports a straight line program of N instructions (10 million by default) to C++ and to assembly.
+# The export time (Excluding the assembler) is reported on stderr, it should stay well under a second. Every format is
+# exported to /dev/null first (Formatting and buffering only) and then to a file (Adds the cost of the file system).
+# Usage: export_bench.sh path/to/StackInterpreterCLI [instructions]
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI [instructions]"}
+INSTRUCTIONS=${2:-10000000}
+PROGRAM=$(mktemp /tmp/export_bench.XXXXXX)
+OUTPUT=$(mktemp /tmp/export_bench_out.XXXXXX)
+trap 'rm -f "$PROGRAM" "$OUTPUT"' EXIT
+
+awk -v n="$INSTRUCTIONS" 'BEGIN{
+    for(i = 0; i + 10 <= n; i += 10)
+        printf "PUSHI %d\nPUSHI 7\nADD\nDUP\nMUL\nPUSH 1\nPOP 1\nPUSHI 3\nSUB\nDROP\n", i % 1000
+}' > "$PROGRAM"
+
+for format in cpp asm; do
+    "$CLI" --export $format /dev/null "$PROGRAM" || exit 1
+    "$CLI" --export $format "$OUTPUT" "$PROGRAM" || exit 1
+    ls -l "$OUTPUT" | awk '{ print "output: " $5 " bytes" }'
+done
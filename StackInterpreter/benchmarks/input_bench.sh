@@ -0,0 +1,31 @@
+#!/bin/sh
+# Sums N input values (10 million by default) read through each input source: stdin, a text file and a mapped binary
+# file of little endian int32 values, with INPUT and with INPUTN 8. Every run must leave the same sum on the stack.
+# Usage: input_bench.sh path/to/StackInterpreterCLI [values]
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI [values]"}
+VALUES=${2:-10000000}
+DIR=$(mktemp -d /tmp/input_bench.XXXXXX)
+trap 'rm -rf "$DIR"' EXIT
+
+printf 'PUSHI 0\nloop:\n    INPUT\n    ADD\n    JMP loop\n' > "$DIR/input.stk"
+printf 'PUSHI 0\nloop:\n    INPUTN 8\n' > "$DIR/inputn.stk"
+for i in 1 2 3 4 5 6 7 8; do printf '    ADD\n' >> "$DIR/inputn.stk"; done
+printf '    JMP loop\n' >> "$DIR/inputn.stk"
+python3 - "$VALUES" "$DIR" <<'PYTHON' || exit 1
+import struct, sys
+count, directory = int(sys.argv[1]) // 8 * 8, sys.argv[2]
+values = [(i * 7919) % 2001 - 1000 for i in range(count)]
+open(directory + "/values.txt", "w").write(" ".join(map(str, values)) + "\n")
+open(directory + "/values.bin", "wb").write(struct.pack("<%di" % count, *values))
+PYTHON
+
+run(){
+    printf '%-28s' "$1"
+    shift
+    "$@" 2>&1 | awk '/^wall time:/ { time = $3 } /^stack:/ { sum = $2 } END { print time " s  (sum " sum ")" }'
+}
+for program in input inputn; do
+    run "$program stdin" sh -c '"$0" --dump "$1" < "$2"' "$CLI" "$DIR/$program.stk" "$DIR/values.txt"
+    run "$program --input" "$CLI" --dump --input "$DIR/values.txt" "$DIR/$program.stk"
+    run "$program --input-binary" "$CLI" --dump --input-binary "$DIR/values.bin" "$DIR/$program.stk"
+done
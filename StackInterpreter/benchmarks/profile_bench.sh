@@ -0,0 +1,34 @@
+#!/bin/sh
+# Runs a loop heavy program through the Interpreter without a profile, with --profile and with --profile-cycles, the
+# unprofiled run must keep the speed of dispatch_bench.sh (Its run loop has no profiling code). The profiles are
+# written to /dev/null.
+# Usage: profile_bench.sh path/to/StackInterpreterCLI [iterations]
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI [iterations]"}
+ITERATIONS=${2:-10000000}
+PROGRAM=$(mktemp /tmp/profile_bench.XXXXXX)
+trap 'rm -f "$PROGRAM"' EXIT
+
+cat > "$PROGRAM" <<PROGRAM_SOURCE
+    PUSHI $ITERATIONS
+loop:
+    PUSHI 3
+    PUSHI 4
+    ADD
+    DUP
+    MUL
+    PUSH 0
+    POP 0
+    DROP
+    PUSHI 1
+    SUB
+    DUP
+    JNZ loop
+    HLT
+PROGRAM_SOURCE
+
+echo "--- without profile"
+"$CLI" "$PROGRAM" || exit 1
+echo "--- --profile"
+"$CLI" --profile /dev/null "$PROGRAM" || exit 1
+echo "--- --profile --profile-cycles"
+"$CLI" --profile /dev/null --profile-cycles "$PROGRAM" || exit 1
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Stack operation microbenchmark (SWAP/DUP/arithmetic heavy loop) for the Interpreter run loop.
+# Usage: stack_bench.sh path/to/StackInterpreterCLI [iterations]
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI [iterations]"}
+ITERATIONS=${2:-30000000}
+PROGRAM=$(mktemp /tmp/stack_bench.XXXXXX)
+trap 'rm -f "$PROGRAM"' EXIT
+
+cat > "$PROGRAM" <<PROGRAM_SOURCE
+    PUSHI $ITERATIONS
+loop:
+    PUSHI 7
+    PUSHI 5
+    SWAP
+    SUB
+    DUP
+    MUL
+    PUSHI 3
+    ADD
+    DROP
+    PUSHI 1
+    SUB
+    DUP
+    JNZ loop
+    HLT
+PROGRAM_SOURCE
+
+"$CLI" "$PROGRAM"
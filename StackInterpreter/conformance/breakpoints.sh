@@ -0,0 +1,29 @@
+#!/bin/sh
+# Runs every conformance program (And the examples) with a breakpoint on each of its instructions (--continue reports
+# them and goes on) and compares the printed values, the trap, the executed count and the final stack and memory with a
+# run without breakpoints. Every instruction must be hit once before it runs (So a trapping run hits one more).
+# The input of a program is read from its "; input:" line.
+# Usage: breakpoints.sh path/to/StackInterpreterCLI
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI"}
+DIR=$(dirname "$0")
+STATUS=0
+FILTER='^dispatch:\|^verification:\|^superinstructions:\|^wall time:\|^instructions/second:\|^breakpoint'
+for program in "$DIR"/*.stk "$DIR"/../examples/*.stk; do
+    input=$(sed -n 's/^; input://p' "$program")
+    size=$(sed -e 's/;.*//' -e 's/[A-Za-z_][A-Za-z0-9_]*://g' "$program" | grep -c '[A-Za-z]')
+    breaks=$(seq 0 $((size - 1)) | sed 's/^/--break /' | tr '\n' ' ')
+    reference=$(echo "$input" | "$CLI" --no-fold --dump --stack 8 "$program" 2>&1 | grep -v "$FILTER")
+    output=$(echo "$input" | "$CLI" --dump --stack 8 --continue $breaks "$program" 2>&1)
+    hits=$(echo "$output" | grep -c '^breakpoint:')
+    executed=$(echo "$output" | sed -n 's/^instructions executed: //p')
+    expected=$executed
+    echo "$output" | grep -q 'trap at pc' && expected=$((executed + 1))
+    output=$(echo "$output" | grep -v "$FILTER")
+    if [ "$output" != "$reference" ] || [ "$hits" -ne "$expected" ]; then
+        printf 'FAIL %s (%s hits, %s expected)\n--- without breakpoints\n%s\n--- with breakpoints\n%s\n' "$program" "$hits" "$expected" "$reference" "$output"
+        STATUS=1
+    else
+        echo "ok   $program"
+    fi
+done
+exit $STATUS
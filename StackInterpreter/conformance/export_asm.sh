@@ -0,0 +1,33 @@
+#!/bin/sh
+# Exports every conformance program (And the examples) with --export asm, assembles and links it with GNU as/ld and
+# compares the printed values, the trap and the exit status with the Interpreter (x86-64 Linux only).
+# The input of a program is read from its "; input:" line.
+# Usage: export_asm.sh path/to/StackInterpreterCLI
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI"}
+DIR=$(dirname "$0")
+if [ "$(uname -s)-$(uname -m)" != "Linux-x86_64" ]; then
+    echo "skip (The assembly export targets x86-64 Linux)"
+    exit 0
+fi
+WORK=$(mktemp -d /tmp/export_asm.XXXXXX)
+trap 'rm -rf "$WORK"' EXIT
+STATUS=0
+for program in "$DIR"/*.stk "$DIR"/../examples/*.stk; do
+    input=$(sed -n 's/^; input://p' "$program")
+    if ! "$CLI" --quiet --stack 8 --export asm "$WORK/program.asm" "$program" ||
+       ! as -o "$WORK/program.o" "$WORK/program.asm" || ! ld -o "$WORK/program" "$WORK/program.o"; then
+        echo "FAIL $program (Exported file does not assemble)"
+        STATUS=1
+        continue
+    fi
+    reference=$(echo "$input" | "$CLI" --quiet --no-fold --stack 8 "$program" 2>&1; echo "status $?")
+    reference=$(echo "$reference" | sed 's/^.*: \(trap at pc .*\)$/\1/')
+    output=$(echo "$input" | "$WORK/program" 2>&1; echo "status $?")
+    if [ "$output" != "$reference" ]; then
+        printf 'FAIL %s\n--- interpreter\n%s\n--- asm\n%s\n' "$program" "$reference" "$output"
+        STATUS=1
+    else
+        echo "ok   $program"
+    fi
+done
+exit $STATUS
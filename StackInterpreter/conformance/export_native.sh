@@ -0,0 +1,35 @@
+#!/bin/sh
+# Exports every conformance program (And the examples) with --export native, builds the C++ file with the system
+# compiler and compares the printed values, the trap and the exit status with the Interpreter.
+# Programs the native exporter refuses (Inconsistent stack depths, recursion) are reported as skipped.
+# The input of a program is read from its "; input:" line.
+# Usage: export_native.sh path/to/StackInterpreterCLI [c++ compiler]
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI [c++ compiler]"}
+CXX=${2:-c++}
+DIR=$(dirname "$0")
+WORK=$(mktemp -d /tmp/export_native.XXXXXX)
+trap 'rm -rf "$WORK"' EXIT
+STATUS=0
+for program in "$DIR"/*.stk "$DIR"/../examples/*.stk; do
+    input=$(sed -n 's/^; input://p' "$program")
+    if ! reason=$("$CLI" --quiet --stack 8 --export native "$WORK/program.cpp" "$program" 2>&1); then
+        reason=${reason#*: cannot export (}
+        echo "skip $program (${reason%)})"
+        continue
+    fi
+    if ! "$CXX" -std=c++17 -O2 -o "$WORK/program" "$WORK/program.cpp"; then
+        echo "FAIL $program (Exported file does not compile)"
+        STATUS=1
+        continue
+    fi
+    reference=$(echo "$input" | "$CLI" --quiet --no-fold --stack 8 "$program" 2>&1; echo "status $?")
+    reference=$(echo "$reference" | sed 's/^.*: \(trap at pc .*\)$/\1/')
+    output=$(echo "$input" | "$WORK/program" 2>&1; echo "status $?")
+    if [ "$output" != "$reference" ]; then
+        printf 'FAIL %s\n--- interpreter\n%s\n--- native\n%s\n' "$program" "$reference" "$output"
+        STATUS=1
+    else
+        echo "ok   $program"
+    fi
+done
+exit $STATUS
@@ -0,0 +1,26 @@
+#!/bin/sh
+# Runs every conformance program (And the examples) with a timed profile and compares the printed values, the trap,
+# the executed count and the final stack and memory with a run without profile. The instructions counted by the
+# profile must be the executed ones.
+# The input of a program is read from its "; input:" line.
+# Usage: profile.sh path/to/StackInterpreterCLI
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI"}
+DIR=$(dirname "$0")
+WORK=$(mktemp -d /tmp/profile.XXXXXX)
+trap 'rm -rf "$WORK"' EXIT
+STATUS=0
+FILTER='^dispatch:\|^verification:\|^superinstructions:\|^wall time:\|^instructions/second:'
+for program in "$DIR"/*.stk "$DIR"/../examples/*.stk; do
+    input=$(sed -n 's/^; input://p' "$program")
+    reference=$(echo "$input" | "$CLI" --dump --stack 8 "$program" 2>&1 | grep -v "$FILTER")
+    output=$(echo "$input" | "$CLI" --dump --stack 8 --profile "$WORK/profile" --profile-cycles "$program" 2>&1 | grep -v "$FILTER")
+    executed=$(echo "$output" | sed -n 's/^instructions executed: //p')
+    profiled=$(sed -n 's/^Profile: \([0-9]*\) instructions executed.*/\1/p' "$WORK/profile")
+    if [ "$output" != "$reference" ] || [ "$profiled" != "$executed" ]; then
+        printf 'FAIL %s (%s instructions profiled, %s executed)\n--- without profile\n%s\n--- with profile\n%s\n' "$program" "$profiled" "$executed" "$reference" "$output"
+        STATUS=1
+    else
+        echo "ok   $program"
+    fi
+done
+exit $STATUS
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Runs every conformance program (And the examples) through the InstructionHandler, the Interpreter, the JIT and the
+# compiled shared objects (Twice: compiled, then loaded from the cache) and compares the printed values, traps,
+# executed counts, the final stack and memory and the exit status (A run killed by a signal fails). A last threaded run with the optimizer on is compared with the same
+# reference, without the executed counts and the trap offsets (Folding removes instructions).
+# The input of a program is read from its "; input:" line.
+# Usage: run.sh path/to/StackInterpreterCLI
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI"}
+DIR=$(dirname "$0")
+STATUS=0
+CACHE=$(mktemp -d)
+trap 'rm -rf "$CACHE"' EXIT
+for program in "$DIR"/*.stk "$DIR"/../examples/*.stk; do
+    input=$(sed -n 's/^; input://p' "$program")
+    reference=""
+    failed=0
+    for dispatch in switch threaded jit native native; do
+        output=$({ echo "$input" | "$CLI" --no-fold --dump --stack 8 --dispatch $dispatch --native-cache "$CACHE" "$program"; echo "status $?"; } 2>&1 |
+                 grep -v -e '^dispatch:' -e '^verification:' -e '^superinstructions:' -e '^native code:' -e '^native object:' -e '^wall time:' -e '^instructions/second:')
+        if [ "${output##*status }" -ge 128 ]; then
+            printf 'FAIL %s (%s killed by a signal)\n%s\n' "$program" "$dispatch" "$output"
+            failed=1
+            STATUS=1
+        elif [ -z "$reference" ]; then
+            reference=$output
+        elif [ "$output" != "$reference" ]; then
+            printf 'FAIL %s (%s)\n--- switch\n%s\n--- %s\n%s\n' "$program" "$dispatch" "$reference" "$dispatch" "$output"
+            failed=1
+            STATUS=1
+        fi
+    done
+    normalize='/^instructions executed:/d; s/ trap at pc [0-9]*:/ trap:/'
+    reference=$(echo "$reference" | sed "$normalize")
+    output=$({ echo "$input" | "$CLI" --dump --stack 8 --dispatch threaded "$program"; echo "status $?"; } 2>&1 |
+             grep -v -e '^dispatch:' -e '^verification:' -e '^optimizer:' -e '^superinstructions:' -e '^wall time:' -e '^instructions/second:' |
+             sed "$normalize")
+    if [ "$output" != "$reference" ]; then
+        printf 'FAIL %s (folded)\n--- switch\n%s\n--- folded\n%s\n' "$program" "$reference" "$output"
+        failed=1
+        STATUS=1
+    fi
+    [ $failed -eq 0 ] && echo "ok   $program"
+done
+exit $STATUS
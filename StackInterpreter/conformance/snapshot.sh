@@ -0,0 +1,39 @@
+#!/bin/sh
+# Pauses every conformance program (And the examples) at its first INPUT (No stdin), writes a snapshot with the
+# InstructionHandler, resumes it with its input through every dispatch mode and compares the printed values, the trap
+# and the final stack and memory with an uninterrupted run. A last run resumes from a copy of the image and writes its
+# snapshot over it (The restored image is still mapped), the new image must restore.
+# The input of a program is read from its "; input:" line.
+# Usage: snapshot.sh path/to/StackInterpreterCLI
+CLI=${1:?"Usage: $0 path/to/StackInterpreterCLI"}
+DIR=$(dirname "$0")
+WORK=$(mktemp -d /tmp/snapshot.XXXXXX)
+trap 'rm -rf "$WORK"' EXIT
+STATUS=0
+for program in "$DIR"/*.stk "$DIR"/../examples/*.stk; do
+    input=$(sed -n 's/^; input://p' "$program")
+    reference=$(echo "$input" | "$CLI" --quiet --no-fold --dump --stack 8 --dispatch switch "$program" 2>&1 | grep -v 'trap at pc .*: Waiting')
+    paused=$("$CLI" --quiet --dump --stack 8 --dispatch switch --snapshot "$WORK/image" "$program" < /dev/null 2>&1 |
+             grep -v -e 'trap at pc' -e '^stack:' -e '^memory:')
+    failed=0
+    for dispatch in switch threaded jit native; do
+        resumed=$(echo "$input" | "$CLI" --quiet --dump --dispatch $dispatch --native-cache "$WORK" --restore "$WORK/image" "$program" 2>&1 | grep -v 'trap at pc .*: Waiting')
+        output=$(printf '%s\n%s' "$paused" "$resumed" | sed '/^$/d')
+        if [ "$output" != "$(echo "$reference" | sed '/^$/d')" ]; then
+            printf 'FAIL %s (%s)\n--- uninterrupted\n%s\n--- resumed\n%s\n' "$program" "$dispatch" "$reference" "$output"
+            failed=1
+            STATUS=1
+        fi
+    done
+    cp "$WORK/image" "$WORK/checkpoint"
+    resumed=$(echo "$input" | "$CLI" --quiet --dump --restore "$WORK/checkpoint" --snapshot "$WORK/checkpoint" "$program" 2>&1 | grep -v 'trap at pc .*: Waiting')
+    output=$(printf '%s\n%s' "$paused" "$resumed" | sed '/^$/d')
+    if [ "$output" != "$(echo "$reference" | sed '/^$/d')" ] ||
+       "$CLI" --quiet --restore "$WORK/checkpoint" "$program" < /dev/null 2>&1 | grep -q 'not a snapshot'; then
+        printf 'FAIL %s (Snapshot over the restored image)\n--- uninterrupted\n%s\n--- resumed\n%s\n' "$program" "$reference" "$output"
+        failed=1
+        STATUS=1
+    fi
+    [ $failed -eq 0 ] && echo "ok   $program"
+done
+exit $STATUS
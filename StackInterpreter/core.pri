@@ -0,0 +1,6 @@
+# Included by every client of the interpreter core (Links the static library built by StackInterpreterCore.pro)
+INCLUDEPATH += $$PWD/headers
+LIBS += -L$$OUT_PWD -lStackInterpreterCore
+PRE_TARGETDEPS += $$OUT_PWD/libStackInterpreterCore.a
+# NativeCompiler loads the compiled programs with dlopen (In libc since glibc 2.34)
+unix:!macx: LIBS += -ldl
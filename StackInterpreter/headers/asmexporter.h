@@ -2,20 +2,32 @@
 #define ASMEXPORTER_H
 
 #include "exporter.h"
+#include "stack.h"
 
 namespace stackinterpreter{
 
+/**
+ * @brief x86-64 Linux assembly export backend (GNU as, AT&T syntax, assembled with "as" and linked with "ld").
+ * @details The stack lives in .bss (Sized from Stack::max_size) with the top of the stack cached in %r12d and the
+ *          address of the top slot in %rbx, like the JIT. The memory and the return stack are .bss arrays sized from
+ *          Memory::max_mem_size and the max number of nested CALL instructions. PRINT and INPUT go through buffered
+ *          write/read syscalls (No libc). Every check of the interpreter is kept, a trap prints "trap at pc N: message"
+ *          on stderr and exits with 1 (The macros name the traps with TRAP_* symbols set from the Trap enum).
+*/
 class ASMExporter : public Exporter{
 public:
-    explicit ASMExporter() : ASMExporter("export.asm"){}
-    explicit ASMExporter(const char* _filename) : filename(_filename){}
+    explicit ASMExporter(const char *_filename, const stackinterpreter::Stack &stack) :
+        filename(_filename), stack_size(stack.get_max_size()), memory_size(stack.get_max_mem_size()), call_depth(stack.get_max_call_depth()){}
     ASMExporter(const ASMExporter &cpy) = delete;
     ASMExporter& operator=(const ASMExporter &rhs) = delete;
 
-    [[nodiscard]] bool export_to_file(const QVector<QString> &instruction_log) const override;
+    [[nodiscard]] bool export_to_file(const QVector<stackinterpreter::bytecode_cell> &code) const override;
 
 private:
     QString filename;
+    qsizetype stack_size;
+    qsizetype memory_size;
+    qsizetype call_depth;
 };
 
 }
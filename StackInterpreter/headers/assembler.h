@@ -0,0 +1,62 @@
+/**
+ * @headerfile assembler.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include "program.h"
+#include "QVector"
+#include <QString>
+
+namespace stackinterpreter{
+
+typedef struct assembler_error{
+    int     line;    /// --> Source line (Starting at 1)
+    int     column;  /// --> Source column (Starting at 1)
+    QString message; /// --> Description of the error
+
+    /// Constructors
+    assembler_error() : line(0), column(0){}
+    assembler_error(int _line, int _column, const QString &_message) : line(_line), column(_column), message(_message){}
+} assembler_error;
+
+/**
+ * @brief Translate a program source into packed bytecode.
+ * @details Source format (One instruction per line, mnemonics are the same as instructions.h):
+ *
+ *     ; Comments start with ';' or '#'
+ *     start:              ; Labels end with ':' and may share the line with an instruction
+ *         PUSHI -12       ; Decimal immediate (0x prefix for hexadecimal)
+ *         PUSH 1f         ; Hexadecimal memory address, like in the GUI
+ *         POP 1f
+ *         JNZ start       ; Branch targets are labels (Or absolute offsets), resolved when the program is loaded
+ *         HLT
+*/
+class Assembler{
+public:
+    explicit Assembler(){}
+    Assembler(const Assembler &cpy) = delete;
+    Assembler& operator=(const Assembler &rhs) = delete;
+
+    [[nodiscard]] bool assemble(const QString &source, Program &program) noexcept;
+    /// @brief Return the errors of the last assemble call
+    [[nodiscard]] const QVector<assembler_error>& get_errors() const noexcept { return errors; } // Inline function
+
+private:
+    typedef struct label_fixup{
+        qsizetype pc;     /// --> Offset of the branch waiting for the label
+        QString   label;  /// --> Label used as target
+        int       line;   /// --> Source line (Used to report undeclared labels)
+        int       column; /// --> Source column (Used to report undeclared labels)
+    } label_fixup;
+
+    QVector<assembler_error> errors;
+    QVector<label_fixup> fixups;
+
+    [[nodiscard]] bool parse_operand(int opcode, const QString &token, int line, int column, qint32 &operand) noexcept;
+};
+
+} // namespace stackinterpreter
+
+#endif // ASSEMBLER_H
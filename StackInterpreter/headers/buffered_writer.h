@@ -0,0 +1,59 @@
+/**
+ * @headerfile buffered_writer.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <QString>
+#include "QVector"
+#include <cstdio>
+#include <cstring>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Output file written through a large in-memory buffer (Used by the exporters).
+ * @details Text and integers are appended to the buffer without any allocation or locale handling, the file is only
+ *          written when the buffer is full. Errors are sticky: every write after a failure is ignored and close()
+ *          reports it.
+*/
+class BufferedWriter{
+public:
+    static constexpr qsizetype default_capacity = 1 << 20;
+
+    explicit BufferedWriter(const QString &filename, qsizetype _capacity = default_capacity);
+    ~BufferedWriter();
+    BufferedWriter(const BufferedWriter &cpy) = delete;
+    BufferedWriter& operator=(const BufferedWriter &rhs) = delete;
+
+    /// @brief Append size bytes of data
+    BufferedWriter& write(const char *data, qsizetype size) noexcept{ // Inline function
+        if(Q_LIKELY(used + size <= buffer.size())){
+            std::memcpy(buffer.data() + used, data, static_cast<size_t>(size));
+            used += size;
+            return *this;
+        }
+        return write_through(data, size);
+    }
+    /// @brief Append a null terminated string
+    BufferedWriter& operator<<(const char *text) noexcept { return write(text, static_cast<qsizetype>(std::strlen(text))); } // Inline function
+    BufferedWriter& operator<<(qint64 value) noexcept;
+
+    /// @brief Return true if the file was opened and no write failed
+    [[nodiscard]] bool is_good() const noexcept { return file != nullptr && !failed; } // Inline function
+    bool flush() noexcept;
+    [[nodiscard]] bool close() noexcept;
+
+private:
+    std::FILE *file;
+    QVector<char> buffer;
+    qsizetype used = 0;
+    bool failed = false;
+
+    BufferedWriter& write_through(const char *data, qsizetype size) noexcept;
+};
+
+} // namespace stackinterpreter
+
+#endif // BUFFERED_WRITER_H
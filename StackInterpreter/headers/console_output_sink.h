@@ -0,0 +1,33 @@
+/**
+ * @headerfile console_output_sink.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef CONSOLE_OUTPUT_SINK_H
+#define CONSOLE_OUTPUT_SINK_H
+
+#include "output_sink.h"
+#include <QPlainTextEdit>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Appends the printed values to the console pane of the GUI, batch_size values per repaint (Output sink of the GUI).
+*/
+class ConsoleOutputSink : public OutputSink{
+public:
+    static constexpr qsizetype batch_size = 4096;
+
+    explicit ConsoleOutputSink(QPlainTextEdit *_console) : console(_console){}
+
+    void write(const int *values, qsizetype count) override;
+    bool flush() override;
+
+private:
+    QPlainTextEdit *console; /// Not owned
+    QString pending;         /// Lines not appended yet
+    qsizetype pending_values = 0;
+};
+
+} // namespace stackinterpreter
+
+#endif // CONSOLE_OUTPUT_SINK_H
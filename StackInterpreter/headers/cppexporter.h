@@ -12,7 +12,7 @@ public:
     CPPExporter(const CPPExporter &cpy) = delete;
     CPPExporter& operator=(const CPPExporter &rhs) = delete;
 
-    [[nodiscard]] bool export_to_file(const QVector<QString> &instruction_log) const override;
+    [[nodiscard]] bool export_to_file(const QVector<stackinterpreter::bytecode_cell> &code) const override;
 
 private:
     QString filename;
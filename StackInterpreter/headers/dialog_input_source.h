@@ -0,0 +1,28 @@
+/**
+ * @headerfile dialog_input_source.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef DIALOG_INPUT_SOURCE_H
+#define DIALOG_INPUT_SOURCE_H
+
+#include "input_source.h"
+#include <QWidget>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Asks the user for every value with a modal dialog (Input source of the GUI).
+*/
+class DialogInputSource : public InputSource{
+public:
+    explicit DialogInputSource(QWidget *_parent) : parent(_parent){}
+
+    [[nodiscard]] qsizetype read(int *values, qsizetype count) override;
+
+private:
+    QWidget *parent; /// Not owned
+};
+
+} // namespace stackinterpreter
+
+#endif // DIALOG_INPUT_SOURCE_H
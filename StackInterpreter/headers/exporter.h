@@ -2,6 +2,7 @@
 #define EXPORTER_H
 
 #include <QString>
+#include "program.h" // bytecode_cell
 
 namespace stackinterpreter{
 
@@ -10,8 +11,10 @@ public:
     explicit Exporter(){}
     explicit Exporter(const Exporter &cpy) = delete;
     Exporter& operator=(const Exporter &rhs) = delete;
+    virtual ~Exporter(){}
 
-    [[nodiscard]] virtual bool export_to_file(const QVector<QString> &instruction_log) const = 0;
+    /// @brief Write the instruction sequence to the output file (Straight line code: the executed trace or a program without control flow)
+    [[nodiscard]] virtual bool export_to_file(const QVector<stackinterpreter::bytecode_cell> &code) const = 0;
 };
 
 } // namespace stackinterpreter
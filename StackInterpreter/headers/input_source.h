@@ -0,0 +1,114 @@
+/**
+ * @headerfile input_source.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef INPUT_SOURCE_H
+#define INPUT_SOURCE_H
+
+#include "instruction_handler.h" // io_buffers
+#include "region.h"
+#include <QString>
+#include "QVector"
+#include <cstdio>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Where the values consumed by INPUT and INPUTN come from.
+ * @details The run loops never call a source: they stop with Trap::WAITING_INPUT once the io_buffers are empty, the
+ *          client refills them (refill()) and resumes the run. A source is asked for a whole chunk of values at a time.
+*/
+class InputSource{
+public:
+    static constexpr qsizetype default_chunk = 1 << 16;
+
+    virtual ~InputSource(){}
+
+    /// @brief Read up to count values, return the number of values read (0 once the source is exhausted)
+    [[nodiscard]] virtual qsizetype read(int *values, qsizetype count) = 0;
+    [[nodiscard]] bool refill(stackinterpreter::io_buffers &io, qsizetype chunk = default_chunk);
+};
+
+/**
+ * @brief Values supplied up front.
+*/
+class BufferInputSource : public InputSource{
+public:
+    explicit BufferInputSource(const QVector<int> &_values) : values(_values){}
+
+    [[nodiscard]] qsizetype read(int *destination, qsizetype count) override;
+
+private:
+    QVector<int> values;
+    qsizetype position = 0;
+};
+
+/**
+ * @brief Decimal integers separated by white space, read from a stream in blocks of read_size bytes.
+ * @details A block is parsed at once, and a read never waits for more data once it has values, so an interactive
+ *          stream is consumed line by line. The source is exhausted at the end of the stream or at the first token
+ *          that is not an int.
+*/
+class TextInputSource : public InputSource{
+public:
+    static constexpr qsizetype read_size = 1 << 16;
+
+    explicit TextInputSource(std::FILE *_file, bool _owned = false);
+    ~TextInputSource() override;
+    TextInputSource(const TextInputSource &cpy) = delete;
+    TextInputSource& operator=(const TextInputSource &rhs) = delete;
+
+    [[nodiscard]] qsizetype read(int *values, qsizetype count) override;
+    /// @brief Return true if the stream could be opened
+    [[nodiscard]] bool is_open() const noexcept { return file != nullptr; } // Inline function
+
+private:
+    std::FILE *file;
+    bool owned; /// Closed by the destructor
+    QVector<char> buffer;
+    qsizetype begin = 0, end = 0; /// Bytes of buffer not parsed yet
+    bool at_end = false;
+
+    [[nodiscard]] bool fill() noexcept;
+};
+
+/**
+ * @brief Decimal integers read from stdin.
+*/
+class StdinInputSource : public TextInputSource{
+public:
+    StdinInputSource() : TextInputSource(stdin){}
+};
+
+/**
+ * @brief Decimal integers read from a text file.
+*/
+class TextFileInputSource : public TextInputSource{
+public:
+    explicit TextFileInputSource(const QString &filename);
+};
+
+/**
+ * @brief Little endian int32 values of a binary file, mapped in memory (Read on builds without mmap).
+ * @details The pages are only read from the file when the values are consumed, a chunk is a single copy. Trailing
+ *          bytes that do not make a whole value are ignored. The file must not be modified while it is read.
+*/
+class BinaryFileInputSource : public InputSource{
+public:
+    explicit BinaryFileInputSource(const QString &filename);
+
+    [[nodiscard]] qsizetype read(int *destination, qsizetype count) override;
+    /// @brief Return true if the file could be mapped or read
+    [[nodiscard]] bool is_open() const noexcept { return opened; } // Inline function
+    /// @brief Return the number of values of the file
+    [[nodiscard]] qsizetype size() const noexcept { return values.size(); } // Inline function
+
+private:
+    stackinterpreter::Region<qint32> values;
+    qsizetype position = 0;
+    bool opened = false;
+};
+
+} // namespace stackinterpreter
+
+#endif // INPUT_SOURCE_H
@@ -6,12 +6,20 @@
 #define INSTRUCTION_HANDLER_H
 
 #include <QString>
+#include <algorithm>
+#include <atomic>
+#include <limits>
 #include "instructions.h" // Enum
-#include "qtextedit.h"
+#include "program.h"
 #include "stack.h"
+#include "trace.h"
+#include "trap.h"
 
 namespace stackinterpreter{
 
+class InputSource;
+class OutputSink;
+
 typedef struct instruction_tuple{
     stackinterpreter::Instructions instruction; // Enum type
     int                            value;       // Can be null in case where the instruction is not PUSHI, PUSH or POP
@@ -23,6 +31,44 @@ typedef struct instruction_tuple{
     instruction_tuple(stackinterpreter::Instructions _instruction, int _value, const QString &_description): instruction(_instruction), value(_value), description(_description){}
 } instruction_tuple;
 
+typedef struct io_buffers{
+    QVector<int> input;          /// --> Values consumed by INPUT
+    qsizetype    input_position; /// --> Position of the next value to be consumed
+    QVector<int> output;         /// --> Values written by PRINT
+    stackinterpreter::OutputSink *sink; /// --> Receives output every output_threshold values (nullptr: kept in output), not owned
+
+    static constexpr qsizetype output_threshold = 1 << 16;
+
+    /// Constructors
+    io_buffers() : input_position(0), sink(nullptr){}
+
+    /// @brief Append a printed value (Handed to the sink once output_threshold values are buffered)
+    void print(int value){ // Inline function
+        output.append(value);
+        if(Q_UNLIKELY(output.size() >= output_threshold) && sink)
+            drain_output();
+    }
+    void drain_output();
+
+    /// @brief Copy the next count input values (Consumed), false if fewer are buffered (Nothing consumed)
+    [[nodiscard]] bool take_input(int *values, qsizetype count) noexcept{ // Inline function
+        if(input.size() - input_position < count)
+            return false;
+        std::copy(input.constData() + input_position, input.constData() + input_position + count, values);
+        input_position += count;
+        return true;
+    }
+} io_buffers;
+
+typedef struct run_result{
+    stackinterpreter::Trap trap;     /// --> Trap wich stopped the run (Trap::NONE if the program halted)
+    qsizetype              pc;       /// --> Offset of the instruction that stopped the run (Resume point for Trap::WAITING_INPUT)
+    quint64                executed; /// --> Number of instructions executed
+
+    /// Constructors
+    run_result() : trap(stackinterpreter::Trap::NONE), pc(0), executed(0){}
+} run_result;
+
 class InstructionHandler{
 public:
     explicit InstructionHandler(){}
@@ -32,18 +78,27 @@ public:
     InstructionHandler(const InstructionHandler &cpy) = delete;
     InstructionHandler& operator=(const InstructionHandler &rhs) = delete;
 
-    void execute(QWidget* parent, stackinterpreter::Stack &stack, int enumtype, int value, InstructionHandler &handler, const QString &description = "null") noexcept; /// T instead of int value soon
+    [[nodiscard]] stackinterpreter::Trap execute(stackinterpreter::Stack &stack, int enumtype, int &value, InstructionHandler &handler) noexcept; /// T instead of int value soon
+    [[nodiscard]] stackinterpreter::run_result run(stackinterpreter::Stack &stack, const stackinterpreter::Program &program, qsizetype pc, stackinterpreter::io_buffers &io,
+                                                   quint64 limit = std::numeric_limits<quint64>::max()) noexcept;
     [[nodiscard]] stackinterpreter::instruction_tuple handle_instruction(int enumtype, const QString &val = "null") noexcept;
                   /*       ALIAS TYPE RETURN       */
-    [[nodiscard]] QVector<QString>& get_log() noexcept { return log; } /// Inline function
-    void clear_log() noexcept { log.clear(); } /// Inline function
+    [[nodiscard]] stackinterpreter::Trace& get_trace() noexcept { return trace; } /// Inline function
+    void clear_trace() noexcept { trace.clear(); } /// Inline function
+    /// @brief Set where execute() reads the INPUT and INPUTN values from (nullptr: INPUT takes its value param)
+    void set_input_source(stackinterpreter::InputSource *source) noexcept { input_source = source; } /// Inline function
+    /// @brief Set where execute() writes the PRINT values (nullptr: only returned in the value param)
+    void set_output_sink(stackinterpreter::OutputSink *sink) noexcept { output_sink = sink; } /// Inline function
+    /// @brief Set a flag wich stops run() at the next taken branch (Trap::INTERRUPTED) once it is true, may be set from another thread
+    void set_interrupt(const std::atomic<bool> *flag) noexcept { interrupt = flag; } /// Inline function
     [[nodiscard]] int hex_to_int(const QString &hex) const noexcept;
     [[nodiscard]] bool is_valid_number(const QString &numstr) const noexcept;
 
-    friend QTextEdit& operator<<(QTextEdit &textEdit, InstructionHandler &handler);
-
 private:
-    QVector<QString> log;
+    stackinterpreter::Trace trace; /// Executed instructions (Instruction and memory logs are formatted from it)
+    stackinterpreter::InputSource *input_source = nullptr; /// Not owned
+    stackinterpreter::OutputSink *output_sink = nullptr; /// Not owned
+    const std::atomic<bool> *interrupt = nullptr; /// Not owned
 };
 
 } // namespsace stackinterpreter
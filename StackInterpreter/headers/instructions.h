@@ -26,9 +26,30 @@ enum Instructions{
     DROP,
     DUP,
     HLT,
+    JMP,  /// Unconditional jump
+    JZ,   /// Pops the top value and jumps if it is zero
+    JNZ,  /// Pops the top value and jumps if it is not zero
+    CALL, /// Pushes the return address onto the return stack and jumps
+    RET,  /// Jumps to the address popped from the return stack
+    INPUTN, /// Pushes the next N input values at once (The last one on top)
     ERROR
 };
 
+[[nodiscard]] const char* instruction_mnemonic(int opcode) noexcept;
+[[nodiscard]] bool instruction_has_operand(int opcode) noexcept;
+[[nodiscard]] bool instruction_is_branch(int opcode) noexcept;
+
+/// ADD, SUB and MUL wrap around (Two's complement, computed unsigned so they never overflow) and INT_MIN / -1 is INT_MIN,
+/// every backend gives the same result.
+/// @brief Return lhs + rhs modulo 2^32
+[[nodiscard]] inline int wrapping_add(int lhs, int rhs) noexcept { return static_cast<int>(static_cast<unsigned>(lhs) + static_cast<unsigned>(rhs)); } // Inline function
+/// @brief Return lhs - rhs modulo 2^32
+[[nodiscard]] inline int wrapping_sub(int lhs, int rhs) noexcept { return static_cast<int>(static_cast<unsigned>(lhs) - static_cast<unsigned>(rhs)); } // Inline function
+/// @brief Return lhs * rhs modulo 2^32
+[[nodiscard]] inline int wrapping_mul(int lhs, int rhs) noexcept { return static_cast<int>(static_cast<unsigned>(lhs) * static_cast<unsigned>(rhs)); } // Inline function
+/// @brief Return lhs / rhs (rhs != 0), INT_MIN / -1 wraps to INT_MIN
+[[nodiscard]] inline int wrapping_div(int lhs, int rhs) noexcept { return rhs == -1 ? wrapping_sub(0, lhs) : lhs / rhs; } // Inline function
+
 } // namespace stackinterpreter
 
 #endif // INSTRUCTIONS_H
@@ -0,0 +1,85 @@
+/**
+ * @headerfile interpreter.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include "instruction_handler.h" // io_buffers, run_result
+#include "peephole.h"
+#include "profiler.h"
+#include "program.h"
+#include "stack.h"
+#include "verifier.h"
+#include "QHash"
+#include "QList"
+#include <atomic>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Fast run loop over pre-decoded bytecode.
+ * @details Uses direct threaded dispatch (computed goto) on GCC/Clang and a switch elsewhere (Or when
+ *          STACKINTERPRETER_SWITCH_DISPATCH is defined). Operands are read inline from the bytecode and no instruction
+ *          or memory log is written, use InstructionHandler when the logs are needed (GUI stepping, exporters).
+ *          Programs proven safe by the Verifier run without the stack overflow/underflow and return stack checks.
+ *          Hot instruction pairs are fused in superinstructions (See superinstructions.h) when the program is loaded.
+ *          Breakpoints replace the opcode of their cell by BREAKPOINT, so the run loop never checks for them: a run
+ *          resumed from a breakpoint executes its instruction alone (With the original opcode) and patches it again.
+ *          Profiled runs use another instantiation of the run loop (Profiling policy), the others compile the hooks out.
+*/
+class Interpreter{
+public:
+    explicit Interpreter(const Program &program, bool optimize = true);
+    Interpreter(const Interpreter &cpy) = delete;
+    Interpreter& operator=(const Interpreter &rhs) = delete;
+
+    [[nodiscard]] stackinterpreter::run_result run(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept;
+    [[nodiscard]] stackinterpreter::run_result run_to(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io, qsizetype target, qsizetype call_depth = -1) noexcept;
+    bool set_breakpoint(qsizetype pc) noexcept;
+    void clear_breakpoint(qsizetype pc) noexcept;
+    void clear_breakpoints() noexcept;
+    /// @brief Return true if the runs stop before the instruction at pc
+    [[nodiscard]] bool has_breakpoint(qsizetype pc) const noexcept { return breakpoints.contains(pc); } // Inline function
+    [[nodiscard]] QList<qsizetype> get_breakpoints() const;
+    /// @brief Set a flag wich stops the run at the next taken branch (Trap::INTERRUPTED) once it is true, may be set from another thread
+    void set_interrupt(const std::atomic<bool> *flag) noexcept { interrupt = flag; } // Inline function
+    /// @brief Mark the memory slots written by the runs as dirty (Memory::dirty_ranges(), off by default: it costs a store per PUSH/POP)
+    void set_track_writes(bool track) noexcept { track_writes = track; } // Inline function
+    /// @brief Record the next runs in a profile (Cleared and sized for the loaded program), nullptr stops profiling
+    void set_profile(stackinterpreter::Profile *_profile){ profile = _profile; if(profile) profile->reset(code.size()); } // Inline function
+    /// @brief Return the number of instructions of the loaded program
+    [[nodiscard]] qsizetype size() const noexcept { return code.size() - 1; } // Inline function
+    /// @brief Return true if the run loop uses computed goto dispatch
+    [[nodiscard]] static bool threaded_dispatch() noexcept;
+    /// @brief Return the verifier of the loaded program (Tells why a program is not verified)
+    [[nodiscard]] const stackinterpreter::Verifier& get_verifier() const noexcept { return verifier; } // Inline function
+    /// @brief Return true if the loaded program was proven safe by the verifier
+    [[nodiscard]] bool is_verified() const noexcept { return verified; } // Inline function
+    /// @brief Return the number of instruction pairs fused in superinstructions
+    [[nodiscard]] qsizetype get_fused() const noexcept { return fused; } // Inline function
+
+private:
+    QVector<stackinterpreter::bytecode_cell> code; /// Loaded program followed by an end of program sentinel
+    stackinterpreter::Verifier verifier;
+    bool verified;
+    qsizetype fused;
+    const std::atomic<bool> *interrupt = nullptr; /// Not owned
+    bool track_writes = false;
+    stackinterpreter::Profile *profile = nullptr; /// Not owned
+    QHash<qsizetype, qint32> breakpoints; /// Offset --> opcode replaced by BREAKPOINT
+    QHash<qsizetype, qint32> stops;       /// Same for the target of run_to (Patched while it runs)
+
+    [[nodiscard]] bool can_run_unchecked(const stackinterpreter::Stack &stack, qsizetype pc) const noexcept;
+    [[nodiscard]] qint32 original_opcode(qsizetype pc) const noexcept;
+    void patch(qsizetype pc, QHash<qsizetype, qint32> &patched) noexcept;
+    [[nodiscard]] stackinterpreter::run_result resume(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io, qsizetype target, qsizetype call_depth) noexcept;
+    template<bool Single, class Policy>
+    [[nodiscard]] stackinterpreter::run_result run_policy(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept;
+    template<bool Checked, bool Tracked, bool Single, class Policy>
+    [[nodiscard]] stackinterpreter::run_result run_loop(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept;
+};
+
+} // namespace stackinterpreter
+
+#endif // INTERPRETER_H
@@ -0,0 +1,53 @@
+/**
+ * @headerfile jit.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef JIT_H
+#define JIT_H
+
+#include "instruction_handler.h" // io_buffers, run_result
+#include "program.h"
+#include "stack.h"
+
+namespace stackinterpreter{
+
+/**
+ * @brief Template JIT compiling a program to x86-64 machine code (Linux x86-64 builds only).
+ * @details Every instruction is emitted from a fixed machine code template into an mmap'd region wich is made executable
+ *          (And read only) once the whole program is written. The stack pointer and the top of the stack live in
+ *          registers like in the Interpreter run loop, the runtime is called back only for INPUT and PRINT, and every
+ *          trap leaves the native code with the offset of the instruction that raised it. Same semantics, traps,
+ *          executed counts and resume offsets as Interpreter::run, the stack checks are always on.
+*/
+class Jit{
+public:
+    explicit Jit(const Program &program);
+    ~Jit();
+    Jit(const Jit &cpy) = delete;
+    Jit& operator=(const Jit &rhs) = delete;
+
+    [[nodiscard]] stackinterpreter::run_result run(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept;
+    /// @brief Return true if the program was compiled (False on unsupported platforms or if the code could not be mapped)
+    [[nodiscard]] bool is_compiled() const noexcept { return entry != nullptr; } // Inline function
+    /// @brief Return the number of instructions of the loaded program
+    [[nodiscard]] qsizetype size() const noexcept { return entries.size() - 1; } // Inline function
+    /// @brief Return the size in bytes of the generated machine code
+    [[nodiscard]] qsizetype code_size() const noexcept { return native_size; } // Inline function
+    /// @brief Return true if this build can compile programs to native code
+    [[nodiscard]] static bool supported() noexcept;
+
+private:
+    typedef void (*native_entry)(void *context, const void *start);
+
+    native_entry entry = nullptr; /// Enters the native code at start (Restores the registers from the context)
+    void *native = nullptr; /// Executable region
+    qsizetype native_size = 0;
+    QVector<const void*> entries; /// Native address of every instruction (Plus the end of the program), branch and RET targets
+    QVector<qint32> pending_at; /// Instructions of the basic block before every instruction (Not yet counted when entering there)
+
+    void compile(const QVector<stackinterpreter::bytecode_cell> &code) noexcept;
+};
+
+} // namespace stackinterpreter
+
+#endif // JIT_H
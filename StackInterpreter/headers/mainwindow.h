@@ -1,10 +1,17 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "console_output_sink.h"
 #include "customoptions.h"
+#include "dialog_input_source.h"
 #include "instruction_handler.h"
+#include "memory_inspector.h"
 #include "stack.h"
+#include "view_models.h"
+#include "vm_worker.h"
 #include <QMainWindow>
+#include <QThread>
+#include <QTimer>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -18,6 +25,10 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
     void init_selector() noexcept;
+    void report_trap(stackinterpreter::Trap trap) noexcept;
+    void set_running(bool running) noexcept;
+    void sync_views() noexcept;
+    void toggle_breakpoint(qsizetype offset) noexcept;
 
 private slots:
     void on_instructions_select_currentIndexChanged(int index);
@@ -29,11 +40,43 @@ private slots:
     void on_clear_memory_log_button_clicked();
     void on_clear_instructions_log_button_clicked();
     void on_about_triggered();
+    void on_memory_inspector_triggered();
+    void on_load_button_clicked();
+    void on_run_button_clicked();
+    void on_pause_button_clicked();
+    void on_stop_button_clicked();
+    void on_step_button_clicked();
+    void on_step_into_button_clicked();
+    void on_step_over_button_clicked();
+    void on_run_to_cursor_button_clicked();
+    void on_breakpoint_button_clicked();
+    void on_program_view_doubleClicked(const QModelIndex &index);
+    void request_vm_state();
+    void vm_state_changed(const stackinterpreter::vm_state &state);
+    void vm_stopped(const stackinterpreter::vm_state &state);
 
 private:
     Ui::MainWindow *ui;
     stackinterpreter::InstructionHandler instruction_handler;
+    stackinterpreter::DialogInputSource input_source;
     stackinterpreter::Stack stack;
     stackinterpreter::CustomOptions *options_dialog_box;
+    stackinterpreter::ConsoleOutputSink *output_sink;
+    stackinterpreter::StackModel *stack_model;           /// Owned by the window (Qt parent)
+    stackinterpreter::TraceModel *instruction_model;
+    stackinterpreter::MemoryLogModel *memory_model;
+    stackinterpreter::MemoryModel *memory_inspector_model;
+    stackinterpreter::ProgramModel *program_model;
+    stackinterpreter::MemoryInspector *memory_inspector;
+    QThread worker_thread;
+    stackinterpreter::VMWorker *worker; /// Lives in worker_thread, owns stack and instruction_handler while a program runs
+    QTimer state_timer;                 /// Asks the running program for its state (state_interval ms)
+    bool state_pending = false;         /// A state was asked and not received yet (At most one state in flight)
+    bool vm_running = false;
+    bool stop_pending = false;          /// Stop was asked, the run ends as Trap::INTERRUPTED like a pause
+
+    static constexpr qsizetype log_depth = 1 << 20; /// Trace entries kept for the logs (About a million rows, 24 MiB)
+    static constexpr int state_interval = 33; /// About 30 states per second, whatever the speed of the program
+    void display_vm_state(const stackinterpreter::vm_state &state) noexcept;
 };
 #endif // MAINWINDOW_H
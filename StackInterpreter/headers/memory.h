@@ -9,20 +9,24 @@
 
 #include "qcontainerfwd.h"
 #include "QVector"
+#include "region.h"
+#include "trap.h"
 
 namespace stackinterpreter{
 
 class Stack; // Forward declaration (Used in member functions)
+class Interpreter; // Forward declaration (Runs programs directly over the memory buffer)
+class Jit; // Forward declaration (Native code reads and writes the memory buffer)
+class NativeCompiler; // Forward declaration (Compiled programs read and write the memory buffer)
 
-typedef struct mem_slot{
-    qsizetype  address;    /// --> Simulates the address of a Harvard architecture memory
-    int        value;     ///  --> Value wich will be inserted on the memory at the specified address
-    bool       occupied; ///   --> Flag to control if a slot is occuppied or not
+typedef struct memory_range{
+    qsizetype first; /// --> First slot of the range
+    qsizetype end;   /// --> Slot after the last one
 
     /// Constructors
-    mem_slot() : occupied(false){} // All slots are not occuppied by default
-    mem_slot(qsizetype _address, int _value, bool _occupied) : address(_address), value(_value), occupied(_occupied){}
-} mem_slot;
+    memory_range() : first(0), end(0){}
+    memory_range(qsizetype _first, qsizetype _end) : first(_first), end(_end){}
+} memory_range;
 
 class Memory{
 public:
@@ -31,8 +35,8 @@ public:
     Memory(const Memory &cpy);
     Memory& operator=(const Memory &rhs);
 
-    bool push_in(const mem_slot &slot, stackinterpreter::Stack &stack) noexcept;
-    bool pop_out(const mem_slot &slot, stackinterpreter::Stack &stack) noexcept;
+    [[nodiscard]] stackinterpreter::Trap push_in(qsizetype address, stackinterpreter::Stack &stack) noexcept;
+    [[nodiscard]] stackinterpreter::Trap pop_out(qsizetype address, int &value, stackinterpreter::Stack &stack) noexcept;
     [[nodiscard]] bool resize_memory(qsizetype new_size) noexcept;
     /// @brief Return the max size that the current memory supports
     /// @return max_mem_size
@@ -40,22 +44,41 @@ public:
     /// @brief Return the max possible size that the memory can fit
     /// @return max_possible_mem_size
     [[nodiscard]] qsizetype get_max_possible_mem_size() const noexcept { return max_possible_mem_size; } // Inline function
-    /// @brief Return a const reference to the memory log (Used to display de memory log in the UI)
-    /// @return mem_log
-    [[nodiscard]] const QVector<QString>& get_mem_log() const noexcept{ return mem_log; } // Inline function
-    /// @brief Clear the memory operations log
-    void clear_log() noexcept { mem_log.clear(); } // Inline function
-    /// @brief Clear the memory vector
-    void clear_memory() noexcept { mem.clear(); } // Inline function
+    static constexpr qsizetype max_possible_mem_size = qsizetype(1) << 30; /// Max possible size that the memory can fit
+    /// @brief Return if a memory slot is occupied or not (The address must be valid)
+    [[nodiscard]] bool is_occupied(qsizetype address) const noexcept { return (occupancy[address >> 6] >> (address & 63)) & 1; } // Inline function
+    /// @brief Return the value of a memory slot (Only meaningful if the slot is occupied)
+    [[nodiscard]] int value_at(qsizetype address) const noexcept { return values[address]; } // Inline function
+    [[nodiscard]] qsizetype occupied_count() const noexcept;
+    [[nodiscard]] qsizetype next_occupied(qsizetype from) const noexcept;
+    [[nodiscard]] qsizetype next_free(qsizetype from) const noexcept;
+    [[nodiscard]] qsizetype last_occupied() const noexcept;
+    /// @brief Free every memory slot
+    void clear_memory() noexcept { occupancy.fill_zero(); mark_all_dirty(); } // Inline function
+    static constexpr qsizetype dirty_block = 64; /// Slots covered by a dirty bit (The slots of an occupancy word)
+    void dirty_ranges(qsizetype from, qsizetype to, QVector<stackinterpreter::memory_range> &ranges) const;
+    /// @brief Forget the written slots (Called once their views were repainted)
+    void clear_dirty() noexcept { dirty.fill_zero(); } // Inline function
+    void mark_all_dirty() noexcept;
+
+    friend class Interpreter;
+    friend class Jit;
+    friend class NativeCompiler;
 
 protected:
-    QVector<mem_slot> mem; /// QVector used to simulate the Harvard architecture memory
-    QVector<QString> mem_log; /// QString vector used to store all the operations realized in the memory
-    qsizetype max_mem_size; /// Max size that the current memory supports
-    const qsizetype max_possible_mem_size = 10000; /// Max possible size that the memory can fit
-    /// @brief Return if a memory slot is occupied or not
-    /// @return occupied
-    [[nodiscard]] bool is_occupied(int address) const noexcept { return mem[address].occupied; } // Inline function
+    /// The memory is a flat array of values plus an occupancy bitset (Bit address & 63 of word address >> 6), both in
+    /// lazily committed regions: only the pages a program touches cost memory
+    stackinterpreter::Region<qint32> values;
+    stackinterpreter::Region<quint64> occupancy;
+    /// Slots written since the last clear_dirty(), one bit per dirty_block slots (Bit (address >> 6) & 63 of word
+    /// address >> 12): a store sets one bit, a view asks for the dirty ranges it shows instead of reading every slot
+    stackinterpreter::Region<quint64> dirty;
+    qsizetype max_mem_size; /// Max size that the current memory supports (Size of values)
+
+    void occupy(qsizetype address, int value) noexcept { values[address] = value; occupancy[address >> 6] |= quint64(1) << (address & 63); mark_dirty(address); } // Inline function
+    void release(qsizetype address) noexcept { occupancy[address >> 6] &= ~(quint64(1) << (address & 63)); mark_dirty(address); } // Inline function
+    void mark_dirty(qsizetype address) noexcept { dirty[address >> 12] |= quint64(1) << ((address >> 6) & 63); } // Inline function
+    [[nodiscard]] static qsizetype words(qsizetype size) noexcept { return (size + 63) >> 6; } // Inline function
 };
 
 } // namespace stackinterpreter
@@ -0,0 +1,45 @@
+/**
+ * @headerfile memory_inspector.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef MEMORY_INSPECTOR_H
+#define MEMORY_INSPECTOR_H
+
+#include "view_models.h"
+#include <QCheckBox>
+#include <QDialog>
+#include <QTableView>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Non modal window showing the memory slots as a grid (Model owned by the main window).
+ * @details Tells the model which slots are in the viewport every time it scrolls or is resized, a sync repaints no
+ *          other slot. The viewport is empty while the window is hidden.
+*/
+class MemoryInspector : public QDialog{
+    Q_OBJECT
+
+public:
+    MemoryInspector(stackinterpreter::MemoryModel *_model, QWidget *parent = nullptr);
+
+signals:
+    void visible_changed(qsizetype first, qsizetype count); /// Memory slots now in the viewport
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+    void update_visible();
+
+private:
+    stackinterpreter::MemoryModel *model; /// Not owned
+    QTableView *view;
+    QCheckBox *hex_box;
+};
+
+} // namespace stackinterpreter
+
+#endif // MEMORY_INSPECTOR_H
@@ -0,0 +1,64 @@
+/**
+ * @headerfile native_compiler.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef NATIVE_COMPILER_H
+#define NATIVE_COMPILER_H
+
+#include "instruction_handler.h" // io_buffers, run_result
+#include "program.h"
+#include "stack.h"
+
+namespace stackinterpreter{
+
+/**
+ * @brief Compile-and-load runner: generates C from a program, builds it into a shared object with the system compiler
+ *        and calls it in-process (Linux/macOS builds only).
+ * @details The shared objects are cached on disk, named after a hash of the program bytecode, so running the same
+ *          program again only loads it. The native code runs directly over the stack, return stack and memory buffers
+ *          of the Stack (Passed in a context), INPUT and PRINT call back into the io_buffers. Same semantics, traps,
+ *          executed counts and resume offsets as Interpreter::run, the stack checks are always on.
+ *          The compiler is $STACKINTERPRETER_CC (Default cc).
+*/
+class NativeCompiler{
+public:
+    explicit NativeCompiler(const Program &program, const QString &_cache_directory = default_cache_directory());
+    ~NativeCompiler();
+    NativeCompiler(const NativeCompiler &cpy) = delete;
+    NativeCompiler& operator=(const NativeCompiler &rhs) = delete;
+
+    [[nodiscard]] stackinterpreter::run_result run(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept;
+    /// @brief Return true if the shared object was loaded (See get_failure() otherwise)
+    [[nodiscard]] bool is_loaded() const noexcept { return entry != nullptr; } // Inline function
+    /// @brief Return true if the shared object was found in the cache (Loaded without compiling)
+    [[nodiscard]] bool is_cached() const noexcept { return cache_hit; } // Inline function
+    /// @brief Return the number of instructions of the loaded program
+    [[nodiscard]] qsizetype size() const noexcept { return program_size; } // Inline function
+    /// @brief Return the path of the shared object
+    [[nodiscard]] const QString& get_object_path() const noexcept { return object_path; } // Inline function
+    /// @brief Return why the program could not be compiled or loaded (Empty if it was loaded)
+    [[nodiscard]] const QString& get_failure() const noexcept { return failure; } // Inline function
+    /// @brief Return true if this build can load shared objects
+    [[nodiscard]] static bool supported() noexcept;
+    [[nodiscard]] static QString default_cache_directory();
+    [[nodiscard]] static QString program_hash(const QVector<stackinterpreter::bytecode_cell> &code);
+
+private:
+    typedef void (*native_entry)(void *context);
+
+    native_entry entry = nullptr; /// Runs the program from the offset stored in the context
+    void *library = nullptr; /// dlopen handle
+    qsizetype program_size;
+    QString cache_directory;
+    QString object_path;
+    QString failure;
+    bool cache_hit = false;
+
+    [[nodiscard]] bool generate(const QVector<stackinterpreter::bytecode_cell> &code, const QString &source_path);
+    [[nodiscard]] bool compile(const QString &source_path, const QString &output_path);
+    [[nodiscard]] bool load(const QString &path);
+};
+
+} // namespace stackinterpreter
+
+#endif // NATIVE_COMPILER_H
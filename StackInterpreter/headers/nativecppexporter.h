@@ -0,0 +1,73 @@
+#ifndef NATIVECPPEXPORTER_H
+#define NATIVECPPEXPORTER_H
+
+#include "exporter.h"
+#include "stack.h"
+#include "buffered_writer.h"
+#include "QHash"
+
+namespace stackinterpreter{
+
+/**
+ * @brief C++ export backend generating code the host compiler can optimize (Stack slots are local variables).
+ * @details The stack depth before every instruction is simulated at export time, so every stack slot becomes a local
+ *          variable (s0, s1...) and every instruction a plain assignment, the memory is a flat array. Subroutines are
+ *          inlined at every CALL, so RET is a jump to a known label. Stack overflow/underflow, invalid addresses and
+ *          call stack overflow/underflow are resolved at export time, empty memory slots, division by zero and missing
+ *          input values are checked at run time. A trap prints "trap at pc N: message" on stderr and exits with 1.
+ *          Programs where an instruction is reached with different stack depths, or with recursive subroutines,
+ *          can not be exported (See get_failure()).
+*/
+class NativeCPPExporter : public Exporter{
+public:
+    explicit NativeCPPExporter(const char *_filename, const stackinterpreter::Stack &stack);
+    NativeCPPExporter(const NativeCPPExporter &cpy) = delete;
+    NativeCPPExporter& operator=(const NativeCPPExporter &rhs) = delete;
+
+    [[nodiscard]] bool export_to_file(const QVector<stackinterpreter::bytecode_cell> &code) const override;
+    /// @brief Return why the last export failed (Empty if it succeeded)
+    [[nodiscard]] const QString& get_failure() const noexcept { return failure; } // Inline function
+
+private:
+    typedef struct routine_instance{
+        qsizetype               entry;        /// --> Offset of the first instruction (0 for the main program)
+        qint32                  nesting;      /// --> Pending CALL instructions when the instance runs
+        qint32                  return_depth; /// --> Stack depth at RET (-1 if the routine never returns)
+        QHash<qsizetype, qint32> depth_at;    /// --> Stack depth before every reached instruction
+        QVector<qsizetype>      reached;      /// --> Reached offsets (Sorted once the instance is analyzed)
+        QHash<qsizetype, bool>  labels;       /// --> Offsets targeted by a jump
+        QHash<qsizetype, qsizetype> callees;  /// --> CALL offset --> inlined instance
+
+        /// Constructors
+        routine_instance() : entry(0), nesting(0), return_depth(-1){}
+        routine_instance(qsizetype _entry, qint32 _nesting) : entry(_entry), nesting(_nesting), return_depth(-1){}
+    } routine_instance;
+
+    typedef struct export_state{
+        const QVector<stackinterpreter::bytecode_cell> *code;
+        QVector<routine_instance>                       instances;
+        QVector<qsizetype>                              call_chain; /// --> Entries of the routines being analyzed
+        qsizetype                                       cells = 0;  /// --> Instructions emitted (All the instances)
+        qint32                                          max_depth = 0; /// --> Stack slots used
+        bool                                            halts = false; /// --> The halt label is used
+        bool                                            uses_memory = false; /// --> A PUSH or POP may execute
+    } export_state;
+
+    /// Max number of instructions emitted once every subroutine is inlined
+    static constexpr qsizetype max_cells = 1 << 22;
+
+    QString filename;
+    qsizetype stack_size;
+    qsizetype memory_size;
+    qsizetype call_depth;
+    mutable QString failure;
+
+    [[nodiscard]] bool analyze(export_state &state, qsizetype id, qint32 entry_depth) const;
+    void emit_instance(const export_state &state, qsizetype id, stackinterpreter::BufferedWriter &out) const;
+    [[nodiscard]] stackinterpreter::Trap static_trap(const stackinterpreter::bytecode_cell &cell, qint32 depth, qint32 nesting, qsizetype size) const noexcept;
+    [[nodiscard]] bool fail(const QString &reason) const;
+};
+
+} // namespace stackinterpreter
+
+#endif // NATIVECPPEXPORTER_H
@@ -0,0 +1,61 @@
+/**
+ * @headerfile optimizer.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "program.h"
+#include "QVector"
+
+namespace stackinterpreter{
+
+/**
+ * @brief Load time optimization pass over assembled programs.
+ * @details Folds constant expressions (PUSHI and DUP/SWAP/DROP/ADD/SUB/MUL/DIV/JZ/JNZ over immediates) inside every basic
+ *          block, removes the code unreachable from pc 0 and, when the memory size is known, turns stores to addresses
+ *          no POP ever reads into DROP. Branch targets, labels and source lines are remapped to the optimized program.
+ *          Divisions by zero are never folded, so they still trap at run time (INT_MIN / -1 folds to INT_MIN, its
+ *          result on every backend). Folding lowers the peak depth of a block, so a program that overflowed a too small
+ *          stack on an intermediate value may run to completion once optimized, it never traps where the original
+ *          program did not.
+*/
+class Optimizer{
+public:
+    explicit Optimizer(){}
+    Optimizer(const Optimizer &cpy) = delete;
+    Optimizer& operator=(const Optimizer &rhs) = delete;
+
+    qsizetype optimize(const Program &program, Program &optimized, qsizetype memory_size = 0) noexcept;
+
+    /// @brief Return the number of instructions removed by the last optimize call
+    [[nodiscard]] qsizetype get_eliminated() const noexcept { return folded + unreachable; } // Inline function
+    /// @brief Return the number of instructions removed by constant folding
+    [[nodiscard]] qsizetype get_folded() const noexcept { return folded; } // Inline function
+    /// @brief Return the number of unreachable instructions removed
+    [[nodiscard]] qsizetype get_unreachable() const noexcept { return unreachable; } // Inline function
+    /// @brief Return the number of stores to addresses never read (Replaced by DROP, or folded away)
+    [[nodiscard]] qsizetype get_dead_stores() const noexcept { return dead_stores; } // Inline function
+
+private:
+    typedef struct optimized_cell{
+        bytecode_cell cell;
+        int line; /// --> Source line of the original instruction
+
+        /// Constructors
+        optimized_cell() : line(0){}
+        optimized_cell(qint32 opcode, qint32 operand, int _line) : cell(opcode, operand), line(_line){}
+    } optimized_cell;
+
+    qsizetype folded = 0;
+    qsizetype unreachable = 0;
+    qsizetype dead_stores = 0;
+
+    void fold(const Program &program, qsizetype memory_size, QVector<optimized_cell> &out, QVector<qsizetype> &map) noexcept;
+    void remove_unreachable(QVector<optimized_cell> &code, QVector<qsizetype> &map) noexcept;
+    [[nodiscard]] static bool fold_arithmetic(qint32 opcode, qint32 lhs, qint32 rhs, qint32 &result) noexcept;
+};
+
+} // namespace stackinterpreter
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,90 @@
+/**
+ * @headerfile output_sink.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <QString>
+#include "QVector"
+#include <cstdio>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Where the values written by PRINT go.
+ * @details The run loops append the printed values to the io_buffers, which hand them to their sink in batches of
+ *          io_buffers::output_threshold values (io_buffers::drain_output()). A sink may buffer them further, flush()
+ *          makes everything written so far visible (Called by the client when a run stops, EX: at HLT).
+*/
+class OutputSink{
+public:
+    virtual ~OutputSink(){}
+
+    virtual void write(const int *values, qsizetype count) = 0;
+    /// @brief Make the values written so far visible, return false if they could not be written
+    virtual bool flush(){ return true; }
+};
+
+/**
+ * @brief Keeps every value in memory.
+*/
+class BufferOutputSink : public OutputSink{
+public:
+    void write(const int *printed, qsizetype count) override;
+
+    [[nodiscard]] const QVector<int>& get_values() const noexcept { return values; } // Inline function
+    void clear() noexcept { values.clear(); } // Inline function
+
+private:
+    QVector<int> values;
+};
+
+/**
+ * @brief Writes one decimal value per line to a stream through a buffer of write_size bytes.
+ * @details The values are formatted without any locale handling and the stream is only written when the buffer is
+ *          full or flushed. Errors are sticky: is_good() reports them and nothing is written after a failure.
+*/
+class TextOutputSink : public OutputSink{
+public:
+    static constexpr qsizetype write_size = 1 << 16;
+
+    explicit TextOutputSink(std::FILE *_file, bool _owned = false);
+    ~TextOutputSink() override;
+    TextOutputSink(const TextOutputSink &cpy) = delete;
+    TextOutputSink& operator=(const TextOutputSink &rhs) = delete;
+
+    void write(const int *values, qsizetype count) override;
+    bool flush() override;
+    /// @brief Return true if the stream could be opened and no write failed
+    [[nodiscard]] bool is_good() const noexcept { return file != nullptr && !failed; } // Inline function
+
+private:
+    std::FILE *file;
+    bool owned; /// Closed by the destructor
+    QVector<char> buffer;
+    qsizetype used = 0;
+    bool failed = false;
+
+    void write_buffer() noexcept;
+};
+
+/**
+ * @brief Decimal values written to stdout.
+*/
+class StdoutOutputSink : public TextOutputSink{
+public:
+    StdoutOutputSink() : TextOutputSink(stdout){}
+};
+
+/**
+ * @brief Decimal values written to a text file (Truncated when opened).
+*/
+class TextFileOutputSink : public TextOutputSink{
+public:
+    explicit TextFileOutputSink(const QString &filename);
+};
+
+} // namespace stackinterpreter
+
+#endif // OUTPUT_SINK_H
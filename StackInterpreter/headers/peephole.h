@@ -0,0 +1,33 @@
+/**
+ * @headerfile peephole.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include "program.h"
+#include "superinstructions.h"
+
+namespace stackinterpreter{
+
+/**
+ * @brief Bytecode rewriting pass fusing the pairs of the superinstruction table.
+ * @details A pair is fused in place: the first cell gets the superinstruction opcode and the second cell is kept untouched,
+ *          so branch targets, trap offsets and resume offsets are the same as in the original program and a branch
+ *          landing on the second instruction still executes it alone. Superinstructions run both original handlers
+ *          (Same traps, same memory effects), only the dispatch in between is removed.
+*/
+class PeepholeOptimizer{
+public:
+    explicit PeepholeOptimizer(){}
+    PeepholeOptimizer(const PeepholeOptimizer &cpy) = delete;
+    PeepholeOptimizer& operator=(const PeepholeOptimizer &rhs) = delete;
+
+    qsizetype optimize(QVector<bytecode_cell> &code) noexcept;
+    [[nodiscard]] static qint32 fuse(qint32 first, qint32 second) noexcept;
+    [[nodiscard]] static qint32 split(qint32 opcode) noexcept;
+};
+
+} // namespace stackinterpreter
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,117 @@
+/**
+ * @headerfile profiler.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "program.h"
+#include "QVector"
+#include <QString>
+#include <QStringList>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace stackinterpreter{
+
+/**
+ * @brief Execution profile of the runs of an Interpreter (Interpreter::set_profile), one counter per bytecode offset.
+ * @details A block is the run of instructions between two taken branches (Or the start and the end of a run), it is
+ *          named after the offset it was entered at. Timed profiles also add the cycles spent in every block (rdtsc
+ *          on x86, steady clock nanoseconds elsewhere), read once per taken branch.
+*/
+class Profile{
+public:
+    explicit Profile(bool _timed = false) : timed(_timed){}
+
+    void reset(qsizetype cells);
+    [[nodiscard]] QString report(const stackinterpreter::Program &program, const QStringList &source = QStringList(), qsizetype top = 20) const;
+    /// @brief Return true if the cycles spent in the blocks are recorded
+    [[nodiscard]] bool is_timed() const noexcept { return timed; } // Inline function
+    /// @brief Return the number of instructions executed at every offset
+    [[nodiscard]] const QVector<quint64>& get_counts() const noexcept { return counts; } // Inline function
+    [[nodiscard]] quint64 get_executed() const noexcept;
+
+    /// @brief Return a cycle counter (rdtsc on x86, steady clock nanoseconds elsewhere)
+    [[nodiscard]] static quint64 read_cycles() noexcept{ // Inline function
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<quint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+private:
+    template<bool Timed>
+    friend class Profiling;
+
+    bool timed;
+    QVector<quint64> counts;             /// Instructions executed at the offset
+    QVector<quint64> branches;           /// Branches taken by the instruction at the offset
+    QVector<quint64> block_entries;      /// Blocks entered at the offset
+    QVector<quint64> block_instructions; /// Instructions executed in the blocks entered at the offset
+    QVector<quint64> block_cycles;       /// Cycles spent in the blocks entered at the offset (Timed profiles)
+};
+
+/**
+ * @brief Run loop policy of the runs without a profile, every hook is empty so the profiling code compiles out.
+*/
+struct NoProfiling{
+    NoProfiling(stackinterpreter::Profile*, qsizetype) noexcept {}
+    void executed(qsizetype, qsizetype) noexcept {} // Inline function
+    void branch(qsizetype, qsizetype) noexcept {}   // Inline function
+    void stop() noexcept {}                         // Inline function
+};
+
+/**
+ * @brief Run loop policy filling a Profile, Timed = true also reads the cycle counter once per taken branch.
+ * @details The hooks are called where the run loop already counts its executed instructions (Once per dispatch, a
+ *          superinstruction counts both of its offsets).
+*/
+template<bool Timed>
+class Profiling{
+public:
+    Profiling(stackinterpreter::Profile *profile, qsizetype pc) noexcept :
+        counts(profile->counts.data()), branches(profile->branches.data()), entries(profile->block_entries.data()),
+        instructions(profile->block_instructions.data()), cycles(profile->block_cycles.data()), block(pc), start(Timed ? Profile::read_cycles() : 0){
+        ++entries[pc];
+    }
+
+    /// @brief count instructions were executed from pc
+    void executed(qsizetype pc, qsizetype count) noexcept{ // Inline function
+        for(qsizetype i = 0; i < count; ++i)
+            ++counts[pc + i];
+        in_block += static_cast<quint64>(count);
+    }
+    /// @brief The instruction at pc branched to target, a new block starts there
+    void branch(qsizetype pc, qsizetype target) noexcept{ // Inline function
+        ++branches[pc];
+        leave();
+        block = target;
+        ++entries[target];
+    }
+    /// @brief The run stopped, the current block ends
+    void stop() noexcept { leave(); } // Inline function
+
+private:
+    quint64 *const counts, *const branches, *const entries, *const instructions, *const cycles;
+    qsizetype block;     /// Offset the current block was entered at
+    quint64 start;       /// Cycle counter when it was entered
+    quint64 in_block = 0;
+
+    void leave() noexcept{ // Inline function
+        instructions[block] += in_block;
+        in_block = 0;
+        if(Timed){
+            const quint64 now = Profile::read_cycles();
+            cycles[block] += now - start;
+            start = now;
+        }
+    }
+};
+
+} // namespace stackinterpreter
+
+#endif // PROFILER_H
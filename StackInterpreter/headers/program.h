@@ -0,0 +1,55 @@
+/**
+ * @headerfile program.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include "instructions.h"
+#include "QVector"
+#include "QHash"
+#include <QString>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Fixed size cell of the packed bytecode, the operand is already decoded (No string parsing when executed).
+*/
+typedef struct bytecode_cell{
+    qint32 opcode;  /// --> Instructions enum value
+    qint32 operand; /// --> Immediate value (PUSHI), memory address (PUSH/POP) or absolute branch target (JMP/JZ/JNZ/CALL), 0 when not used
+
+    /// Constructors
+    bytecode_cell() : opcode(stackinterpreter::Instructions::HLT), operand(0){}
+    bytecode_cell(qint32 _opcode, qint32 _operand) : opcode(_opcode), operand(_operand){}
+} bytecode_cell;
+
+static_assert(sizeof(bytecode_cell) == 8, "bytecode_cell must stay packed in 8 bytes");
+
+class Program{
+public:
+    Program(){}
+
+    void append(qint32 opcode, qint32 operand, int line) noexcept;
+    void add_label(const QString &label, qsizetype offset) noexcept { labels.insert(label, offset); } /// Inline function
+    void patch_operand(qsizetype pc, qint32 operand) noexcept { code[pc].operand = operand; } /// Inline function
+    void clear() noexcept;
+
+    /// @brief Return the contiguous bytecode array
+    [[nodiscard]] const QVector<bytecode_cell>& get_code() const noexcept { return code; } // Inline function
+    /// @brief Return the number of cells of the program
+    [[nodiscard]] qsizetype size() const noexcept { return code.size(); } // Inline function
+    /// @brief Return the source line of the cell at the given offset (0 if unknown)
+    [[nodiscard]] int line_of(qsizetype pc) const noexcept { return pc >= 0 && pc < lines.size() ? lines[pc] : 0; } // Inline function
+    /// @brief Return the labels declared in the source and the offsets they point to
+    [[nodiscard]] const QHash<QString, qsizetype>& get_labels() const noexcept { return labels; } // Inline function
+
+private:
+    QVector<bytecode_cell> code; /// Packed bytecode
+    QVector<int> lines; /// Source line of every cell (Used to report errors/profiles back to the source)
+    QHash<QString, qsizetype> labels; /// Label name --> bytecode offset
+};
+
+} // namespace stackinterpreter
+
+#endif // PROGRAM_H
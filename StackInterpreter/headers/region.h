@@ -0,0 +1,88 @@
+/**
+ * @headerfile region.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef REGION_H
+#define REGION_H
+
+#include <QtGlobal>
+#include <cstring>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Page level helpers of Region: anonymous mappings followed by an inaccessible guard page.
+ * @details The pages are reserved, not committed (MAP_NORESERVE), the system only commits a page when it is first
+ *          touched. Builds without mmap fall back to the heap (No guard page).
+*/
+class Mapping{
+public:
+    [[nodiscard]] static void* map(qsizetype bytes) noexcept;
+    [[nodiscard]] static void* remap(void *address, qsizetype old_bytes, qsizetype new_bytes) noexcept;
+    static void unmap(void *address, qsizetype bytes) noexcept;
+    [[nodiscard]] static bool map_file(void *address, qsizetype bytes, int fd, qint64 offset) noexcept;
+    [[nodiscard]] static qsizetype page_size() noexcept;
+    [[nodiscard]] static qsizetype round_up(qsizetype bytes) noexcept { return (bytes + page_size() - 1) & ~(page_size() - 1); } // Inline function
+};
+
+/**
+ * @brief Contiguous array of T in its own lazily committed mapping (Storage of the stack and of the memory).
+ * @details A huge region costs address space only, pages are committed as the program touches them. The element
+ *          after the last page of the region is an inaccessible guard page, so running past the end faults instead of
+ *          overwriting another allocation. New elements are always zero.
+*/
+template<typename T>
+class Region{
+public:
+    Region() noexcept{}
+    explicit Region(qsizetype _size) noexcept { static_cast<void>(resize(_size)); }
+    Region(const Region &cpy) noexcept : Region(cpy.count){ if(base) std::memcpy(base, cpy.base, static_cast<size_t>(cpy.count) * sizeof(T)); }
+    Region& operator=(const Region &rhs) noexcept{
+        if(this != &rhs && resize(rhs.count) && base)
+            std::memcpy(base, rhs.base, static_cast<size_t>(count) * sizeof(T));
+        return *this;
+    }
+    ~Region(){ Mapping::unmap(base, count * static_cast<qsizetype>(sizeof(T))); }
+
+    /// @brief Grow or shrink the region keeping its first elements (The mapping may move), false if it could not be mapped
+    [[nodiscard]] bool resize(qsizetype new_size) noexcept{
+        if(new_size == count)
+            return true;
+        if(new_size <= 0){
+            Mapping::unmap(base, count * static_cast<qsizetype>(sizeof(T)));
+            base = nullptr;
+            count = 0;
+            return new_size == 0;
+        }
+        const qsizetype old_bytes = count * static_cast<qsizetype>(sizeof(T)), new_bytes = new_size * static_cast<qsizetype>(sizeof(T));
+        void *mapped = base ? Mapping::remap(base, old_bytes, new_bytes) : Mapping::map(new_bytes);
+        if(!mapped)
+            return false;
+        base = static_cast<T*>(mapped);
+        if(new_bytes > old_bytes) // The tail of the old last page may hold elements dropped by a previous shrink
+            std::memset(reinterpret_cast<char*>(base) + old_bytes, 0, static_cast<size_t>(qMin(new_bytes, Mapping::round_up(old_bytes)) - old_bytes));
+        count = new_size;
+        return true;
+    }
+    /// @brief Replace the first elements with a copy-on-write mapping of a file (Nothing is read until it is touched)
+    /// @details offset must be page aligned and every mapped page must hold part of the file, false if it could not be mapped
+    [[nodiscard]] bool map_file(int fd, qint64 offset, qsizetype elements) noexcept{ // Inline function
+        return elements >= 0 && elements <= count && (!elements || Mapping::map_file(base, elements * static_cast<qsizetype>(sizeof(T)), fd, offset));
+    }
+    /// @brief Set every element to zero
+    void fill_zero() noexcept { if(base) std::memset(base, 0, static_cast<size_t>(count) * sizeof(T)); } // Inline function
+
+    [[nodiscard]] T* data() noexcept { return base; } // Inline function
+    [[nodiscard]] const T* constData() const noexcept { return base; } // Inline function
+    [[nodiscard]] qsizetype size() const noexcept { return count; } // Inline function
+    T& operator[](qsizetype index) noexcept { return base[index]; } // Inline function
+    const T& operator[](qsizetype index) const noexcept { return base[index]; } // Inline function
+
+private:
+    T *base = nullptr;
+    qsizetype count = 0;
+};
+
+} // namespace stackinterpreter
+
+#endif // REGION_H
@@ -0,0 +1,44 @@
+/**
+ * @headerfile snapshot.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <QtGlobal>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Header of a VM image file written by Stack::save_snapshot (Host byte order).
+ * @details The header is followed by the return stack (return_depth qint64 addresses), then by three sections, each
+ *          starting at a multiple of snapshot_alignment so it can be mapped straight into a region: the stack slots
+ *          (depth + 1 qint32, slot 0 is the scratch slot), the memory values (stored_values qint32) and the occupancy
+ *          words (quint64 covering stored_values slots). The memory past stored_values is free. Every section is zero
+ *          padded up to the next multiple of snapshot_alignment, the file included.
+*/
+typedef struct snapshot_header{
+    char    magic[8];         /// --> snapshot_magic
+    quint32 version;          /// --> snapshot_version
+    quint32 byte_order;       /// --> snapshot_byte_order written in host order (Refused if it reads differently)
+    qint64  pc;               /// --> Offset of the next instruction to run
+    qint64  max_size;         /// --> Max size of the stack
+    qint64  depth;            /// --> Number of values in the stack
+    qint64  return_depth;     /// --> Number of return addresses (Nested CALL instructions)
+    qint64  max_mem_size;     /// --> Size of the memory
+    qint64  stored_values;    /// --> Number of memory slots in the image (Last occupied address + 1)
+    qint64  stack_offset;     /// --> Offset of the stack slots in the file
+    qint64  values_offset;    /// --> Offset of the memory values in the file
+    qint64  occupancy_offset; /// --> Offset of the occupancy words in the file
+} snapshot_header;
+
+static_assert(sizeof(snapshot_header) == 88, "snapshot_header must stay a packed POD");
+
+constexpr char snapshot_magic[8] = {'S', 'T', 'K', 'I', 'M', 'A', 'G', 'E'};
+constexpr quint32 snapshot_version = 1;
+constexpr quint32 snapshot_byte_order = 0x01020304;
+constexpr qint64 snapshot_alignment = qint64(1) << 16; /// Multiple of every page size, the sections are mapped directly
+
+} // namespace stackinterpreter
+
+#endif // SNAPSHOT_H
@@ -7,63 +7,79 @@
 
 #pragma once
 
-#include "qtextedit.h"
 #include "memory.h"
-#include "qlineedit.h"
-#include "qwidget.h"
+#include "region.h"
+#include "trace.h"
+#include "trap.h"
 #include "QStack"
 #include <QString>
 
 namespace stackinterpreter{
 
 class Memory;
-
-namespace stackutil{
-
-QStack<int> prepare(QStack<int> &stack) noexcept;
-void log_write(const QString &instruction, QVector<QString> &log, const QString &value1  = "null", const QString &value2  = "null") noexcept;
-
-} // namespace stackutil
+class Interpreter; // Forward declaration (Runs programs directly over the stack buffer)
+class Jit; // Forward declaration (Native code reads and writes the stack buffer)
+class NativeCompiler; // Forward declaration (Compiled programs read and write the stack buffer)
 
 class Stack : public Memory{
 public:
     Stack() : Stack(16){} // Default max size = 16
     Stack(qsizetype _max_size);
-    Stack(const Stack &cpy) : stack(cpy.stack), max_size(cpy.max_size){}
+    Stack(const Stack &cpy) : buffer(cpy.buffer), depth(cpy.depth), return_stack(cpy.return_stack), max_size(cpy.max_size){}
     virtual ~Stack(){}
     Stack& operator=(const Stack &rhs);
 
-    friend void operator<<(QLineEdit &os, const Stack &stack);
-    friend QStack<int> stackutil::prepare(QStack<int> &stack) noexcept;
-
-    void PUSHI(int value) noexcept;
-    void PUSHI(int value, const QString &description, QVector<QString> &log) noexcept;
-    void PUSH(int hex, const QString &description, QVector<QString> &log) noexcept;
-    void POP(int hex, const QString &description, QVector<QString> &log) noexcept;
-    void INPUT(QWidget* parent, const QString &description, QVector<QString> &log) noexcept;
-    void PRINT(QWidget *parent, const QString &description, QVector<QString> &log) noexcept;
-    void ADD(const QString &description, QVector<QString> &log) noexcept;
-    void SUB(const QString &description, QVector<QString> &log) noexcept;
-    void MUL(const QString &description, QVector<QString> &log) noexcept;
-    void DIV(const QString &description, QVector<QString> &log) noexcept;
-    void SWAP(const QString &description, QVector<QString> &log) noexcept;
+    friend class Interpreter;
+    friend class Jit;
+    friend class NativeCompiler;
+
+    /// Every instruction returns Trap::NONE on success, the client is responsible for reporting any other trap
+    Trap PUSHI(int value) noexcept;
+    Trap PUSHI(int value, stackinterpreter::Trace &trace) noexcept;
+    Trap PUSH(int hex, stackinterpreter::Trace &trace) noexcept;
+    Trap POP(int hex, stackinterpreter::Trace &trace) noexcept;
+    Trap INPUT(int value, stackinterpreter::Trace &trace) noexcept;
+    Trap INPUTN(const int *values, qsizetype count, stackinterpreter::Trace &trace) noexcept;
+    Trap PRINT(int &value, stackinterpreter::Trace &trace) noexcept;
+    Trap ADD(stackinterpreter::Trace &trace) noexcept;
+    Trap SUB(stackinterpreter::Trace &trace) noexcept;
+    Trap MUL(stackinterpreter::Trace &trace) noexcept;
+    Trap DIV(stackinterpreter::Trace &trace) noexcept;
+    Trap SWAP(stackinterpreter::Trace &trace) noexcept;
     int DROP() noexcept;
-    int DROP(const QString &description, QVector<QString> &log) noexcept;
-    void DUP(const QString &description, QVector<QString> &log) noexcept;
-    void HLT(const QString &description, QVector<QString> &log) noexcept;
+    Trap DROP(stackinterpreter::Trace &trace) noexcept;
+    Trap DUP(stackinterpreter::Trace &trace) noexcept;
+    Trap HLT(stackinterpreter::Trace &trace) noexcept;
+    /// Control flow, the caller owns the program counter (The branch targets are resolved by the assembler)
+    Trap JZ(bool &taken, stackinterpreter::Trace &trace) noexcept;
+    Trap JNZ(bool &taken, stackinterpreter::Trace &trace) noexcept;
+    Trap CALL(qsizetype return_address, stackinterpreter::Trace &trace) noexcept;
+    Trap RET(qsizetype &return_address, stackinterpreter::Trace &trace) noexcept;
 
     [[nodiscard]] bool resize_stack(qsizetype new_size) noexcept;
-    [[nodiscard]] const QStack<int>& get_stack() const noexcept{ return stack; } /// Inline function
+    [[nodiscard]] bool save_snapshot(const QString &filename, qsizetype pc) const;
+    [[nodiscard]] bool load_snapshot(const QString &filename, qsizetype program_size, qsizetype &pc);
+    /// @brief Return the values of the stack, from the bottom (index 0) to the top (index get_size() - 1)
+    [[nodiscard]] const int* get_data() const noexcept{ return buffer.constData() + 1; } /// Inline function
+    [[nodiscard]] qsizetype get_size() const noexcept{ return depth; } /// Inline function
     [[nodiscard]] qsizetype get_max_size() const noexcept{ return max_size; } /// Inline function
     [[nodiscard]] qsizetype get_max_possible_size() const noexcept{ return max_possible_size; } /// Inline function
+    static constexpr qsizetype max_possible_size = qsizetype(1) << 30;
+    [[nodiscard]] const QStack<qsizetype>& get_return_stack() const noexcept{ return return_stack; } /// Inline function
+    [[nodiscard]] qsizetype get_max_call_depth() const noexcept{ return max_call_depth; } /// Inline function
 
-    void clear_stack() noexcept{ stack.clear(); } /// Inline function
-    void display_memory_log(QTextEdit &os) const noexcept;
+    void clear_stack() noexcept{ depth = 0; } /// Inline function
 
 private:
-    QStack<int> stack;
+    stackinterpreter::Region<int> buffer; /// Lazily committed storage of max_size + 1 slots (Slot 0 is a scratch slot for the Interpreter top of stack register)
+    qsizetype depth; /// Number of values in the stack (The top is buffer[depth])
+    QStack<qsizetype> return_stack; /// Return addresses pushed by CALL (Separated from the data stack)
     qsizetype max_size;
-    const qsizetype max_possible_size = 10000;
+    const qsizetype max_call_depth = 1024; /// Max number of nested CALL instructions
+
+    void push_value(int value) noexcept{ buffer[++depth] = value; } /// Inline function
+    int pop_value() noexcept{ return buffer[depth--]; } /// Inline function
+    int& top_value() noexcept{ return buffer[depth]; } /// Inline function
 
 };
 
@@ -0,0 +1,49 @@
+/**
+ * @headerfile superinstructions.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef SUPERINSTRUCTIONS_H
+#define SUPERINSTRUCTIONS_H
+
+#include "instructions.h"
+
+/**
+ * @brief Superinstruction table: X(name, first, second) fuses the instruction pair "first; second" in a single dispatch.
+ * @details The Interpreter generates the handler of every entry from the handlers of both instructions, so the table can
+ *          be regenerated from the hot pairs reported by "StackInterpreterCLI --pairs" without touching the run loop.
+ *          The first instruction must not transfer control (JMP, JZ, JNZ, CALL, RET, HLT).
+*/
+#define STACKINTERPRETER_SUPERINSTRUCTIONS(X) \
+    X(ADDI,      PUSHI, ADD)                  \
+    X(SUBI,      PUSHI, SUB)                  \
+    X(MULI,      PUSHI, MUL)                  \
+    X(DIVI,      PUSHI, DIV)                  \
+    X(PUSHI2,    PUSHI, PUSHI)                \
+    X(SQUARE,    DUP,   MUL)                  \
+    X(RSUB,      SWAP,  SUB)                  \
+    X(DUP_JNZ,   DUP,   JNZ)                  \
+    X(DUP_JZ,    DUP,   JZ)                   \
+    X(DUP_PUSH,  DUP,   PUSH)                 \
+    X(STORE_LOAD, PUSH, POP)                  \
+    X(DUP_DROP,  DUP,   DROP)                 \
+    X(SWAP_SWAP, SWAP,  SWAP)
+
+namespace stackinterpreter{
+
+/**
+ * @namespace stackinterpreter
+ * @enum
+ * @brief Internal opcodes of the Interpreter (Never produced by the assembler).
+*/
+enum InternalInstructions{
+    END_OF_PROGRAM = Instructions::ERROR + 1, /// Sentinel after the last instruction, halts without clearing the stack
+    BREAKPOINT, /// Patched over the opcode of a breakpoint cell (Interpreter::set_breakpoint), stops with Trap::BREAKPOINT
+#define STACKINTERPRETER_SUPERINSTRUCTION_ENUM(name, first, second) name,
+    STACKINTERPRETER_SUPERINSTRUCTIONS(STACKINTERPRETER_SUPERINSTRUCTION_ENUM)
+#undef STACKINTERPRETER_SUPERINSTRUCTION_ENUM
+    INTERNAL_INSTRUCTIONS_END
+};
+
+} // namespace stackinterpreter
+
+#endif // SUPERINSTRUCTIONS_H
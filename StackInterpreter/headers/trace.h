@@ -0,0 +1,76 @@
+/**
+ * @headerfile trace.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "instructions.h"
+#include "program.h" // bytecode_cell
+#include "QVector"
+#include <QString>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Binary record of an executed instruction (Formatted as text only when a view or an exporter asks for it).
+*/
+typedef struct trace_entry{
+    qint32 pc;      /// --> Offset of the instruction (-1 when executed outside a program, EX: GUI single step)
+    qint32 opcode;  /// --> Instructions enum value
+    qint32 operand; /// --> Immediate value, memory address or branch target
+    qint32 value1;  /// --> First value popped (Top of the stack)
+    qint32 value2;  /// --> Second value popped
+    qint32 result;  /// --> Value pushed (Value read by INPUT/POP, return address of CALL/RET)
+} trace_entry;
+
+static_assert(sizeof(trace_entry) == 24, "trace_entry must stay a packed POD");
+
+/**
+ * @brief Fixed depth ring buffer of trace entries, replaces the QString instruction and memory logs.
+ * @details Recording an instruction is a single POD store, the oldest entries are overwritten once the trace is full.
+ *          The depth is rounded up to a power of two (Default 65536 entries).
+*/
+class Trace{
+public:
+    static constexpr qsizetype default_depth = 65536;
+
+    explicit Trace(qsizetype _depth = default_depth);
+
+    /// @brief Record an executed instruction (Hot path: no allocation, no formatting)
+    void record(qint32 opcode, qint32 operand, qint32 value1 = 0, qint32 value2 = 0, qint32 result = 0) noexcept{ // Inline function
+        entries[static_cast<qsizetype>(head & mask)] = trace_entry{pc, opcode, operand, value1, value2, result};
+        ++head;
+    }
+    /// @brief Set the offset stamped in the next entries (-1 outside a program)
+    void set_pc(qsizetype _pc) noexcept { pc = static_cast<qint32>(_pc); } // Inline function
+    /// @brief Remove every entry
+    void clear() noexcept { first = head; } // Inline function
+    void set_depth(qsizetype depth) noexcept;
+
+    /// @brief Return the number of entries held (At most get_depth())
+    [[nodiscard]] qsizetype size() const noexcept { return head - first < static_cast<quint64>(entries.size()) ? static_cast<qsizetype>(head - first) : entries.size(); } // Inline function
+    /// @brief Return the max number of entries held
+    [[nodiscard]] qsizetype get_depth() const noexcept { return entries.size(); } // Inline function
+    /// @brief Return the number of entries recorded since the last clear (Including the overwritten ones)
+    [[nodiscard]] quint64 get_recorded() const noexcept { return head - first; } // Inline function
+    /// @brief Return the number of entries recorded since the trace was created or resized (Not reset by clear(), entry at(i) is the number get_head() - size() + i)
+    [[nodiscard]] quint64 get_head() const noexcept { return head; } // Inline function
+    /// @brief Return the i-th entry held, 0 is the oldest one
+    [[nodiscard]] const trace_entry& at(qsizetype i) const noexcept { return entries[static_cast<qsizetype>((head - static_cast<quint64>(size()) + static_cast<quint64>(i)) & mask)]; } // Inline function
+
+    [[nodiscard]] static QString format_instruction(const trace_entry &entry);
+    [[nodiscard]] static QString format_memory(const trace_entry &entry);
+    [[nodiscard]] bool executed_code(QVector<stackinterpreter::bytecode_cell> &code) const;
+
+private:
+    QVector<trace_entry> entries;
+    quint64 head = 0;  /// Entries recorded, the next one is written at head & mask
+    quint64 first = 0; /// Head at the last clear
+    quint64 mask = 0;
+    qint32 pc = -1;
+};
+
+} // namespace stackinterpreter
+
+#endif // TRACE_H
@@ -0,0 +1,36 @@
+/**
+ * @headerfile trap.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef TRAP_H
+#define TRAP_H
+
+namespace stackinterpreter{
+
+/**
+ * @namespace stackinterpreter
+ * @enum
+ * @brief Status returned by every instruction of the interpreter core (NONE means the instruction executed successfully).
+ * @details The core never shows any dialog, the client (GUI, CLI...) decides how a trap is reported.
+*/
+enum class Trap{
+    NONE,
+    STACK_OVERFLOW,
+    STACK_UNDERFLOW,
+    DIVISION_BY_ZERO,
+    INVALID_ADDRESS,
+    EMPTY_MEMORY_SLOT,
+    INVALID_OPERAND,
+    INVALID_INSTRUCTION,
+    CALL_STACK_OVERFLOW,
+    CALL_STACK_UNDERFLOW,
+    WAITING_INPUT, /// Not an error, INPUT needs a value that was not supplied yet (The run can be resumed)
+    INTERRUPTED,   /// Not an error, the client asked the run to stop (The run can be resumed)
+    BREAKPOINT     /// Not an error, the run reached a breakpoint (Resuming executes the instruction of the breakpoint)
+};
+
+[[nodiscard]] const char* trap_message(Trap trap) noexcept;
+
+} // namespace stackinterpreter
+
+#endif // TRAP_H
@@ -0,0 +1,72 @@
+/**
+ * @headerfile verifier.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef VERIFIER_H
+#define VERIFIER_H
+
+#include "program.h"
+#include "QVector"
+#include "QHash"
+#include <QString>
+
+namespace stackinterpreter{
+
+/**
+ * @brief Load time stack depth verifier.
+ * @details Computes the stack depth (Relative to the depth at pc 0) before every instruction, following every branch and
+ *          summarizing every CALL target as a subroutine. A program is verified when the depth is the same on every path
+ *          reaching an instruction, every reached branch targets an offset of the program (Or its end), subroutines
+ *          are not recursive and return with a single depth, and RET is never executed outside a subroutine. Verified programs can run without the overflow/underflow checks as long as
+ *          the stack holds get_required_depth() values and has room for get_max_growth() more (Interpreter checks it).
+*/
+class Verifier{
+public:
+    /// Depth of an instruction never reached from pc 0 (Or only reached inside subroutines)
+    static constexpr qint32 UNKNOWN_DEPTH = -2147483647 - 1;
+
+    explicit Verifier(){}
+    Verifier(const Verifier &cpy) = delete;
+    Verifier& operator=(const Verifier &rhs) = delete;
+
+    [[nodiscard]] bool verify(const Program &program) noexcept;
+
+    /// @brief Return the number of values that must be in the stack when the program starts
+    [[nodiscard]] qint32 get_required_depth() const noexcept { return required_depth; } // Inline function
+    /// @brief Return the max number of values the program pushes above the depth it started with
+    [[nodiscard]] qint32 get_max_growth() const noexcept { return max_growth; } // Inline function
+    /// @brief Return the max number of nested CALL instructions
+    [[nodiscard]] qint32 get_max_call_nesting() const noexcept { return max_call_nesting; } // Inline function
+    /// @brief Return the depth (Relative to pc 0) before every instruction of the main program
+    [[nodiscard]] const QVector<qint32>& get_depths() const noexcept { return depths; } // Inline function
+    /// @brief Return the offset of the instruction wich failed the verification
+    [[nodiscard]] qsizetype get_failed_pc() const noexcept { return failed_pc; } // Inline function
+    /// @brief Return why the verification failed
+    [[nodiscard]] const QString& get_failure() const noexcept { return failure; } // Inline function
+
+private:
+    typedef struct routine_summary{
+        qint32 required;  /// --> Values needed in the stack at the routine entry
+        qint32 growth;    /// --> Max values pushed above the entry depth
+        qint32 net;       /// --> Depth change from the entry to RET
+        qint32 nesting;   /// --> Max nested CALL instructions (Including the routine itself)
+        bool   returns;   /// --> False if no RET is reachable (Halts or falls off the program)
+    } routine_summary;
+
+    const Program *program = nullptr;
+    QHash<qsizetype, routine_summary> summaries; /// Subroutine entry --> summary
+    QVector<qsizetype> call_chain; /// Subroutines being analyzed (Used to reject recursion)
+    QVector<qint32> depths;
+    qint32 required_depth = 0;
+    qint32 max_growth = 0;
+    qint32 max_call_nesting = 0;
+    qsizetype failed_pc = -1;
+    QString failure;
+
+    [[nodiscard]] bool analyze(qsizetype entry, bool subroutine, routine_summary &summary, QVector<qint32> &depth_at) noexcept;
+    [[nodiscard]] bool fail(qsizetype pc, const QString &reason) noexcept;
+};
+
+} // namespace stackinterpreter
+
+#endif // VERIFIER_H
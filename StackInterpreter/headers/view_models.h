@@ -0,0 +1,168 @@
+/**
+ * @headerfile view_models.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef VIEW_MODELS_H
+#define VIEW_MODELS_H
+
+#include "program.h"
+#include "stack.h"
+#include "trace.h"
+#include "vm_worker.h"
+#include <QAbstractListModel>
+#include <QAbstractTableModel>
+#include "QVector"
+
+namespace stackinterpreter{
+
+/// Item models used by the GUI to display the interpreter core state (The core itself has no QtWidgets dependency).
+/// A sync() only emits the rows inserted and removed since the previous one, the rows are formatted when a view paints them.
+
+/**
+ * @brief The values of the stack, from the bottom (Row 0) to the top.
+ * @details While a program runs on the worker, the model shows the top values published in its vm_state instead.
+*/
+class StackModel : public QAbstractListModel{
+    Q_OBJECT
+
+public:
+    explicit StackModel(const stackinterpreter::Stack &_stack, QObject *parent = nullptr) : QAbstractListModel(parent), stack(_stack){}
+
+    [[nodiscard]] int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    [[nodiscard]] QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    void sync();
+    void sync(const stackinterpreter::vm_state &state);
+
+private:
+    const stackinterpreter::Stack &stack; /// Not owned
+    QVector<int> published;               /// Top values of the last vm_state, bottom first
+    bool use_published = false;
+    bool elided = false;                  /// The published values are not the whole stack (Row 0 is "...")
+    int rows = 0;
+
+    void resize_rows(int count);
+};
+
+/**
+ * @brief The instruction log: one row per trace entry, oldest first.
+ * @details While a program runs on the worker the trace belongs to it, freeze() formats the visible rows beforehand and
+ *          the model shows only them (Without reading the trace) until the next sync.
+*/
+class TraceModel : public QAbstractListModel{
+    Q_OBJECT
+
+public:
+    explicit TraceModel(const stackinterpreter::Trace &_trace, QObject *parent = nullptr) : QAbstractListModel(parent), trace(_trace){}
+
+    [[nodiscard]] int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    [[nodiscard]] QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    void sync();
+    void clear();
+    void freeze(int first, int last);
+
+private:
+    const stackinterpreter::Trace &trace; /// Not owned
+    quint64 start = 0, end = 0;           /// Trace::get_head() numbers of the first row and after the last row
+    bool frozen = false;                  /// The trace is written by the worker, only frozen_rows are shown
+    int frozen_first = 0;
+    QVector<QVariant> frozen_rows;        /// Rows frozen_first... formatted by freeze()
+
+    [[nodiscard]] QVariant format_row(int row) const;
+};
+
+/**
+ * @brief The memory log: one row per PUSH or POP entry of the trace, oldest first.
+ * @details The entry numbers of the rows are kept, a sync only scans the entries recorded since the previous one. Frozen
+ *          while a program runs on the worker, like TraceModel.
+*/
+class MemoryLogModel : public QAbstractListModel{
+    Q_OBJECT
+
+public:
+    explicit MemoryLogModel(const stackinterpreter::Trace &_trace, QObject *parent = nullptr) : QAbstractListModel(parent), trace(_trace){}
+
+    [[nodiscard]] int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    [[nodiscard]] QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    void sync();
+    void clear();
+    void freeze(int first, int last);
+
+private:
+    const stackinterpreter::Trace &trace; /// Not owned
+    QVector<quint64> entries;             /// Trace::get_head() numbers of the rows (From front)
+    qsizetype front = 0;                  /// First live element of entries (Removed rows are compacted lazily)
+    quint64 scanned = 0;                  /// Entries before it were already scanned (Or cleared)
+    bool frozen = false;                  /// The trace is written by the worker, only frozen_rows are shown
+    int frozen_first = 0;
+    QVector<QVariant> frozen_rows;        /// Rows frozen_first... formatted by freeze()
+
+    [[nodiscard]] QVariant format_row(int row) const;
+};
+
+/**
+ * @brief The memory slots as a grid of columns slots per row (Hexadecimal or decimal, "--" for the free slots).
+ * @details A sync repaints only the visible slots written since the previous one (Memory::dirty_ranges), so a memory of
+ *          millions of slots costs what the view shows. While a program runs on the worker, the model shows the window
+ *          of slots copied in its vm_state instead (The other slots are blank until the window follows the view).
+*/
+class MemoryModel : public QAbstractTableModel{
+    Q_OBJECT
+
+public:
+    static constexpr int columns = 16;
+
+    explicit MemoryModel(stackinterpreter::Memory &_memory, QObject *parent = nullptr) : QAbstractTableModel(parent), memory(_memory){ resize_rows(); }
+
+    [[nodiscard]] int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    [[nodiscard]] int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    [[nodiscard]] QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    [[nodiscard]] QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    void set_hex(bool _hex);
+    /// @brief Set the slots shown by the view [first, end), the only ones a sync repaints
+    void set_visible(qsizetype first, qsizetype end) noexcept { visible_first = first; visible_end = end; } // Inline function
+    void sync();
+    void sync(const stackinterpreter::vm_state &state);
+
+private:
+    stackinterpreter::Memory &memory; /// Not owned, its dirty bits are cleared by sync()
+    bool hex = true;
+    int rows = 0;
+    qsizetype visible_first = 0, visible_end = 0;
+    bool use_window = false;
+    qsizetype window_first = 0;
+    QVector<int> window_values;
+    QVector<bool> window_occupied;
+    QVector<stackinterpreter::memory_range> dirty; /// Ranges of the last sync (Kept to reuse the allocation)
+
+    void resize_rows();
+    void repaint(qsizetype first, qsizetype end);
+    [[nodiscard]] QString format(int value) const;
+};
+
+/**
+ * @brief The loaded program, one row per instruction, with its breakpoints ("*") and the next instruction to run (">").
+ * @details The breakpoints are the ones of the GUI, the worker patches them in its Interpreter (VMWorker::set_breakpoint).
+*/
+class ProgramModel : public QAbstractListModel{
+    Q_OBJECT
+
+public:
+    explicit ProgramModel(QObject *parent = nullptr) : QAbstractListModel(parent){}
+
+    [[nodiscard]] int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    [[nodiscard]] QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    void set_program(const stackinterpreter::Program &_program);
+    void set_pc(qsizetype _pc);
+    bool toggle_breakpoint(qsizetype offset);
+    /// @brief Return true if the instruction at offset has a breakpoint
+    [[nodiscard]] bool has_breakpoint(qsizetype offset) const noexcept { return offset >= 0 && offset < breakpoints.size() && breakpoints[offset]; } // Inline function
+
+private:
+    stackinterpreter::Program program;
+    QVector<bool> breakpoints; /// One per instruction
+    qsizetype pc = -1;         /// Row of the next instruction (-1: none)
+};
+
+} // namespace stackinterpreter
+
+#endif // VIEW_MODELS_H
@@ -0,0 +1,119 @@
+/**
+ * @headerfile vm_worker.h
+ * @author Guilherme Martinelli Taglietti
+*/
+#ifndef VM_WORKER_H
+#define VM_WORKER_H
+
+#include "instruction_handler.h"
+#include "interpreter.h"
+#include "program.h"
+#include "stack.h"
+#include "trap.h"
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include "QHash"
+#include "QVector"
+#include <atomic>
+#include <limits>
+#include <memory>
+
+namespace stackinterpreter{
+
+typedef struct vm_state{
+    qsizetype              pc;           /// --> Offset of the next instruction to run
+    quint64                executed;     /// --> Instructions executed since the program was started
+    qsizetype              depth;        /// --> Number of values in the stack
+    QVector<int>           top;          /// --> Values at the top of the stack (Top first, at most VMWorker::top_values)
+    QVector<int>           output;       /// --> Values printed since the previous state (Only the last VMWorker::max_output)
+    qsizetype              input_needed; /// --> Values missing to resume a run stopped by Trap::WAITING_INPUT
+    qsizetype              memory_first;    /// --> First memory slot of the window shown by the GUI (VMWorker::set_memory_window)
+    QVector<int>           memory_values;   /// --> Values of the window slots
+    QVector<bool>          memory_occupied; /// --> Occupancy of the window slots
+    QVector<memory_range>  memory_dirty;    /// --> Window slots written since the previous state
+    stackinterpreter::Trap trap;         /// --> Trap wich stopped the run (Trap::INTERRUPTED when paused, Trap::BREAKPOINT at a breakpoint or at the run to cursor target)
+    bool                   running;      /// --> True for the states published while the program runs
+
+    /// Constructors
+    vm_state() : pc(0), executed(0), depth(0), input_needed(0), memory_first(0), trap(stackinterpreter::Trap::NONE), running(false){}
+} vm_state;
+
+/**
+ * @brief Runs a loaded program on its own thread (Moved to a QThread by the GUI), publishing snapshots of its state.
+ * @details While it runs, the worker owns the Stack and the InstructionHandler it was built with, the GUI only reads the
+ *          published vm_state (Its log models are frozen, see TraceModel::freeze). The GUI asks for a state, a pause or a stop through atomic requests (Any thread), the run
+ *          loops read them once per basic block (Taken branch) and the worker emits one queued signal per request, so the
+ *          GUI decides how often it repaints. Run goes through the Interpreter (Not traced), Step N through the
+ *          InstructionHandler (Traced, stops after exactly N instructions). Both mark the memory slots they write, a state
+ *          carries the written ranges of the memory window shown by the GUI and clears the dirty bits.
+ *          Breakpoints are patched in the bytecode of the Interpreter (Run, step over a CALL and run to cursor stop at
+ *          them, Step N does not), the changes asked meanwhile are applied at the next taken branch.
+*/
+class VMWorker : public QObject{
+    Q_OBJECT
+
+public:
+    static constexpr qsizetype top_values = 64;
+    static constexpr qsizetype max_output = 100000;
+
+    VMWorker(stackinterpreter::Stack &_stack, stackinterpreter::InstructionHandler &_handler);
+    ~VMWorker() override;
+    VMWorker(const VMWorker &cpy) = delete;
+    VMWorker& operator=(const VMWorker &rhs) = delete;
+
+    /// @brief Ask the running program for a state_changed() signal (Thread safe)
+    void request_state() noexcept { request(state_request); } // Inline function
+    /// @brief Ask the running program to stop where it is, it resumes with run() or step() (Thread safe)
+    void request_pause() noexcept { request(pause_request); } // Inline function
+    /// @brief Ask the running program to stop, the next run starts it over (Thread safe)
+    void request_stop() noexcept { request(stop_request); } // Inline function
+    /// @brief Set the memory slots copied in the published states, the ones the GUI shows (Thread safe)
+    void set_memory_window(qsizetype first, qsizetype count) noexcept { window_first.store(first); window_count.store(count); } // Inline function
+    void set_breakpoint(qsizetype offset, bool enabled);
+    void discard_breakpoints();
+
+public slots:
+    void load(const stackinterpreter::Program &_program);
+    void run();
+    void step(quint64 count);
+    void step_over();
+    void run_to_cursor(qsizetype target);
+    void provide_input(const QVector<int> &values);
+    void reset();
+
+signals:
+    void state_changed(const stackinterpreter::vm_state &state); /// The program still runs
+    void stopped(const stackinterpreter::vm_state &state);       /// Halted, trapped, paused or waiting for input values
+
+private:
+    static constexpr int state_request = 1, pause_request = 2, stop_request = 4, breakpoint_request = 8;
+
+    stackinterpreter::Stack &stack;                 /// Not owned
+    stackinterpreter::InstructionHandler &handler;  /// Not owned
+    stackinterpreter::Program program;
+    std::unique_ptr<stackinterpreter::Interpreter> interpreter;
+    stackinterpreter::io_buffers io;
+    std::atomic<bool> interrupt;
+    std::atomic<int> requests;
+    std::atomic<qsizetype> window_first, window_count;
+    qsizetype pc = 0;
+    quint64 executed = 0;
+    quint64 remaining = std::numeric_limits<quint64>::max(); /// Instructions left to the current Step N (max for Run)
+    qsizetype until = -1, until_depth = -1; /// Interpreter::run_to target and call depth of the current run (-1 for Run)
+    bool finished = false; /// The next run starts the program over
+    bool started = false;  /// The program left its first instruction (A run stops at a breakpoint there once)
+    QMutex breakpoint_mutex;
+    QHash<qsizetype, bool> breakpoint_changes; /// Offset --> breakpoint set or removed, not applied yet (breakpoint_mutex)
+
+    void request(int flag) noexcept;
+    void resume();
+    void apply_breakpoints();
+    [[nodiscard]] stackinterpreter::vm_state take_state(stackinterpreter::Trap trap, bool running);
+};
+
+} // namespace stackinterpreter
+
+Q_DECLARE_METATYPE(stackinterpreter::vm_state)
+
+#endif // VM_WORKER_H
@@ -0,0 +1,428 @@
+/**
+ * @file main_cli.cpp
+ * @author Guilherme Martinelli Taglietti
+ * @brief Command line batch runner: assembles a program file, runs it to HLT without any UI and reports the throughput.
+*/
+#include "headers/asmexporter.h"
+#include "headers/assembler.h"
+#include "headers/cppexporter.h"
+#include "headers/input_source.h"
+#include "headers/instruction_handler.h"
+#include "headers/interpreter.h"
+#include "headers/jit.h"
+#include "headers/native_compiler.h"
+#include "headers/nativecppexporter.h"
+#include "headers/optimizer.h"
+#include "headers/output_sink.h"
+#include "headers/profiler.h"
+#include "headers/stack.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+
+namespace{
+
+void usage(const char *name){
+    std::fprintf(stderr, "Usage: %s [--stack SIZE] [--memory SIZE] [--dispatch threaded|switch|jit|native] [--native-cache DIR] [--repeat N] [--no-fold] [--no-peephole] [--pairs] [--export cpp|native|asm FILE] [--snapshot FILE] [--restore FILE] [--input FILE | --input-binary FILE] [--output FILE] [--steps N] [--break OFFSET|LABEL]... [--until OFFSET|LABEL] [--continue] [--profile FILE [--profile-cycles]] [--dump] [--trace N] [--quiet] program_file\n", name);
+    std::fprintf(stderr, "  --dispatch switch  Runs through InstructionHandler (Logging switch dispatch) instead of the threaded Interpreter\n");
+    std::fprintf(stderr, "  --dispatch jit     Compiles the program to x86-64 machine code (Linux x86-64 builds)\n");
+    std::fprintf(stderr, "  --dispatch native  Compiles the program to a shared object with $STACKINTERPRETER_CC (Default cc) and loads it, cached by program hash\n");
+    std::fprintf(stderr, "  --native-cache DIR Directory of the cached shared objects (Default %s)\n", stackinterpreter::NativeCompiler::default_cache_directory().toStdString().c_str());
+    std::fprintf(stderr, "  --snapshot FILE    Writes the stack, memory and program counter to an image file when the run stops (EX: INPUT without any stdin value left)\n");
+    std::fprintf(stderr, "  --restore FILE     Resumes from an image file written by --snapshot (Same program, its stack and memory sizes replace --stack and --memory)\n");
+    std::fprintf(stderr, "  --input FILE       Reads the INPUT values from a text file instead of stdin (Decimal integers separated by white space)\n");
+    std::fprintf(stderr, "  --input-binary FILE Reads the INPUT values from a binary file of little endian int32 values (Mapped in memory)\n");
+    std::fprintf(stderr, "  --output FILE      Writes the PRINT values to a text file instead of stdout\n");
+    std::fprintf(stderr, "  --steps N          Stops with a trap after N instructions (Switch dispatch, resumable with --snapshot)\n");
+    std::fprintf(stderr, "  --break LOCATION   Stops the run before the instruction at an offset or a label (Repeatable, threaded dispatch, resumable with --snapshot)\n");
+    std::fprintf(stderr, "  --until LOCATION   Stops the run before the instruction at an offset or a label, like a breakpoint removed once reached\n");
+    std::fprintf(stderr, "  --continue         Prints the breakpoints hit on stderr (With the stack depth and top) and goes on instead of stopping\n");
+    std::fprintf(stderr, "  --profile FILE     Writes the executions per opcode, the hottest instructions and blocks with their source lines to a file (Threaded dispatch)\n");
+    std::fprintf(stderr, "  --profile-cycles   Also times the blocks of the profile with the cycle counter (rdtsc on x86)\n");
+    std::fprintf(stderr, "  --dump             Prints the final stack and the occupied memory slots on stderr\n");
+    std::fprintf(stderr, "  --trace N          Prints the last N instructions traced by the switch dispatch on stderr (HLT clears the trace, shows what led to a trap)\n");
+    std::fprintf(stderr, "  --repeat N         Runs the program N times (Used to benchmark the dispatch)\n");
+    std::fprintf(stderr, "  --no-fold          Runs the program without constant folding and dead code elimination\n");
+    std::fprintf(stderr, "  --no-peephole      Runs the program without superinstructions\n");
+    std::fprintf(stderr, "  --export cpp FILE      Exports the program (Without control flow) to a C++ file replaying it on a std::stack and exits\n");
+    std::fprintf(stderr, "  --export asm FILE      Exports the program to x86-64 Linux assembly (GNU as, same traps as running it with the --stack and --memory sizes) and exits\n");
+    std::fprintf(stderr, "  --export native FILE   Exports the program to C++ with the stack in local variables (Same traps as running it with the --stack and --memory sizes) and exits\n");
+    std::fprintf(stderr, "  --pairs            Prints the fusable instruction pairs of the program as superinstruction table entries and exits\n");
+}
+
+/// @brief Print the instruction pairs of the program that could be fused, most frequent first, in the format of superinstructions.h
+void print_pairs(const stackinterpreter::Program &program){
+    constexpr qint32 opcodes = stackinterpreter::Instructions::ERROR;
+    qsizetype counts[opcodes][opcodes] = {};
+    const QVector<stackinterpreter::bytecode_cell> &code = program.get_code();
+    for(qsizetype pc = 0; pc + 1 < code.size(); ++pc){
+        const qint32 first = code[pc].opcode, second = code[pc + 1].opcode;
+        if(first == stackinterpreter::Instructions::HLT || first == stackinterpreter::Instructions::RET || stackinterpreter::instruction_is_branch(first))
+            continue; // Transfers control, can not be the first half of a superinstruction
+        if(first >= 0 && first < opcodes && second >= 0 && second < opcodes)
+            ++counts[first][second];
+    }
+    QVector<qint32> pairs; // first * opcodes + second
+    for(qint32 pair = 0; pair < opcodes * opcodes; ++pair)
+        if(counts[pair / opcodes][pair % opcodes])
+            pairs.append(pair);
+    std::stable_sort(pairs.begin(), pairs.end(), [&counts](qint32 lhs, qint32 rhs){
+        return counts[lhs / opcodes][lhs % opcodes] > counts[rhs / opcodes][rhs % opcodes];
+    });
+    for(qint32 pair : pairs){
+        const qint32 first = pair / opcodes, second = pair % opcodes;
+        const bool in_table = stackinterpreter::PeepholeOptimizer::fuse(first, second) != first;
+        std::printf("    X(%s_%s, %s, %s) // %lld%s\n", stackinterpreter::instruction_mnemonic(first), stackinterpreter::instruction_mnemonic(second),
+                    stackinterpreter::instruction_mnemonic(first), stackinterpreter::instruction_mnemonic(second),
+                    static_cast<long long>(counts[first][second]), in_table ? " (in table)" : "");
+    }
+}
+
+/// @brief Return the offset of a label or of a decimal offset of the program, -1 if there is no such instruction
+qsizetype resolve_location(const stackinterpreter::Program &program, const char *location){
+    const QString text = QString::fromUtf8(location);
+    if(program.get_labels().contains(text))
+        return program.get_labels().value(text);
+    char *end = nullptr;
+    const long long offset = std::strtoll(location, &end, 10);
+    return *location && !*end && offset >= 0 && offset < program.size() ? static_cast<qsizetype>(offset) : -1;
+}
+
+std::atomic<bool> interrupted(false); /// Set by SIGINT, the threaded and switch dispatches stop at the next taken branch
+
+/// @brief SIGINT handler, a second SIGINT terminates the runner (JIT and native code never read the flag)
+void interrupt_run(int){
+    interrupted.store(true, std::memory_order_relaxed);
+    std::signal(SIGINT, SIG_DFL);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    qsizetype stack_size = 16, memory_size = 256;
+    bool quiet = false, use_handler = false, use_jit = false, use_native = false, dump = false, fold = true, optimize = true, pairs = false;
+    long long repeat = 1, trace_depth = 0, steps = 0;
+    const char *filename = nullptr, *export_format = nullptr, *export_filename = nullptr, *native_cache = nullptr;
+    const char *snapshot_filename = nullptr, *restore_filename = nullptr, *input_filename = nullptr, *output_filename = nullptr;
+    bool binary_input = false, continue_breakpoints = false, profile_cycles = false;
+    const char *profile_filename = nullptr;
+    QList<const char*> break_locations;
+    const char *until_location = nullptr;
+    for(int i = 1; i < argc; ++i){
+        if(!std::strcmp(argv[i], "--stack") && i + 1 < argc)
+            stack_size = std::atoll(argv[++i]);
+        else if(!std::strcmp(argv[i], "--memory") && i + 1 < argc)
+            memory_size = std::atoll(argv[++i]);
+        else if(!std::strcmp(argv[i], "--dispatch") && i + 1 < argc && (!std::strcmp(argv[i + 1], "switch") || !std::strcmp(argv[i + 1], "threaded") ||
+                                                                   !std::strcmp(argv[i + 1], "jit") || !std::strcmp(argv[i + 1], "native"))){
+            use_handler = !std::strcmp(argv[++i], "switch");
+            use_jit = !std::strcmp(argv[i], "jit");
+            use_native = !std::strcmp(argv[i], "native");
+        }
+        else if(!std::strcmp(argv[i], "--native-cache") && i + 1 < argc)
+            native_cache = argv[++i];
+        else if(!std::strcmp(argv[i], "--repeat") && i + 1 < argc && std::atoll(argv[i + 1]) > 0)
+            repeat = std::atoll(argv[++i]);
+        else if(!std::strcmp(argv[i], "--trace") && i + 1 < argc && std::atoll(argv[i + 1]) > 0)
+            trace_depth = std::atoll(argv[++i]);
+        else if(!std::strcmp(argv[i], "--steps") && i + 1 < argc && std::atoll(argv[i + 1]) > 0)
+            steps = std::atoll(argv[++i]);
+        else if(!std::strcmp(argv[i], "--break") && i + 1 < argc)
+            break_locations.append(argv[++i]);
+        else if(!std::strcmp(argv[i], "--until") && i + 1 < argc)
+            until_location = argv[++i];
+        else if(!std::strcmp(argv[i], "--continue"))
+            continue_breakpoints = true;
+        else if(!std::strcmp(argv[i], "--profile") && i + 1 < argc)
+            profile_filename = argv[++i];
+        else if(!std::strcmp(argv[i], "--profile-cycles"))
+            profile_cycles = true;
+        else if(!std::strcmp(argv[i], "--no-fold"))
+            fold = false;
+        else if(!std::strcmp(argv[i], "--no-peephole"))
+            optimize = false;
+        else if(!std::strcmp(argv[i], "--export") && i + 2 < argc && (!std::strcmp(argv[i + 1], "cpp") || !std::strcmp(argv[i + 1], "native") || !std::strcmp(argv[i + 1], "asm"))){
+            export_format = argv[++i];
+            export_filename = argv[++i];
+        }
+        else if(!std::strcmp(argv[i], "--snapshot") && i + 1 < argc)
+            snapshot_filename = argv[++i];
+        else if(!std::strcmp(argv[i], "--restore") && i + 1 < argc)
+            restore_filename = argv[++i];
+        else if((!std::strcmp(argv[i], "--input") || !std::strcmp(argv[i], "--input-binary")) && i + 1 < argc && !input_filename){
+            binary_input = !std::strcmp(argv[i], "--input-binary");
+            input_filename = argv[++i];
+        }
+        else if(!std::strcmp(argv[i], "--output") && i + 1 < argc)
+            output_filename = argv[++i];
+        else if(!std::strcmp(argv[i], "--pairs"))
+            pairs = true;
+        else if(!std::strcmp(argv[i], "--dump"))
+            dump = true;
+        else if(!std::strcmp(argv[i], "--quiet"))
+            quiet = true;
+        else if(argv[i][0] != '-' && !filename)
+            filename = argv[i];
+        else{
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(!filename){
+        usage(argv[0]);
+        return 2;
+    }
+
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text)){
+        std::fprintf(stderr, "%s: cannot open file\n", filename);
+        return 2;
+    }
+    stackinterpreter::Assembler assembler;
+    stackinterpreter::Program program;
+    const QString source = QString::fromUtf8(file.readAll());
+    if(!assembler.assemble(source, program)){
+        for(const stackinterpreter::assembler_error &error : assembler.get_errors())
+            std::fprintf(stderr, "%s:%d:%d: error: %s\n", filename, error.line, error.column, error.message.toStdString().c_str());
+        return 2;
+    }
+    if(pairs){
+        print_pairs(program);
+        return 0;
+    }
+
+    stackinterpreter::Stack stack(stack_size);
+    if(!stack.resize_memory(memory_size)){
+        std::fprintf(stderr, "Invalid memory size\n");
+        return 2;
+    }
+    if(export_format){
+        QElapsedTimer export_timer;
+        export_timer.start();
+        stackinterpreter::NativeCPPExporter native_exporter(export_filename, stack);
+        const bool exported = !std::strcmp(export_format, "native") ? native_exporter.export_to_file(program.get_code())
+                            : !std::strcmp(export_format, "cpp") ? stackinterpreter::CPPExporter(export_filename).export_to_file(program.get_code())
+                                                                 : stackinterpreter::ASMExporter(export_filename, stack).export_to_file(program.get_code());
+        if(!exported){
+            std::fprintf(stderr, "%s: cannot export (%s)\n", export_filename, !native_exporter.get_failure().isEmpty() ? native_exporter.get_failure().toStdString().c_str()
+                                                                                                                  : "Control flow instructions in a C++ export or write error");
+            return 1;
+        }
+        if(!quiet)
+            std::fprintf(stderr, "export: %lld instructions written to %s in %.6f s\n", static_cast<long long>(program.size()), export_filename,
+                         static_cast<double>(export_timer.nsecsElapsed()) / 1e9);
+        return 0;
+    }
+    qsizetype start_pc = 0;
+    if(restore_filename){
+        QElapsedTimer restore_timer;
+        restore_timer.start();
+        if(!stack.load_snapshot(QString::fromUtf8(restore_filename), program.size(), start_pc)){
+            std::fprintf(stderr, "%s: not a snapshot of this program or cannot be read\n", restore_filename);
+            return 2;
+        }
+        memory_size = stack.get_max_mem_size();
+        if(!quiet)
+            std::fprintf(stderr, "snapshot: restored pc %lld from %s in %.6f s\n", static_cast<long long>(start_pc), restore_filename,
+                         static_cast<double>(restore_timer.nsecsElapsed()) / 1e9);
+    }
+    const bool debugging = !break_locations.isEmpty() || until_location;
+    if(snapshot_filename || restore_filename || debugging)
+        fold = false; // The image and breakpoint offsets are the ones of the program file, whatever the dispatch
+    stackinterpreter::Optimizer optimizer;
+    if(fold && !use_handler){ // InstructionHandler runs the program as written (Reference path)
+        stackinterpreter::Program optimized;
+        optimizer.optimize(program, optimized, dump ? 0 : memory_size); // The dumped memory keeps every store
+        program = optimized;
+    }
+    stackinterpreter::InstructionHandler handler;
+    if(trace_depth)
+        handler.get_trace().set_depth(trace_depth);
+    stackinterpreter::Interpreter interpreter(program, optimize);
+    stackinterpreter::Jit jit(use_jit ? program : stackinterpreter::Program());
+    if(use_jit && !jit.is_compiled()){
+        std::fprintf(stderr, "JIT not available in this build\n");
+        return 2;
+    }
+    QElapsedTimer load_timer;
+    load_timer.start();
+    std::unique_ptr<stackinterpreter::NativeCompiler> native;
+    if(use_native){
+        native = std::make_unique<stackinterpreter::NativeCompiler>(program, native_cache ? QString::fromUtf8(native_cache) : stackinterpreter::NativeCompiler::default_cache_directory());
+        if(!native->is_loaded()){
+            std::fprintf(stderr, "native: %s\n", native->get_failure().toStdString().c_str());
+            return 2;
+        }
+    }
+    const double load_seconds = static_cast<double>(load_timer.nsecsElapsed()) / 1e9;
+    std::unique_ptr<stackinterpreter::InputSource> input_source;
+    if(input_filename && binary_input){
+        std::unique_ptr<stackinterpreter::BinaryFileInputSource> binary = std::make_unique<stackinterpreter::BinaryFileInputSource>(QString::fromUtf8(input_filename));
+        if(!binary->is_open()){
+            std::fprintf(stderr, "%s: cannot open file\n", input_filename);
+            return 2;
+        }
+        input_source = std::move(binary);
+    }
+    else if(input_filename){
+        std::unique_ptr<stackinterpreter::TextFileInputSource> text = std::make_unique<stackinterpreter::TextFileInputSource>(QString::fromUtf8(input_filename));
+        if(!text->is_open()){
+            std::fprintf(stderr, "%s: cannot open file\n", input_filename);
+            return 2;
+        }
+        input_source = std::move(text);
+    }
+    else
+        input_source = std::make_unique<stackinterpreter::StdinInputSource>();
+    std::unique_ptr<stackinterpreter::TextOutputSink> output_sink;
+    if(output_filename){
+        output_sink = std::make_unique<stackinterpreter::TextFileOutputSink>(QString::fromUtf8(output_filename));
+        if(!output_sink->is_good()){
+            std::fprintf(stderr, "%s: cannot create file\n", output_filename);
+            return 2;
+        }
+    }
+    else
+        output_sink = std::make_unique<stackinterpreter::StdoutOutputSink>();
+    stackinterpreter::io_buffers io;
+    io.sink = output_sink.get();
+    if(steps && !use_handler){
+        std::fprintf(stderr, "--steps needs --dispatch switch\n");
+        return 2;
+    }
+    if(debugging && (use_handler || use_jit || use_native)){
+        std::fprintf(stderr, "--break and --until need --dispatch threaded\n");
+        return 2;
+    }
+    for(const char *location : break_locations){
+        if(!interpreter.set_breakpoint(resolve_location(program, location))){
+            std::fprintf(stderr, "%s: no instruction at %s\n", filename, location);
+            return 2;
+        }
+    }
+    if((profile_filename || profile_cycles) && (use_handler || use_jit || use_native || !profile_filename)){
+        std::fprintf(stderr, "--profile needs --dispatch threaded, --profile-cycles needs --profile\n");
+        return 2;
+    }
+    stackinterpreter::Profile profile(profile_cycles);
+    if(profile_filename)
+        interpreter.set_profile(&profile);
+    const qsizetype until = until_location ? resolve_location(program, until_location) : -1;
+    if(until_location && until < 0){
+        std::fprintf(stderr, "%s: no instruction at %s\n", filename, until_location);
+        return 2;
+    }
+    if(!use_jit && !use_native){ // Ctrl+C stops the run like a trap (Snapshot included), the compiled code would never stop
+        handler.set_interrupt(&interrupted);
+        interpreter.set_interrupt(&interrupted);
+        std::signal(SIGINT, interrupt_run);
+    }
+    stackinterpreter::run_result result;
+    quint64 executed = 0, breakpoint_hits = 0;
+    qsizetype pc = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for(long long run = 0; run < repeat && result.trap == stackinterpreter::Trap::NONE; ++run){
+        pc = run ? 0 : start_pc;
+        bool at_breakpoint = (run || !restore_filename) && interpreter.has_breakpoint(pc); // A restored run resumes from its breakpoint instead
+        for(;;){
+            if(at_breakpoint){
+                result = stackinterpreter::run_result();
+                result.trap = stackinterpreter::Trap::BREAKPOINT;
+                result.pc = pc;
+                at_breakpoint = false;
+            }
+            else
+                result = use_handler ? handler.run(stack, program, pc, io, steps ? static_cast<quint64>(steps) - executed : std::numeric_limits<quint64>::max()) : use_jit ? jit.run(stack, pc, io)
+                       : use_native ? native->run(stack, pc, io) : until >= 0 ? interpreter.run_to(stack, pc, io, until) : interpreter.run(stack, pc, io);
+            executed += result.executed;
+            pc = result.pc;
+            io.drain_output();
+            if(result.trap == stackinterpreter::Trap::BREAKPOINT && continue_breakpoints && pc != until){
+                ++breakpoint_hits;
+                std::fprintf(stderr, "breakpoint: pc %lld (line %d), stack depth %lld", static_cast<long long>(pc), program.line_of(pc), static_cast<long long>(stack.get_size()));
+                if(stack.get_size())
+                    std::fprintf(stderr, ", top %d", stack.get_data()[stack.get_size() - 1]);
+                std::fprintf(stderr, "\n");
+                continue;
+            }
+            if(result.trap != stackinterpreter::Trap::WAITING_INPUT || !input_source->refill(io)) // Resumes with a whole chunk of values
+                break;
+        }
+    }
+    if(!output_sink->flush()){
+        std::fprintf(stderr, "%s: write error\n", output_filename ? output_filename : "stdout");
+        return 1;
+    }
+    const double seconds = static_cast<double>(timer.nsecsElapsed()) / 1e9;
+    if(profile_filename){
+        QFile profile_file(QString::fromUtf8(profile_filename));
+        const QByteArray report = profile.report(program, source.split('\n')).toUtf8();
+        if(!profile_file.open(QIODevice::WriteOnly | QIODevice::Text) || profile_file.write(report) != report.size()){
+            std::fprintf(stderr, "%s: cannot write the profile\n", profile_filename);
+            return 1;
+        }
+    }
+    if(snapshot_filename){
+        QElapsedTimer snapshot_timer;
+        snapshot_timer.start();
+        if(!stack.save_snapshot(QString::fromUtf8(snapshot_filename), pc)){
+            std::fprintf(stderr, "%s: cannot write the snapshot\n", snapshot_filename);
+            return 1;
+        }
+        if(!quiet)
+            std::fprintf(stderr, "snapshot: pc %lld written to %s in %.6f s\n", static_cast<long long>(pc), snapshot_filename,
+                         static_cast<double>(snapshot_timer.nsecsElapsed()) / 1e9);
+    }
+
+    int status = 0;
+    if(result.trap != stackinterpreter::Trap::NONE){
+        std::fprintf(stderr, "%s:%d: trap at pc %lld: %s\n", filename, program.line_of(pc), static_cast<long long>(pc), stackinterpreter::trap_message(result.trap));
+        status = 1;
+    }
+    if(!quiet){
+        std::fprintf(stderr, "dispatch: %s\n", use_handler ? "switch (InstructionHandler)" : use_jit ? "jit (x86-64)" : use_native ? "native (shared object)" : stackinterpreter::Interpreter::threaded_dispatch() ? "threaded (computed goto)" : "switch (Interpreter)");
+        if(use_jit)
+            std::fprintf(stderr, "native code: %lld bytes\n", static_cast<long long>(jit.code_size()));
+        if(use_native)
+            std::fprintf(stderr, "native object: %s (%s in %.6f s)\n", native->get_object_path().toStdString().c_str(),
+                         native->is_cached() ? "loaded from the cache" : "compiled", load_seconds);
+        if(!use_handler && interpreter.is_verified())
+            std::fprintf(stderr, "verification: stack depth verified (Needs %d values, grows at most %d)\n", interpreter.get_verifier().get_required_depth(), interpreter.get_verifier().get_max_growth());
+        else if(!use_handler)
+            std::fprintf(stderr, "verification: failed at line %d: %s\n", program.line_of(interpreter.get_verifier().get_failed_pc()), interpreter.get_verifier().get_failure().toStdString().c_str());
+        if(fold && !use_handler)
+            std::fprintf(stderr, "optimizer: %lld instructions eliminated (%lld folded, %lld unreachable), %lld dead stores\n",
+                         static_cast<long long>(optimizer.get_eliminated()), static_cast<long long>(optimizer.get_folded()),
+                         static_cast<long long>(optimizer.get_unreachable()), static_cast<long long>(optimizer.get_dead_stores()));
+        if(!use_handler && !use_jit && !use_native)
+            std::fprintf(stderr, "superinstructions: %lld pairs fused\n", static_cast<long long>(interpreter.get_fused()));
+        if(continue_breakpoints)
+            std::fprintf(stderr, "breakpoints: %llu hits\n", static_cast<unsigned long long>(breakpoint_hits));
+        std::fprintf(stderr, "instructions executed: %llu\n", static_cast<unsigned long long>(executed));
+        std::fprintf(stderr, "wall time: %.6f s\n", seconds);
+        std::fprintf(stderr, "instructions/second: %.0f\n", seconds > 0 ? static_cast<double>(executed) / seconds : 0.0);
+    }
+    if(dump){
+        std::fprintf(stderr, "stack:");
+        for(qsizetype i = 0; i < stack.get_size(); ++i)
+            std::fprintf(stderr, " %d", stack.get_data()[i]);
+        std::fprintf(stderr, "\nmemory:");
+        for(qsizetype address = stack.next_occupied(0); address >= 0; address = stack.next_occupied(address + 1))
+            std::fprintf(stderr, " %llx=%d", static_cast<unsigned long long>(address), stack.value_at(address));
+        std::fprintf(stderr, "\n");
+    }
+    if(trace_depth && use_handler){
+        const stackinterpreter::Trace &trace = handler.get_trace();
+        for(qsizetype i = qMax<qsizetype>(0, trace.size() - trace_depth); i < trace.size(); ++i)
+            std::fprintf(stderr, "trace: %5d  %s\n", trace.at(i).pc, stackinterpreter::Trace::format_instruction(trace.at(i)).toStdString().c_str());
+    }
+    return status;
+}
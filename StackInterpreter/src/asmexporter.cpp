@@ -1,63 +1,487 @@
 #include "../headers/asmexporter.h"
-#include <fstream>
-#include <QVector>
-#include <QStringList>
-#include <QDir>
+#include "../headers/buffered_writer.h"
+#include <QFile>
+
+namespace{
+
+constexpr qsizetype output_buffer_size = 4096;
+constexpr qsizetype input_buffer_size = 4096;
+
+/// @brief Return the assembler symbol set to the value of a trap (The macros never use the enum values directly)
+const char* trap_symbol(stackinterpreter::Trap trap) noexcept{
+    switch(trap){
+        case stackinterpreter::Trap::NONE:                 return "TRAP_NONE";
+        case stackinterpreter::Trap::STACK_OVERFLOW:       return "TRAP_STACK_OVERFLOW";
+        case stackinterpreter::Trap::STACK_UNDERFLOW:      return "TRAP_STACK_UNDERFLOW";
+        case stackinterpreter::Trap::DIVISION_BY_ZERO:     return "TRAP_DIVISION_BY_ZERO";
+        case stackinterpreter::Trap::INVALID_ADDRESS:      return "TRAP_INVALID_ADDRESS";
+        case stackinterpreter::Trap::EMPTY_MEMORY_SLOT:    return "TRAP_EMPTY_MEMORY_SLOT";
+        case stackinterpreter::Trap::INVALID_OPERAND:      return "TRAP_INVALID_OPERAND";
+        case stackinterpreter::Trap::INVALID_INSTRUCTION:  return "TRAP_INVALID_INSTRUCTION";
+        case stackinterpreter::Trap::CALL_STACK_OVERFLOW:  return "TRAP_CALL_STACK_OVERFLOW";
+        case stackinterpreter::Trap::CALL_STACK_UNDERFLOW: return "TRAP_CALL_STACK_UNDERFLOW";
+        case stackinterpreter::Trap::WAITING_INPUT:        return "TRAP_WAITING_INPUT";
+        case stackinterpreter::Trap::INTERRUPTED:          return "TRAP_INTERRUPTED";
+        case stackinterpreter::Trap::BREAKPOINT:           return "TRAP_BREAKPOINT";
+    }
+    return "TRAP_NONE";
+}
+
+/// Runtime called by the exported program (Clobbers %rax, %rcx, %rdx, %rsi, %rdi, %r8-%r11 only)
+const char *const runtime =
+    "# flush_out: writes the buffered output to stdout\n"
+    "flush_out:\n"
+    "    leaq outbuf(%rip), %rsi\n"
+    "    movq outpos(%rip), %rdx\n"
+    "1:  testq %rdx, %rdx\n"
+    "    jle 2f\n"
+    "    movl $1, %eax\n"
+    "    movl $1, %edi\n"
+    "    syscall\n"
+    "    testq %rax, %rax\n"
+    "    jle 2f\n"
+    "    addq %rax, %rsi\n"
+    "    subq %rax, %rdx\n"
+    "    jmp 1b\n"
+    "2:  movq $0, outpos(%rip)\n"
+    "    ret\n\n"
+    "# format_int: %edi = value --> %rsi = first character, %rdx = length (Written at the end of numbuf)\n"
+    "format_int:\n"
+    "    leaq numbuf+16(%rip), %rsi\n"
+    "    movl %edi, %eax\n"
+    "    testl %eax, %eax\n"
+    "    jns 1f\n"
+    "    negl %eax\n"
+    "1:  movl $10, %ecx\n"
+    "2:  xorl %edx, %edx\n"
+    "    divl %ecx\n"
+    "    addb $48, %dl\n"
+    "    decq %rsi\n"
+    "    movb %dl, (%rsi)\n"
+    "    testl %eax, %eax\n"
+    "    jnz 2b\n"
+    "    testl %edi, %edi\n"
+    "    jns 3f\n"
+    "    decq %rsi\n"
+    "    movb $45, (%rsi)\n"
+    "3:  leaq numbuf+16(%rip), %rdx\n"
+    "    subq %rsi, %rdx\n"
+    "    ret\n\n"
+    "# print_int: %edi = value, appends the value and a new line to the output buffer\n"
+    "print_int:\n"
+    "    cmpq $OUTPUT_LIMIT, outpos(%rip)\n"
+    "    jb 1f\n"
+    "    pushq %rdi\n"
+    "    call flush_out\n"
+    "    popq %rdi\n"
+    "1:  call format_int\n"
+    "    leaq outbuf(%rip), %rdi\n"
+    "    addq outpos(%rip), %rdi\n"
+    "    movq %rdx, %rcx\n"
+    "    rep movsb\n"
+    "    movb $10, (%rdi)\n"
+    "    incq %rdi\n"
+    "    leaq outbuf(%rip), %rax\n"
+    "    subq %rax, %rdi\n"
+    "    movq %rdi, outpos(%rip)\n"
+    "    ret\n\n"
+    "# read_byte: %eax = next byte of stdin, -1 at the end of the input\n"
+    "read_byte:\n"
+    "    movq inpos(%rip), %rax\n"
+    "    cmpq inlen(%rip), %rax\n"
+    "    jb 1f\n"
+    "    xorl %eax, %eax\n"
+    "    xorl %edi, %edi\n"
+    "    leaq inbuf(%rip), %rsi\n"
+    "    movl $INPUT_SIZE, %edx\n"
+    "    syscall\n"
+    "    testq %rax, %rax\n"
+    "    jle 2f\n"
+    "    movq %rax, inlen(%rip)\n"
+    "    xorl %eax, %eax\n"
+    "1:  leaq inbuf(%rip), %rcx\n"
+    "    movzbl (%rcx,%rax), %edx\n"
+    "    incq %rax\n"
+    "    movq %rax, inpos(%rip)\n"
+    "    movl %edx, %eax\n"
+    "    ret\n"
+    "2:  movq $0, inlen(%rip)\n"
+    "    movq $0, inpos(%rip)\n"
+    "    movl $-1, %eax\n"
+    "    ret\n\n"
+    "# read_int: %edi = pc --> %eax = next decimal integer of stdin (Traps waiting for an input value if there is none)\n"
+    "read_int:\n"
+    "    movl %edi, %r8d\n"
+    "1:  call read_byte\n"
+    "    leal -9(%rax), %ecx\n"
+    "    cmpl $4, %ecx\n"
+    "    jbe 1b\n"
+    "    cmpl $32, %eax\n"
+    "    je 1b\n"
+    "    xorl %r9d, %r9d\n"
+    "    cmpl $45, %eax\n"
+    "    jne 2f\n"
+    "    movl $1, %r9d\n"
+    "    call read_byte\n"
+    "    jmp 3f\n"
+    "2:  cmpl $43, %eax\n"
+    "    jne 3f\n"
+    "    call read_byte\n"
+    "3:  leal -48(%rax), %ecx\n"
+    "    cmpl $9, %ecx\n"
+    "    ja 6f\n"
+    "    xorl %r10d, %r10d\n"
+    "4:  imull $10, %r10d, %r10d\n"
+    "    addl %ecx, %r10d\n"
+    "    call read_byte\n"
+    "    leal -48(%rax), %ecx\n"
+    "    cmpl $9, %ecx\n"
+    "    jbe 4b\n"
+    "    cmpl $-1, %eax\n"
+    "    je 5f\n"
+    "    decq inpos(%rip)\n"
+    "5:  movl %r10d, %eax\n"
+    "    testl %r9d, %r9d\n"
+    "    jz 7f\n"
+    "    negl %eax\n"
+    "7:  ret\n"
+    "6:  movl %r8d, %edi\n"
+    "    movl $TRAP_WAITING_INPUT, %esi\n"
+    "    jmp raise_trap\n\n"
+    "# raise_trap: %edi = pc, %esi = trap number, reports the trap with its message (trap_messages table)\n"
+    "raise_trap:\n"
+    "    movl %esi, %eax\n"
+    "    shlq $4, %rax\n"
+    "    leaq trap_messages(%rip), %rcx\n"
+    "    movq (%rcx,%rax), %rsi\n"
+    "    movq 8(%rcx,%rax), %rdx\n"
+    "    jmp trap\n\n"
+    "# trap: %edi = pc, %rsi = message, %edx = length, prints \"trap at pc N: message\" on stderr and exits with 1\n"
+    "trap:\n"
+    "    pushq %rsi\n"
+    "    pushq %rdx\n"
+    "    pushq %rdi\n"
+    "    call flush_out\n"
+    "    movl $1, %eax\n"
+    "    movl $2, %edi\n"
+    "    leaq trap_prefix(%rip), %rsi\n"
+    "    movl $trap_prefix_len, %edx\n"
+    "    syscall\n"
+    "    popq %rdi\n"
+    "    call format_int\n"
+    "    movl $1, %eax\n"
+    "    movl $2, %edi\n"
+    "    syscall\n"
+    "    movl $1, %eax\n"
+    "    movl $2, %edi\n"
+    "    leaq trap_separator(%rip), %rsi\n"
+    "    movl $2, %edx\n"
+    "    syscall\n"
+    "    popq %rdx\n"
+    "    popq %rsi\n"
+    "    movl $1, %eax\n"
+    "    movl $2, %edi\n"
+    "    syscall\n"
+    "    movl $1, %eax\n"
+    "    movl $2, %edi\n"
+    "    leaq trap_separator+2(%rip), %rsi\n"
+    "    movl $1, %edx\n"
+    "    syscall\n"
+    "    movl $60, %eax\n"
+    "    movl $1, %edi\n"
+    "    syscall\n";
+
+/// Assembler macros implementing every instruction, the traps raised by an instruction are out of line stubs
+const char *const macros =
+    "# raise cc, pc, trap: jumps (If cc) to a stub reporting the trap (A TRAP_* symbol), the stubs are kept out of the hot code\n"
+    ".macro raise cc, pc, trap\n"
+    "    j\\cc .Ltrap\\@\n"
+    "    .pushsection .text.traps, \"ax\"\n"
+    ".Ltrap\\@:\n"
+    "    movl $\\pc, %edi\n"
+    "    movl $\\trap, %esi\n"
+    "    jmp raise_trap\n"
+    "    .popsection\n"
+    ".endm\n"
+    ".macro op_trap pc, trap\n"
+    "    raise mp, \\pc, \\trap\n"
+    ".endm\n"
+    ".macro check_underflow pc, needed\n"
+    "    .if \\needed == 1\n"
+    "    cmpq %r14, %rbx\n"
+    "    raise e, \\pc, TRAP_STACK_UNDERFLOW\n"
+    "    .else\n"
+    "    cmpq %r13, %rbx\n"
+    "    raise be, \\pc, TRAP_STACK_UNDERFLOW\n"
+    "    .endif\n"
+    ".endm\n"
+    ".macro check_overflow pc\n"
+    "    cmpq %r15, %rbx\n"
+    "    raise ae, \\pc, TRAP_STACK_OVERFLOW\n"
+    ".endm\n"
+    "# %rbx = address of the top slot, %r12d = top value (The slot is only written when a value is pushed above it)\n"
+    ".macro op_pushi pc, value\n"
+    "    check_overflow \\pc\n"
+    "    movl %r12d, (%rbx)\n"
+    "    addq $4, %rbx\n"
+    "    movl $\\value, %r12d\n"
+    ".endm\n"
+    ".macro op_push pc, address, trap=0\n"
+    "    check_underflow \\pc, 1\n"
+    "    .if \\trap\n"
+    "    op_trap \\pc, \\trap\n"
+    "    .else\n"
+    "    movl %r12d, memory+4*\\address(%rip)\n"
+    "    movb $1, occupied+\\address(%rip)\n"
+    "    subq $4, %rbx\n"
+    "    movl (%rbx), %r12d\n"
+    "    .endif\n"
+    ".endm\n"
+    ".macro op_pop pc, address, trap=0\n"
+    "    check_overflow \\pc\n"
+    "    .if \\trap\n"
+    "    op_trap \\pc, \\trap\n"
+    "    .else\n"
+    "    cmpb $0, occupied+\\address(%rip)\n"
+    "    raise e, \\pc, TRAP_EMPTY_MEMORY_SLOT\n"
+    "    movb $0, occupied+\\address(%rip)\n"
+    "    movl %r12d, (%rbx)\n"
+    "    addq $4, %rbx\n"
+    "    movl memory+4*\\address(%rip), %r12d\n"
+    "    .endif\n"
+    ".endm\n"
+    "# The stack is checked before the value is read (Like the run loops)\n"
+    ".macro op_input pc\n"
+    "    check_overflow \\pc\n"
+    "    movl $\\pc, %edi\n"
+    "    call read_int\n"
+    "    movl %r12d, (%rbx)\n"
+    "    addq $4, %rbx\n"
+    "    movl %eax, %r12d\n"
+    ".endm\n"
+    "# The stack is checked before reading, every value is stored above the spilled top (Kept at (%rsp) while reading)\n"
+    ".macro op_inputn pc, count\n"
+    "    .if \\count\n"
+    "    leaq 4*\\count(%rbx), %rax\n"
+    "    cmpq %r15, %rax\n"
+    "    raise a, \\pc, TRAP_STACK_OVERFLOW\n"
+    "    movl %r12d, (%rbx)\n"
+    "    pushq %rax\n"
+    "1:  movl $\\pc, %edi\n"
+    "    call read_int\n"
+    "    addq $4, %rbx\n"
+    "    movl %eax, (%rbx)\n"
+    "    cmpq (%rsp), %rbx\n"
+    "    jb 1b\n"
+    "    popq %rax\n"
+    "    movl (%rbx), %r12d\n"
+    "    .endif\n"
+    ".endm\n"
+    ".macro op_print pc\n"
+    "    check_underflow \\pc, 1\n"
+    "    movl %r12d, %edi\n"
+    "    call print_int\n"
+    "    subq $4, %rbx\n"
+    "    movl (%rbx), %r12d\n"
+    ".endm\n"
+    ".macro op_add pc\n"
+    "    check_underflow \\pc, 2\n"
+    "    subq $4, %rbx\n"
+    "    addl (%rbx), %r12d\n"
+    ".endm\n"
+    ".macro op_sub pc\n"
+    "    check_underflow \\pc, 2\n"
+    "    subq $4, %rbx\n"
+    "    movl (%rbx), %eax\n"
+    "    subl %r12d, %eax\n"
+    "    movl %eax, %r12d\n"
+    ".endm\n"
+    ".macro op_mul pc\n"
+    "    check_underflow \\pc, 2\n"
+    "    subq $4, %rbx\n"
+    "    imull (%rbx), %r12d\n"
+    ".endm\n"
+    ".macro op_div pc\n"
+    "    check_underflow \\pc, 2\n"
+    "    testl %r12d, %r12d\n"
+    "    raise z, \\pc, TRAP_DIVISION_BY_ZERO\n"
+    "    subq $4, %rbx\n"
+    "    movl (%rbx), %eax\n"
+    "    cmpl $-1, %r12d\n"
+    "    jne 1f\n"
+    "    negl %eax\n"
+    "    jmp 2f\n"
+    "1:  cltd\n"
+    "    idivl %r12d\n"
+    "2:  movl %eax, %r12d\n"
+    ".endm\n"
+    ".macro op_swap pc\n"
+    "    check_underflow \\pc, 2\n"
+    "    movl -4(%rbx), %eax\n"
+    "    movl %r12d, -4(%rbx)\n"
+    "    movl %eax, %r12d\n"
+    ".endm\n"
+    ".macro op_drop pc\n"
+    "    check_underflow \\pc, 1\n"
+    "    subq $4, %rbx\n"
+    "    movl (%rbx), %r12d\n"
+    ".endm\n"
+    ".macro op_dup pc\n"
+    "    check_underflow \\pc, 1\n"
+    "    check_overflow \\pc\n"
+    "    movl %r12d, (%rbx)\n"
+    "    addq $4, %rbx\n"
+    ".endm\n"
+    ".macro op_jz pc, target\n"
+    "    check_underflow \\pc, 1\n"
+    "    movl %r12d, %eax\n"
+    "    subq $4, %rbx\n"
+    "    movl (%rbx), %r12d\n"
+    "    testl %eax, %eax\n"
+    "    jz .Lpc\\target\n"
+    ".endm\n"
+    ".macro op_jnz pc, target\n"
+    "    check_underflow \\pc, 1\n"
+    "    movl %r12d, %eax\n"
+    "    subq $4, %rbx\n"
+    "    movl (%rbx), %r12d\n"
+    "    testl %eax, %eax\n"
+    "    jnz .Lpc\\target\n"
+    ".endm\n"
+    "# %rbp = next free slot of the return stack (Holds the native address of the return label)\n"
+    ".macro op_call pc, target, next\n"
+    "    leaq rstack+8*CALL_DEPTH(%rip), %rax\n"
+    "    cmpq %rax, %rbp\n"
+    "    raise ae, \\pc, TRAP_CALL_STACK_OVERFLOW\n"
+    "    leaq .Lpc\\next(%rip), %rax\n"
+    "    movq %rax, (%rbp)\n"
+    "    addq $8, %rbp\n"
+    "    jmp .Lpc\\target\n"
+    ".endm\n"
+    ".macro op_ret pc\n"
+    "    leaq rstack(%rip), %rax\n"
+    "    cmpq %rax, %rbp\n"
+    "    raise e, \\pc, TRAP_CALL_STACK_UNDERFLOW\n"
+    "    subq $8, %rbp\n"
+    "    jmp *(%rbp)\n"
+    ".endm\n";
+
+} // namespace
 
 /**
  * @namespace stackinterpreter
  * @class ASMExporter @extends Exporter
  * @name export_to_file
- * @brief Create a .asm (Assembly file) based on the current stack and operations log
- * @param instruction_log
+ * @brief Create a .asm (Assembly file) running the program natively on x86-64 Linux
+ * @param code - Assembled program (Control flow included) or straight line sequence (EX: Trace::executed_code())
  * @return true if successfully exported, else false
+ * @details Every instruction is written as an invocation of the assembler macro implementing it (EX: "op_pushi 12, 7"),
+ *          so the file stays small and the export is a single pass without any formatting besides the operands.
+ *          Only branch targets and return addresses get a label.
  */
-bool stackinterpreter::ASMExporter::export_to_file(const QVector<QString> &instruction_log) const{
-    if(!instruction_log.size())
+bool stackinterpreter::ASMExporter::export_to_file(const QVector<stackinterpreter::bytecode_cell> &code) const{
+    if(!code.size())
         return false;
-    try{
-        std::ofstream asmfile(filename.toStdString().c_str());
-        asmfile << ".section .data\n    stack: .skip 1000\n\n.section .text\n    .global _start\n\n_start:\n    lea rsi, stack\n";
-        for(const QString &instruction : instruction_log){
-            QStringList parsed = instruction.split("    ");
-            if(parsed[0] == "PUSHI")
-                asmfile << "    movl $" << parsed[1].toInt() << ", (%rsi)\n    addq $4, %rsi\n";
-            else if(parsed[0] == "PUSH")
-                asmfile << "    movl (%rsi), %eax\n    movl %eax, " << parsed[1].toInt() << "(%rsi)\n    addq $4, %rsi\n";
-            else if(parsed[0] == "POP")
-                asmfile << "    movl " << parsed[1].toInt() << "(%rsi), %eax\n    movl %eax, (%rsi)\n    addq $4, %rsi\n";
-            else if(parsed[0] == "INPUT")
-                asmfile << "    movl $0, %eax\n    movl $3, %ebx\n    movl $1, %ecx\n    lea %edx, [rsi]\n    int $0x80\n    addq $4, %rsi\n";
-            else if(parsed[0] == "ADD" || parsed[0] == "SUB" || parsed[0] == "MUL" || parsed[0] == "DIV"){
-                asmfile << "    movl (%rsi), %eax\n    addq $4, %rsi\n";
-                asmfile << "    movl (%rsi), %ebx\n    addq $4, %rsi\n";
-                if(parsed[0] == "ADD")
-                    asmfile << "    addl %ebx, %eax\n";
-                else if(parsed[0] == "SUB")
-                    asmfile << "    subl %ebx, %eax\n";
-                else if(parsed[0] == "MUL")
-                    asmfile << "    imul %ebx, %eax\n";
-                else if(parsed[0] == "DIV")
-                    asmfile << "    movl $0, %edx\n    idiv %ebx\n";
-                asmfile << "    movl %eax, (%rsi)\n";
-            }
-            else if(parsed[0] == "SWAP"){
-                asmfile << "    movl (%rsi), %eax\n    addq $4, %rsi\n";
-                asmfile << "    movl (%rsi), %ebx\n    addq $4, %rsi\n";
-                asmfile << "    movl %ebx, (%rsi)\n    movl %eax, 4(%rsi)\n";
-            }
-            else if(parsed[0] == "DUP"){
-                asmfile << "    movl (%rsi), %eax\n    movl %eax, (%rsi)\n    addq $4, %rsi\n";
-            }
-            else if(parsed[0] == "DROP")
-                asmfile << "    subq $4, %rsi\n";
-            else if(parsed[0] == "PRINT")
-                asmfile << "    subq $4, %rsi\n";
+    const qsizetype size = code.size();
+    QVector<bool> targets(size + 1, false);
+    for(qsizetype pc = 0; pc < size; ++pc){
+        if(stackinterpreter::instruction_is_branch(code[pc].opcode) && code[pc].operand >= 0 && code[pc].operand <= size)
+            targets[code[pc].operand] = true;
+        if(code[pc].opcode == stackinterpreter::Instructions::CALL)
+            targets[pc + 1] = true;
+    }
+    stackinterpreter::BufferedWriter asmfile(filename);
+    asmfile << "# Exported by StackInterpreter (x86-64 Linux, GNU as): as -o program.o program.asm && ld -o program program.o\n";
+    asmfile << "    .set OUTPUT_LIMIT, " << output_buffer_size - 16 << "\n    .set INPUT_SIZE, " << input_buffer_size << "\n";
+    asmfile << "    .set STACK_SIZE, " << stack_size << "\n    .set CALL_DEPTH, " << call_depth << "\n\n";
+    asmfile << "    .section .bss\n    .align 16\n";
+    asmfile << "stack:    .skip " << 4 * (stack_size + 1) << "\n";
+    asmfile << "rstack:   .skip " << 8 * qMax<qsizetype>(call_depth, 1) << "\n";
+    asmfile << "memory:   .skip " << 4 * qMax<qsizetype>(memory_size, 1) << "\n";
+    asmfile << "occupied: .skip " << qMax<qsizetype>(memory_size, 1) << "\n";
+    asmfile << "outbuf:   .skip " << output_buffer_size << "\n";
+    asmfile << "inbuf:    .skip " << input_buffer_size << "\n";
+    asmfile << "numbuf:   .skip 16\n";
+    asmfile << "outpos:   .skip 8\ninpos:    .skip 8\ninlen:    .skip 8\n\n";
+    asmfile << "    .section .rodata\n";
+    asmfile << "trap_prefix: .ascii \"trap at pc \"\n    .set trap_prefix_len, . - trap_prefix\n";
+    asmfile << "trap_separator: .ascii \": \\n\"\n";
+    constexpr int traps = static_cast<int>(stackinterpreter::Trap::BREAKPOINT) + 1;
+    for(int trap = 0; trap < traps; ++trap){
+        asmfile << "    .set " << trap_symbol(static_cast<stackinterpreter::Trap>(trap)) << ", " << trap << "\n";
+        asmfile << "trap_message_" << trap << ": .ascii \"" << stackinterpreter::trap_message(static_cast<stackinterpreter::Trap>(trap)) << "\"\n";
+        asmfile << "    .set trap_message_" << trap << "_len, . - trap_message_" << trap << "\n";
+    }
+    asmfile << "    .align 8\ntrap_messages:\n"; // Indexed by trap number: message, length
+    for(int trap = 0; trap < traps; ++trap)
+        asmfile << "    .quad trap_message_" << trap << ", trap_message_" << trap << "_len\n";
+    asmfile << "\n" << macros;
+
+    asmfile << "\n    .section .text\n    .globl _start\n_start:\n";
+    asmfile << "    leaq stack(%rip), %rbx\n    movq %rbx, %r14\n    leaq 4(%rbx), %r13\n    leaq 4*STACK_SIZE(%rbx), %r15\n";
+    asmfile << "    leaq rstack(%rip), %rbp\n    xorl %r12d, %r12d\n";
+    for(qsizetype pc = 0; pc < size; ++pc){
+        const stackinterpreter::bytecode_cell &cell = code[pc];
+        if(targets[pc])
+            asmfile << ".Lpc" << pc << ":\n";
+        if(stackinterpreter::instruction_is_branch(cell.opcode) && (cell.operand < 0 || cell.operand > size)){
+            asmfile << "    op_trap " << pc << ", " << trap_symbol(stackinterpreter::Trap::INVALID_INSTRUCTION) << "\n";
+            continue;
+        }
+        const bool invalid_address = cell.operand < 0 || cell.operand >= memory_size;
+        switch(cell.opcode){
+            case stackinterpreter::Instructions::PUSHI:
+                asmfile << "    op_pushi " << pc << ", " << cell.operand << "\n";
+                break;
+            case stackinterpreter::Instructions::PUSH:
+            case stackinterpreter::Instructions::POP:
+                asmfile << (cell.opcode == stackinterpreter::Instructions::PUSH ? "    op_push " : "    op_pop ") << pc << ", ";
+                if(invalid_address)
+                    asmfile << "-1, " << trap_symbol(stackinterpreter::Trap::INVALID_ADDRESS) << "\n";
+                else
+                    asmfile << cell.operand << "\n";
+                break;
+            case stackinterpreter::Instructions::JMP:
+                asmfile << "    jmp .Lpc" << cell.operand << "\n";
+                break;
+            case stackinterpreter::Instructions::JZ:
+            case stackinterpreter::Instructions::JNZ:
+                asmfile << (cell.opcode == stackinterpreter::Instructions::JZ ? "    op_jz " : "    op_jnz ") << pc << ", " << cell.operand << "\n";
+                break;
+            case stackinterpreter::Instructions::CALL:
+                asmfile << "    op_call " << pc << ", " << cell.operand << ", " << pc + 1 << "\n";
+                break;
+            case stackinterpreter::Instructions::INPUTN:
+                if(cell.operand < 0)
+                    asmfile << "    op_trap " << pc << ", " << trap_symbol(stackinterpreter::Trap::INVALID_OPERAND) << "\n";
+                else if(cell.operand > stack_size)
+                    asmfile << "    op_trap " << pc << ", " << trap_symbol(stackinterpreter::Trap::STACK_OVERFLOW) << "\n";
+                else
+                    asmfile << "    op_inputn " << pc << ", " << cell.operand << "\n";
+                break;
+            case stackinterpreter::Instructions::INPUT:  asmfile << "    op_input " << pc << "\n"; break;
+            case stackinterpreter::Instructions::PRINT:  asmfile << "    op_print " << pc << "\n"; break;
+            case stackinterpreter::Instructions::ADD:    asmfile << "    op_add " << pc << "\n"; break;
+            case stackinterpreter::Instructions::SUB:    asmfile << "    op_sub " << pc << "\n"; break;
+            case stackinterpreter::Instructions::MUL:    asmfile << "    op_mul " << pc << "\n"; break;
+            case stackinterpreter::Instructions::DIV:    asmfile << "    op_div " << pc << "\n"; break;
+            case stackinterpreter::Instructions::SWAP:   asmfile << "    op_swap " << pc << "\n"; break;
+            case stackinterpreter::Instructions::DROP:   asmfile << "    op_drop " << pc << "\n"; break;
+            case stackinterpreter::Instructions::DUP:    asmfile << "    op_dup " << pc << "\n"; break;
+            case stackinterpreter::Instructions::RET:    asmfile << "    op_ret " << pc << "\n"; break;
+            case stackinterpreter::Instructions::HLT:    asmfile << "    jmp halt\n"; break;
+            case stackinterpreter::Instructions::ERROR:
+                asmfile << "    op_trap " << pc << ", " << trap_symbol(stackinterpreter::Trap::INVALID_OPERAND) << "\n";
+                break;
+            default:
+                asmfile << "    op_trap " << pc << ", " << trap_symbol(stackinterpreter::Trap::INVALID_INSTRUCTION) << "\n";
+                break;
         }
-        asmfile << "    movl $1, %eax\n    xorl %ebx, %ebx\n    int $0x80\n";
-        return true;
-    } catch(const std::exception &exception){
+    }
+    asmfile << ".Lpc" << size << ":\nhalt:\n    call flush_out\n    movl $60, %eax\n    xorl %edi, %edi\n    syscall\n\n" << runtime;
+    if(!asmfile.close()){
         QFile::remove(filename);
         return false;
     }
+    return true;
 }
@@ -0,0 +1,175 @@
+/**
+ * @file assembler.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/assembler.h"
+#include <QStringList>
+
+namespace{
+
+typedef struct token{
+    QString text;
+    int     column; // Starting at 1
+} token;
+
+/// @brief Split a source line in tokens (Comments are discarded)
+QVector<token> tokenize(const QString &line) noexcept{
+    QVector<token> tokens;
+    qsizetype i = 0;
+    while(i < line.size()){
+        QChar c = line.at(i);
+        if(c == ';' || c == '#')
+            break;
+        if(c.isSpace()){
+            ++i;
+            continue;
+        }
+        qsizetype start = i;
+        while(i < line.size() && !line.at(i).isSpace() && line.at(i) != ';' && line.at(i) != '#')
+            ++i;
+        tokens.append(token{line.mid(start, i - start), static_cast<int>(start) + 1});
+    }
+    return tokens;
+}
+
+/// @brief Check if a label is a valid identifier ([A-Za-z_][A-Za-z0-9_]*)
+bool is_valid_label(const QString &label) noexcept{
+    if(label.isEmpty() || label.at(0).isDigit())
+        return false;
+    for(qsizetype i = 0; i < label.size(); ++i)
+        if(!label.at(i).isLetterOrNumber() && label.at(i) != '_')
+            return false;
+    return true;
+}
+
+/// @brief Find the opcode of a mnemonic (Case insensitive), Instructions::ERROR if not found
+int find_opcode(const QString &mnemonic) noexcept{
+    QString upper = mnemonic.toUpper();
+    for(int opcode = stackinterpreter::Instructions::PUSHI; opcode < stackinterpreter::Instructions::ERROR; ++opcode)
+        if(upper == stackinterpreter::instruction_mnemonic(opcode))
+            return opcode;
+    return stackinterpreter::Instructions::ERROR;
+}
+
+} // namespace
+
+/**
+ * @namespace stackinterpreter
+ * @class Assembler
+ * @brief Assemble a program source into packed bytecode.
+ * @param source - Program source.
+ * @param program - Receives the bytecode (Cleared before assembling).
+ * @return True if the source was successfully assembled, false otherwise (See get_errors()).
+*/
+bool stackinterpreter::Assembler::assemble(const QString &source, Program &program) noexcept{
+    errors.clear();
+    fixups.clear();
+    program.clear();
+    QStringList source_lines = source.split('\n');
+    for(qsizetype index = 0; index < source_lines.size(); ++index){
+        int line = static_cast<int>(index) + 1;
+        QVector<token> tokens = tokenize(source_lines[index]);
+        qsizetype current = 0;
+        while(current < tokens.size() && tokens[current].text.endsWith(':')){
+            QString label = tokens[current].text.left(tokens[current].text.size() - 1);
+            if(!is_valid_label(label))
+                errors.append(stackinterpreter::assembler_error(line, tokens[current].column, "Invalid label name '" + label + "'"));
+            else if(program.get_labels().contains(label))
+                errors.append(stackinterpreter::assembler_error(line, tokens[current].column, "Label '" + label + "' already declared"));
+            else
+                program.add_label(label, program.size());
+            ++current;
+        }
+        if(current == tokens.size())
+            continue;
+        const token &mnemonic = tokens[current++];
+        int opcode = find_opcode(mnemonic.text);
+        if(opcode == stackinterpreter::Instructions::ERROR){
+            errors.append(stackinterpreter::assembler_error(line, mnemonic.column, "Unknown instruction '" + mnemonic.text + "'"));
+            continue;
+        }
+        qint32 operand = 0;
+        if(stackinterpreter::instruction_has_operand(opcode)){
+            if(current == tokens.size()){
+                errors.append(stackinterpreter::assembler_error(line, mnemonic.column + static_cast<int>(mnemonic.text.size()), mnemonic.text.toUpper() + " expects an operand"));
+                continue;
+            }
+            const token &value = tokens[current++];
+            if(stackinterpreter::instruction_is_branch(opcode) && is_valid_label(value.text))
+                fixups.append(label_fixup{program.size(), value.text, line, value.column});
+            else if(!parse_operand(opcode, value.text, line, value.column, operand))
+                continue;
+            else if(stackinterpreter::instruction_is_branch(opcode))
+                fixups.append(label_fixup{program.size(), QString(), line, value.column}); // Absolute offset, only checked against the program size
+        }
+        if(current < tokens.size()){
+            if(!fixups.isEmpty() && fixups.last().pc == program.size())
+                fixups.removeLast();
+            errors.append(stackinterpreter::assembler_error(line, tokens[current].column, "Unexpected token '" + tokens[current].text + "'"));
+            continue;
+        }
+        program.append(opcode, operand, line);
+    }
+    for(const label_fixup &fixup : fixups){
+        if(fixup.label.isEmpty()){
+            if(program.get_code()[fixup.pc].operand > program.size())
+                errors.append(stackinterpreter::assembler_error(fixup.line, fixup.column, "Branch target out of the program"));
+            continue;
+        }
+        if(!program.get_labels().contains(fixup.label)){
+            errors.append(stackinterpreter::assembler_error(fixup.line, fixup.column, "Undeclared label '" + fixup.label + "'"));
+            continue;
+        }
+        program.patch_operand(fixup.pc, static_cast<qint32>(program.get_labels().value(fixup.label)));
+    }
+    if(!errors.isEmpty())
+        program.clear();
+    return errors.isEmpty();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Assembler
+ * @brief Decode the operand of an instruction (Decimal immediate for PUSHI, hexadecimal address for PUSH/POP, decimal offset for branches, decimal count for INPUTN).
+ * @param opcode - Instruction wich owns the operand.
+ * @param token - Operand text.
+ * @param line - Source line of the operand (Used to report errors).
+ * @param column - Source column of the operand (Used to report errors).
+ * @param operand - Receives the decoded operand.
+ * @return True if the operand is valid, false otherwise.
+*/
+bool stackinterpreter::Assembler::parse_operand(int opcode, const QString &token, int line, int column, qint32 &operand) noexcept{
+    bool ok;
+    if(opcode == stackinterpreter::Instructions::PUSHI){
+        if(token.startsWith("0x") || token.startsWith("-0x"))
+            operand = token.startsWith('-') ? -token.mid(3).toInt(&ok, 16) : token.mid(2).toInt(&ok, 16);
+        else
+            operand = token.toInt(&ok, 10);
+        if(!ok)
+            errors.append(stackinterpreter::assembler_error(line, column, "Invalid number '" + token + "'"));
+        return ok;
+    }
+    if(opcode == stackinterpreter::Instructions::INPUTN){
+        operand = token.toInt(&ok, 10);
+        if(!ok || operand < 0){
+            errors.append(stackinterpreter::assembler_error(line, column, "Invalid value count '" + token + "'"));
+            return false;
+        }
+        return true;
+    }
+    if(stackinterpreter::instruction_is_branch(opcode)){
+        operand = token.toInt(&ok, 10);
+        if(!ok || operand < 0){
+            errors.append(stackinterpreter::assembler_error(line, column, "Invalid branch target '" + token + "'"));
+            return false;
+        }
+        return true;
+    }
+    QString address = token.startsWith("0x") ? token.mid(2) : token;
+    operand = address.toInt(&ok, 16);
+    if(!ok || address.startsWith('-') || address.startsWith('+')){
+        errors.append(stackinterpreter::assembler_error(line, column, "Invalid hexadecimal address '" + token + "'"));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file buffered_writer.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/buffered_writer.h"
+#include <charconv>
+
+/**
+ * @namespace stackinterpreter
+ * @class BufferedWriter
+ * @brief Constructor - Opens (Truncates) the file and allocates the buffer.
+ * @param filename - Path of the output file.
+ * @param _capacity - Size of the buffer in bytes.
+*/
+stackinterpreter::BufferedWriter::BufferedWriter(const QString &filename, qsizetype _capacity) :
+    file(std::fopen(filename.toStdString().c_str(), "wb")), buffer(_capacity > 0 ? _capacity : default_capacity){}
+
+/**
+ * @namespace stackinterpreter
+ * @class BufferedWriter
+ * @brief Destructor - Writes the pending bytes and closes the file (Use close() to know if it succeeded).
+*/
+stackinterpreter::BufferedWriter::~BufferedWriter(){
+    if(file)
+        (void)close();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class BufferedWriter
+ * @brief Append an integer in decimal.
+ * @param value - Integer to be written.
+ * @return Reference to the writer.
+*/
+stackinterpreter::BufferedWriter& stackinterpreter::BufferedWriter::operator<<(qint64 value) noexcept{
+    char digits[24];
+    const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    return write(digits, static_cast<qsizetype>(result.ptr - digits));
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class BufferedWriter
+ * @brief Write the buffered bytes to the file.
+ * @return False if the file could not be opened or a write failed.
+*/
+bool stackinterpreter::BufferedWriter::flush() noexcept{
+    if(!file || failed){
+        used = 0;
+        return false;
+    }
+    if(used && std::fwrite(buffer.data(), 1, static_cast<size_t>(used), file) != static_cast<size_t>(used))
+        failed = true;
+    used = 0;
+    return !failed;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class BufferedWriter
+ * @brief Write the buffered bytes and close the file.
+ * @return False if the file could not be opened or any write failed.
+*/
+bool stackinterpreter::BufferedWriter::close() noexcept{
+    if(!file)
+        return false;
+    flush();
+    if(std::fclose(file) != 0)
+        failed = true;
+    file = nullptr;
+    return !failed;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class BufferedWriter
+ * @brief Slow path of write(): the data does not fit in the free part of the buffer.
+ * @param data - Bytes to be written.
+ * @param size - Number of bytes.
+ * @return Reference to the writer.
+ * @details The buffer is flushed first, data larger than the whole buffer is written directly.
+*/
+stackinterpreter::BufferedWriter& stackinterpreter::BufferedWriter::write_through(const char *data, qsizetype size) noexcept{
+    if(!flush())
+        return *this;
+    if(size >= buffer.size()){
+        if(std::fwrite(data, 1, static_cast<size_t>(size), file) != static_cast<size_t>(size))
+            failed = true;
+        return *this;
+    }
+    std::memcpy(buffer.data(), data, static_cast<size_t>(size));
+    used = size;
+    return *this;
+}
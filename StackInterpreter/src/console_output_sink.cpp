@@ -0,0 +1,37 @@
+/**
+ * @file console_output_sink.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/console_output_sink.h"
+
+/**
+ * @namespace stackinterpreter
+ * @class ConsoleOutputSink
+ * @brief Buffer the values, one per line, appending them once a batch is full.
+ * @param values - Printed values.
+ * @param count - Number of values.
+*/
+void stackinterpreter::ConsoleOutputSink::write(const int *values, qsizetype count){
+    for(qsizetype i = 0; i < count; ++i){
+        pending += QString::number(values[i]);
+        pending += '\n';
+        if(++pending_values == batch_size)
+            static_cast<void>(flush());
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class ConsoleOutputSink
+ * @brief Append the buffered lines to the console in a single block.
+ * @return Always true.
+*/
+bool stackinterpreter::ConsoleOutputSink::flush(){
+    if(pending.isEmpty())
+        return true;
+    pending.chop(1); // appendPlainText() starts a new line itself
+    console->appendPlainText(pending);
+    pending.clear();
+    pending_values = 0;
+    return true;
+}
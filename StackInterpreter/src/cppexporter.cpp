@@ -1,101 +1,76 @@
 #include "../headers/cppexporter.h"
-#include <fstream>
-#include <QVector>
-#include <QStringList>
-#include <QDir>
+#include "../headers/buffered_writer.h"
+#include <QFile>
 
 /**
  * @namespace stackinterpreter
- * @class ASMExporter @extends Exporter
+ * @class CPPExporter @extends Exporter
  * @name export_to_file
- * @brief Create a .cpp (C++ file) based on the current stack and operations log
- * @param instruction_log
- * @return true if successfully exported, else false
+ * @brief Create a .cpp (C++ file) replaying an instruction sequence on a std::stack
+ * @param code - Straight line instruction sequence (EX: Trace::executed_code()), exported up to the first HLT
+ * @return true if successfully exported, else false (Control flow instructions can not be exported)
  */
-bool stackinterpreter::CPPExporter::export_to_file(const QVector<QString> &instruction_log) const{
-    if(!instruction_log.size())
+bool stackinterpreter::CPPExporter::export_to_file(const QVector<stackinterpreter::bytecode_cell> &code) const{
+    if(!code.size())
         return false;
-    try{
-        std::ofstream cppfile(filename.toStdString().c_str());
-        cppfile << "#include <iostream>\n#include <stack>\n\nint main(){\n    std::stack<int> stack;\n";
-        bool is_declared = false;
-        for(const QString &instruction : instruction_log){
-            QStringList parsed = instruction.split("    ");
-            if(parsed[0] == "PUSHI")
-                cppfile << "    stack.push(" << parsed[1].toInt() << ");\n";
-            else if(parsed[0] == "PUSH")
-                cppfile << "    stack.pop(); /* PUSHED A VALUE FROM THE STACK TO MEMORY IN THE ADDRESS: " << parsed[1].toInt() << " */\n";
-            else if(parsed[0] == "POP")
-                cppfile << "    stack.push(" << parsed[1].toInt() << "); /* PUSHED A VALUE THAT WAS ON MEMORY TO THE STACK: " << parsed[1].toInt() << " */\n";
-            else if(parsed[0] == "INPUT")
-                cppfile << "    stack.push(" << parsed[1].toInt() << ");\n";
-            else if(parsed[0] == "ADD"){
-                if(!is_declared){
-                    cppfile << "    int v1 = stack.top(); stack.pop();\n    int v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1 + v2);\n";
-                    is_declared = true;
+    stackinterpreter::BufferedWriter cppfile(filename);
+    cppfile << "#include <iostream>\n#include <stack>\n\nint main(){\n    std::stack<int> stack;\n    int v1, v2;\n";
+    for(const stackinterpreter::bytecode_cell &cell : code){
+        if(cell.opcode == stackinterpreter::Instructions::HLT)
+            break;
+        switch(cell.opcode){
+            case stackinterpreter::Instructions::PUSHI:
+                cppfile << "    stack.push(" << cell.operand << ");\n";
+                break;
+            case stackinterpreter::Instructions::PUSH:
+                cppfile << "    stack.pop(); /* PUSHED A VALUE FROM THE STACK TO MEMORY IN THE ADDRESS: " << cell.operand << " */\n";
+                break;
+            case stackinterpreter::Instructions::POP:
+                cppfile << "    stack.push(" << cell.operand << "); /* PUSHED A VALUE THAT WAS ON MEMORY TO THE STACK: " << cell.operand << " */\n";
+                break;
+            case stackinterpreter::Instructions::INPUT:
+                cppfile << "    std::cin >> v1;\n    stack.push(v1);\n";
+                break;
+            case stackinterpreter::Instructions::INPUTN:
+                if(cell.operand < 0){
+                    (void)cppfile.close();
+                    QFile::remove(filename);
+                    return false;
                 }
-                else{
-                    cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1 + v2);\n";
-                }
-            }
-            else if(parsed[0] == "SUB"){
-                if(!is_declared){
-                    cppfile << "    int v1 = stack.top(); stack.pop();\n    int v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1 - v2);\n";
-                    is_declared = true;
-                }
-                else{
-                    cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1 - v2);\n";
-                }
-            }
-            else if(parsed[0] == "MUL"){
-                if(!is_declared){
-                    cppfile << "    int v1 = stack.top(); stack.pop();\n    int v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1 * v2);\n";
-                    is_declared = true;
-                }
-                else{
-                    cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1 * v2);\n";
-                }
-            }
-            else if(parsed[0] == "DIV"){
-                if(!is_declared){
-                    cppfile << "    int v1 = stack.top(); stack.pop();\n    int v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1 / v2);\n";
-                    is_declared = true;
-                }
-                else{
-                    cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1 / v2);\n";
-                }
-            }
-            else if(parsed[0] == "SWAP"){
-                if(!is_declared){
-                    cppfile << "    int v1 = stack.top(); stack.pop();\n    int v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1);\n";
-                    cppfile << "    stack.push(v2);\n";
-                }
-                else{
-                    cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n";
-                    cppfile << "    stack.push(v1);\n";
-                    cppfile << "    stack.push(v2);\n";
-                }
-            }
-            else if(parsed[0] == "DUP")
+                cppfile << "    for(int i = 0; i < " << cell.operand << "; ++i){\n        std::cin >> v1;\n        stack.push(v1);\n    }\n";
+                break;
+            case stackinterpreter::Instructions::ADD:
+                cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n    stack.push(v1 + v2);\n";
+                break;
+            case stackinterpreter::Instructions::SUB:
+                cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n    stack.push(v1 - v2);\n";
+                break;
+            case stackinterpreter::Instructions::MUL:
+                cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n    stack.push(v1 * v2);\n";
+                break;
+            case stackinterpreter::Instructions::DIV:
+                cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n    stack.push(v1 / v2);\n";
+                break;
+            case stackinterpreter::Instructions::SWAP:
+                cppfile << "    v1 = stack.top(); stack.pop();\n    v2 = stack.top(); stack.pop();\n    stack.push(v1);\n    stack.push(v2);\n";
+                break;
+            case stackinterpreter::Instructions::DUP:
                 cppfile << "    stack.push(stack.top());\n";
-            else if(parsed[0] == "DROP")
-                cppfile << "    stack.pop();\n";
-            else if(parsed[0] == "PRINT")
+                break;
+            case stackinterpreter::Instructions::DROP:
+            case stackinterpreter::Instructions::PRINT:
                 cppfile << "    stack.pop();\n";
+                break;
+            default: // Control flow or invalid instruction
+                (void)cppfile.close();
+                QFile::remove(filename);
+                return false;
         }
-        cppfile << "    return 0;\n}";
-        return true;
-    } catch(const std::exception &exception){
+    }
+    cppfile << "    return 0;\n}";
+    if(!cppfile.close()){
         QFile::remove(filename);
         return false;
     }
+    return true;
 }
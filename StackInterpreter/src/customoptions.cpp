@@ -1,4 +1,5 @@
 #include "../headers/customoptions.h"
+#include "../headers/stack.h"
 #include "qlabel.h"
 #include "qpushbutton.h"
 #include <QVBoxLayout>
@@ -22,8 +23,8 @@ stackinterpreter::CustomOptions::CustomOptions(QWidget *parent) : QDialog(parent
     input1 = new QLineEdit(this);
     input2 = new QLineEdit(this);
 
-    input1->setPlaceholderText("Min: Number of actual elements in the stack - Max: 10000");
-    input2->setPlaceholderText("Min: 256 - Max: 10000");
+    input1->setPlaceholderText("Min: Number of actual elements in the stack - Max: " + QString::number(stackinterpreter::Stack::max_possible_size));
+    input2->setPlaceholderText("Min: 256 - Max: " + QString::number(stackinterpreter::Memory::max_possible_mem_size));
 
     QHBoxLayout *input1_layout = new QHBoxLayout;
     input1_layout->addWidget(label1);
@@ -0,0 +1,25 @@
+/**
+ * @file dialog_input_source.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/dialog_input_source.h"
+#include "QInputDialog"
+
+/**
+ * @namespace stackinterpreter
+ * @class DialogInputSource
+ * @brief Show one dialog per value.
+ * @param values - Receives the values.
+ * @param count - Number of values asked.
+ * @return The number of values typed before the user canceled (count if none was canceled).
+*/
+qsizetype stackinterpreter::DialogInputSource::read(int *values, qsizetype count){
+    for(qsizetype i = 0; i < count; ++i){
+        bool ok = true;
+        const QString label = count == 1 ? "Number:" : "Number " + QString::number(i + 1) + " of " + QString::number(count) + ":";
+        values[i] = QInputDialog::getInt(parent, "Type a number", label, 0, -2147483647, 2147483647, 1, &ok);
+        if(!ok)
+            return i;
+    }
+    return count;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file input_source.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/input_source.h"
+#include <QFile>
+#include <QtEndian>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define STACKINTERPRETER_POSIX_READ
+#include <unistd.h>
+#endif
+
+namespace{
+
+/// @brief Check if a byte separates two values
+bool is_space(char c) noexcept{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+} // namespace
+
+/**
+ * @namespace stackinterpreter
+ * @class InputSource
+ * @brief Append a chunk of values to the input buffers (The consumed values are dropped first).
+ * @param io - Buffers read by the run loops.
+ * @param chunk - Max number of values read from the source.
+ * @return False if the source had no value left.
+*/
+bool stackinterpreter::InputSource::refill(stackinterpreter::io_buffers &io, qsizetype chunk){
+    const qsizetype left = io.input.size() - io.input_position;
+    if(io.input_position)
+        std::copy(io.input.begin() + io.input_position, io.input.end(), io.input.begin());
+    io.input.resize(left + chunk);
+    const qsizetype added = read(io.input.data() + left, chunk);
+    io.input.resize(left + added);
+    io.input_position = 0;
+    return added > 0;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class BufferInputSource
+ * @brief Copy the next values of the buffer.
+ * @param destination - Receives the values.
+ * @param count - Max number of values.
+ * @return The number of values copied.
+*/
+qsizetype stackinterpreter::BufferInputSource::read(int *destination, qsizetype count){
+    const qsizetype copied = qMin(count, values.size() - position);
+    std::copy(values.constData() + position, values.constData() + position + copied, destination);
+    position += copied;
+    return copied;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TextInputSource
+ * @brief Constructor - Reads from an open stream.
+ * @param _file - Stream (nullptr is an exhausted source).
+ * @param _owned - True to close the stream in the destructor.
+*/
+stackinterpreter::TextInputSource::TextInputSource(std::FILE *_file, bool _owned) : file(_file), owned(_owned), buffer(read_size){}
+
+stackinterpreter::TextInputSource::~TextInputSource(){
+    if(file && owned)
+        std::fclose(file);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TextInputSource
+ * @brief Parse the next values of the stream.
+ * @param values - Receives the values.
+ * @param count - Max number of values.
+ * @return The number of values parsed, 0 once the stream is exhausted.
+ * @details Blocks only while no value was parsed yet, a token cut by the end of the buffer waits for the next block.
+*/
+qsizetype stackinterpreter::TextInputSource::read(int *values, qsizetype count){
+    qsizetype parsed = 0;
+    while(parsed < count){
+        while(begin < end && is_space(buffer[begin]))
+            ++begin;
+        qsizetype token = begin;
+        while(token < end && !is_space(buffer[token]))
+            ++token;
+        if(begin == end || (token == end && !at_end)){ // Nothing left, or a token that may go on in the next block
+            if(parsed || at_end || !fill())
+                break;
+            continue;
+        }
+        const char *first = buffer.constData() + begin, *last = buffer.constData() + token;
+        if(*first == '+' && last - first > 1 && first[1] != '-')
+            ++first;
+        int value;
+        const std::from_chars_result result = std::from_chars(first, last, value);
+        if(result.ec != std::errc() || result.ptr != last){
+            at_end = true; // Not an int, the source ends there
+            begin = end = 0;
+            break;
+        }
+        values[parsed++] = value;
+        begin = token;
+    }
+    return parsed;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TextInputSource
+ * @brief Read the next block of the stream after the bytes not parsed yet.
+ * @return False at the end of the stream (Or if a single token fills the whole buffer).
+*/
+bool stackinterpreter::TextInputSource::fill() noexcept{
+    if(!file){
+        at_end = true;
+        return false;
+    }
+    std::memmove(buffer.data(), buffer.constData() + begin, static_cast<size_t>(end - begin));
+    end -= begin;
+    begin = 0;
+    if(end == buffer.size()){
+        at_end = true;
+        return false;
+    }
+#ifdef STACKINTERPRETER_POSIX_READ
+    const ssize_t bytes = ::read(fileno(file), buffer.data() + end, static_cast<size_t>(buffer.size() - end)); // Returns what is available
+#else
+    const qsizetype bytes = static_cast<qsizetype>(std::fread(buffer.data() + end, 1, static_cast<size_t>(buffer.size() - end), file));
+#endif
+    if(bytes <= 0){
+        at_end = true;
+        return end > 0; // The last token has no separator after it
+    }
+    end += bytes;
+    return true;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TextFileInputSource
+ * @brief Constructor - Opens a text file (An exhausted source if it can not be opened, see is_open()).
+ * @param filename - Path of the file.
+*/
+stackinterpreter::TextFileInputSource::TextFileInputSource(const QString &filename) :
+    TextInputSource(std::fopen(filename.toStdString().c_str(), "rb"), true){}
+
+/**
+ * @namespace stackinterpreter
+ * @class BinaryFileInputSource
+ * @brief Constructor - Maps a binary file of little endian int32 values (An exhausted source if it can not be read, see is_open()).
+ * @param filename - Path of the file.
+*/
+stackinterpreter::BinaryFileInputSource::BinaryFileInputSource(const QString &filename){
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly))
+        return;
+    const qsizetype count = static_cast<qsizetype>(file.size() / static_cast<qint64>(sizeof(qint32)));
+    if(!values.resize(count))
+        return;
+    const qint64 bytes = count * static_cast<qint64>(sizeof(qint32));
+    opened = values.map_file(file.handle(), 0, count) || file.read(reinterpret_cast<char*>(values.data()), bytes) == bytes;
+    if(!opened)
+        static_cast<void>(values.resize(0));
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class BinaryFileInputSource
+ * @brief Copy the next values of the file.
+ * @param destination - Receives the values.
+ * @param count - Max number of values.
+ * @return The number of values copied.
+*/
+qsizetype stackinterpreter::BinaryFileInputSource::read(int *destination, qsizetype count){
+    const qsizetype copied = qMin(count, values.size() - position);
+    std::memcpy(destination, values.constData() + position, static_cast<size_t>(copied) * sizeof(qint32));
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    for(qsizetype i = 0; i < copied; ++i)
+        destination[i] = qFromLittleEndian<qint32>(destination[i]);
+#endif
+    position += copied;
+    return copied;
+}
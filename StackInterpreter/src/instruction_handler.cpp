@@ -4,7 +4,20 @@
 */
 
 #include "../headers/instruction_handler.h"
-#include <QMessageBox>
+#include "../headers/input_source.h"
+#include "../headers/output_sink.h"
+
+/**
+ * @namespace stackinterpreter
+ * @class io_buffers
+ * @brief Hand the buffered output to the sink (Kept in output if there is no sink).
+*/
+void stackinterpreter::io_buffers::drain_output(){
+    if(!sink || output.isEmpty())
+        return;
+    sink->write(output.constData(), output.size());
+    output.clear();
+}
 
 /**
  * @namespace stackintrepreter
@@ -12,15 +25,13 @@
  * @brief Handles the interpretation of instruction types and values.
  * @param enumtype - Enum representing the instruction type.
  * @param val - QString representing the value associated with the instruction.
- * @return A tuple containing the interpreted instruction type and value.
+ * @return A tuple containing the interpreted instruction type and value (Instructions::ERROR if the value is not valid).
 */
 stackinterpreter::instruction_tuple stackinterpreter::InstructionHandler::handle_instruction(int enumtype, const QString &val) noexcept{
     switch(enumtype){
         case stackinterpreter::Instructions::PUSHI:
-            if(!is_valid_number(val)){
-                QMessageBox::critical(nullptr, "Error!", "Type a valid number!");
+            if(!is_valid_number(val))
                 return stackinterpreter::instruction_tuple(stackinterpreter::Instructions::ERROR, -1);
-            }
             return stackinterpreter::instruction_tuple(stackinterpreter::Instructions::PUSHI, val.toInt());
 
         case stackinterpreter::Instructions::PUSH:
@@ -44,6 +55,11 @@ stackinterpreter::instruction_tuple stackinterpreter::InstructionHandler::handle
         case stackinterpreter::Instructions::INPUT:
             return stackinterpreter::instruction_tuple(stackinterpreter::Instructions::INPUT, -1);
 
+        case stackinterpreter::Instructions::INPUTN:
+            if(!is_valid_number(val) || val.toInt() < 0)
+                return stackinterpreter::instruction_tuple(stackinterpreter::Instructions::ERROR, -1);
+            return stackinterpreter::instruction_tuple(stackinterpreter::Instructions::INPUTN, val.toInt());
+
         case stackinterpreter::Instructions::DROP:
             return stackinterpreter::instruction_tuple(stackinterpreter::Instructions::DROP, -1);
 
@@ -68,71 +84,181 @@ stackinterpreter::instruction_tuple stackinterpreter::InstructionHandler::handle
  * @namespace stackintrepreter
  * @class InstructionHandler
  * @brief Execute the instruction by calling the correct member function based on the enumtype
- * @param parent - Widget wich will be displayed the action.
  * @param stack - Instance of Stack class that will call the member functions.
  * @param enumtype - Enum representing the instruction type.
- * @param value - Representing the value that will be part of an instruction (EX: PUSHI 18 (18 is the value param)).
- * @param handler - Instance of InstructionHandler class used to get the instruction log.
- * @param description - Description of the instruction to save in the log.
+ * @param value - Representing the value that will be part of an instruction (EX: PUSHI 18 (18 is the value param)), INPUT reads the value from it (Unless an input source is set) and PRINT writes the printed value to it (And to the output sink if one is set).
+ * @param handler - Instance of InstructionHandler class wich owns the trace.
+ * @return Trap raised by the instruction, Trap::NONE if it was successfully executed.
+ * @details INPUTN (value is the count) always reads from the input source, Trap::WAITING_INPUT if it runs short.
 */
-void stackinterpreter::InstructionHandler::execute(QWidget* parent, stackinterpreter::Stack &stack, int enumtype, int value, InstructionHandler &handler, const QString &description) noexcept{
+stackinterpreter::Trap stackinterpreter::InstructionHandler::execute(stackinterpreter::Stack &stack, int enumtype, int &value, InstructionHandler &handler) noexcept{
     switch(enumtype){
         case stackinterpreter::Instructions::PUSHI:
-            stack.PUSHI(value, description, handler.get_log());
-            break;
+            return stack.PUSHI(value, handler.get_trace());
 
         case stackinterpreter::Instructions::PUSH:
-            stack.PUSH(value, description, handler.get_log());
-            break;
+            return stack.PUSH(value, handler.get_trace());
 
         case stackinterpreter::Instructions::POP:
-            stack.POP(value, description, handler.get_log());
-            break;
+            return stack.POP(value, handler.get_trace());
 
         case stackinterpreter::Instructions::ADD:
-            stack.ADD(description, handler.get_log());
-            break;
+            return stack.ADD(handler.get_trace());
 
         case stackinterpreter::Instructions::SUB:
-            stack.SUB(description, handler.get_log());
-            break;
+            return stack.SUB(handler.get_trace());
 
         case stackinterpreter::Instructions::MUL:
-            stack.MUL(description, handler.get_log());
-            break;
+            return stack.MUL(handler.get_trace());
 
         case stackinterpreter::Instructions::DIV:
-            stack.DIV(description, handler.get_log());
-            break;
+            return stack.DIV(handler.get_trace());
 
-        case stackinterpreter::Instructions::PRINT:
-            stack.PRINT(parent, description, handler.get_log());
-            break;
+        case stackinterpreter::Instructions::PRINT:{
+            const stackinterpreter::Trap trap = stack.PRINT(value, handler.get_trace());
+            if(trap == stackinterpreter::Trap::NONE && output_sink)
+                output_sink->write(&value, 1);
+            return trap;
+        }
 
         case stackinterpreter::Instructions::DUP:
-            stack.DUP(description, handler.get_log());
-            break;
+            return stack.DUP(handler.get_trace());
 
         case stackinterpreter::Instructions::SWAP:
-            stack.SWAP(description, handler.get_log());
-            break;
-
-        case stackinterpreter::Instructions::INPUT:
-            stack.INPUT(parent, description, handler.get_log());
-            break;
+            return stack.SWAP(handler.get_trace());
+
+        case stackinterpreter::Instructions::INPUT: // Nothing is read if the stack is full
+            if(stack.get_size() == stack.get_max_size())
+                return stackinterpreter::Trap::STACK_OVERFLOW;
+            if(input_source && input_source->read(&value, 1) != 1)
+                return stackinterpreter::Trap::WAITING_INPUT;
+            return stack.INPUT(value, handler.get_trace());
+
+        case stackinterpreter::Instructions::INPUTN:{
+            if(value < 0)
+                return stackinterpreter::Trap::INVALID_OPERAND;
+            if(value > stack.get_max_size() - stack.get_size())
+                return stackinterpreter::Trap::STACK_OVERFLOW;
+            QVector<int> values(value);
+            if(!input_source || input_source->read(values.data(), value) != value)
+                return stackinterpreter::Trap::WAITING_INPUT;
+            return stack.INPUTN(values.constData(), value, handler.get_trace());
+        }
 
         case stackinterpreter::Instructions::DROP:
-            stack.DROP(description, handler.get_log());
-            break;
+            return stack.DROP(handler.get_trace());
 
         case stackinterpreter::Instructions::HLT:
-            stack.HLT(description, handler.get_log());
-            handler.clear_log();
-            break;
+            stack.HLT(handler.get_trace());
+            handler.clear_trace();
+            return stackinterpreter::Trap::NONE;
+
+        case stackinterpreter::Instructions::ERROR:
+            return stackinterpreter::Trap::INVALID_OPERAND;
 
         default:
+            return stackinterpreter::Trap::INVALID_INSTRUCTION;
+    }
+}
+
+/**
+ * @namespace stackintrepreter
+ * @class InstructionHandler
+ * @brief Run an assembled program until HLT (or the end of the program), a trap or a missing input value.
+ * @details Control flow instructions (JMP, JZ, JNZ, CALL, RET) are only available here, execute() runs a single instruction without a program counter.
+ * @param stack - Instance of Stack class that will execute the program.
+ * @param program - Pre-decoded program (No operand parsing while running).
+ * @param pc - Offset of the first instruction to be executed (0 to start, run_result::pc to resume).
+ * @param io - Values consumed by INPUT and written by PRINT.
+ * @param limit - Max number of instructions executed, the run stops with Trap::INTERRUPTED once it is reached (Step N).
+ * @return The trap that stopped the run, where it stopped and how many instructions were executed.
+ * @details The interrupt flag (set_interrupt()) is only read on taken branches (Once per basic block).
+*/
+stackinterpreter::run_result stackinterpreter::InstructionHandler::run(stackinterpreter::Stack &stack, const stackinterpreter::Program &program, qsizetype pc, stackinterpreter::io_buffers &io,
+                                                                       quint64 limit) noexcept{
+    const QVector<stackinterpreter::bytecode_cell> &code = program.get_code();
+    stackinterpreter::run_result result;
+    while(pc < code.size()){
+        if(result.executed == limit){
+            result.trap = stackinterpreter::Trap::INTERRUPTED;
+            break;
+        }
+        const stackinterpreter::bytecode_cell &cell = code[pc];
+        if(cell.opcode < 0 || cell.opcode > stackinterpreter::Instructions::ERROR){
+            result.trap = stackinterpreter::Trap::INVALID_INSTRUCTION;
             break;
+        }
+        int value = cell.operand;
+        if(cell.opcode == stackinterpreter::Instructions::INPUT){ // Nothing is consumed if it traps (Overflow first, like the run loops)
+            if(stack.get_size() == stack.get_max_size()){
+                result.trap = stackinterpreter::Trap::STACK_OVERFLOW;
+                break;
+            }
+            if(io.input_position == io.input.size()){
+                result.trap = stackinterpreter::Trap::WAITING_INPUT;
+                break;
+            }
+            value = io.input[io.input_position++];
+        }
+        trace.set_pc(pc);
+        qsizetype next = pc + 1;
+        bool taken = true;
+        if(stackinterpreter::instruction_is_branch(cell.opcode) && (cell.operand < 0 || cell.operand > code.size())){
+            result.trap = stackinterpreter::Trap::INVALID_INSTRUCTION;
+            break;
+        }
+        switch(cell.opcode){
+            case stackinterpreter::Instructions::JMP:
+                trace.record(stackinterpreter::Instructions::JMP, cell.operand);
+                break;
+            case stackinterpreter::Instructions::JZ:
+                result.trap = stack.JZ(taken, trace);
+                break;
+            case stackinterpreter::Instructions::JNZ:
+                result.trap = stack.JNZ(taken, trace);
+                break;
+            case stackinterpreter::Instructions::CALL:
+                result.trap = stack.CALL(next, trace);
+                break;
+            case stackinterpreter::Instructions::RET:
+                result.trap = stack.RET(next, trace);
+                break;
+            case stackinterpreter::Instructions::INPUTN: // Nothing is consumed if it traps
+                if(cell.operand >= 0 && cell.operand <= stack.get_max_size() - stack.get_size() && io.input.size() - io.input_position < cell.operand){
+                    result.trap = stackinterpreter::Trap::WAITING_INPUT;
+                    break;
+                }
+                result.trap = stack.INPUTN(io.input.constData() + io.input_position, cell.operand, trace);
+                if(result.trap == stackinterpreter::Trap::NONE)
+                    io.input_position += cell.operand;
+                break;
+            case stackinterpreter::Instructions::INPUT: // The value comes from io, never from the input source of execute()
+                result.trap = stack.INPUT(value, trace);
+                break;
+            case stackinterpreter::Instructions::PRINT: // Written to io below, never to the output sink of execute()
+                result.trap = stack.PRINT(value, trace);
+                break;
+            default:
+                result.trap = execute(stack, cell.opcode, value, *this);
+                break;
+        }
+        if(result.trap != stackinterpreter::Trap::NONE)
+            break;
+        ++result.executed;
+        if(cell.opcode == stackinterpreter::Instructions::PRINT)
+            io.print(value);
+        else if(cell.opcode == stackinterpreter::Instructions::HLT)
+            break;
+        const bool jumped = (stackinterpreter::instruction_is_branch(cell.opcode) && taken) || cell.opcode == stackinterpreter::Instructions::RET;
+        pc = stackinterpreter::instruction_is_branch(cell.opcode) && taken ? cell.operand : next;
+        if(jumped && interrupt && Q_UNLIKELY(interrupt->load(std::memory_order_relaxed))){
+            result.trap = stackinterpreter::Trap::INTERRUPTED;
+            break;
+        }
     }
+    trace.set_pc(-1);
+    result.pc = pc;
+    return result;
 }
 
 /**
@@ -140,15 +266,13 @@ void stackinterpreter::InstructionHandler::execute(QWidget* parent, stackinterpr
  * @class InstructionHandler
  * @brief Convert (if possible) a hexadecimal number to an integer.
  * @param hex - QString representing the hexadecimal number.
- * @return Integer result of the hexadecimal conversion.
+ * @return Integer result of the hexadecimal conversion, -1 if the conversion fails (Raises Trap::INVALID_ADDRESS when executed).
 */
 int stackinterpreter::InstructionHandler::hex_to_int(const QString &hex) const noexcept{
     bool ok;
     int hex_integer = hex.toInt(&ok, 16);
-    if(!ok){
-        QMessageBox::critical(nullptr, "Error!", "Mismatch converting hexadecimal to a number!");
+    if(!ok)
         return -1;
-    }
     return hex_integer;
 }
 
@@ -164,11 +288,3 @@ bool stackinterpreter::InstructionHandler::is_valid_number(const QString &numstr
     numstr.toInt(&ok);
     return ok;
 }
-
-///@brief Overloaded stream operator used to display the log properly in the mainwindow
-QTextEdit& stackinterpreter::operator<<(QTextEdit &os, stackinterpreter::InstructionHandler &handler){
-    QVector<QString>& log = handler.get_log();
-    for(const QString &entry : log)
-        os.append(entry);
-    return os;
-}
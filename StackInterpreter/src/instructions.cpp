@@ -0,0 +1,63 @@
+/**
+ * @file instructions.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/instructions.h"
+
+/**
+ * @namespace stackinterpreter
+ * @brief Return the mnemonic of an instruction (Used by the assembler and to describe the instructions in the log).
+ * @param opcode - Enum value of the instruction.
+ * @return The mnemonic, "ERROR" for an invalid opcode.
+*/
+const char* stackinterpreter::instruction_mnemonic(int opcode) noexcept{
+    switch(opcode){
+        case stackinterpreter::Instructions::PUSHI: return "PUSHI";
+        case stackinterpreter::Instructions::PUSH:  return "PUSH";
+        case stackinterpreter::Instructions::POP:   return "POP";
+        case stackinterpreter::Instructions::INPUT: return "INPUT";
+        case stackinterpreter::Instructions::PRINT: return "PRINT";
+        case stackinterpreter::Instructions::ADD:   return "ADD";
+        case stackinterpreter::Instructions::SUB:   return "SUB";
+        case stackinterpreter::Instructions::MUL:   return "MUL";
+        case stackinterpreter::Instructions::DIV:   return "DIV";
+        case stackinterpreter::Instructions::SWAP:  return "SWAP";
+        case stackinterpreter::Instructions::DROP:  return "DROP";
+        case stackinterpreter::Instructions::DUP:   return "DUP";
+        case stackinterpreter::Instructions::HLT:   return "HLT";
+        case stackinterpreter::Instructions::JMP:   return "JMP";
+        case stackinterpreter::Instructions::JZ:    return "JZ";
+        case stackinterpreter::Instructions::JNZ:   return "JNZ";
+        case stackinterpreter::Instructions::CALL:  return "CALL";
+        case stackinterpreter::Instructions::RET:   return "RET";
+        case stackinterpreter::Instructions::INPUTN: return "INPUTN";
+        default:                                    return "ERROR";
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @brief Check if an instruction needs an operand (EX: PUSHI 18 / PUSH 1f / POP 1f / JMP loop / INPUTN 4).
+ * @param opcode - Enum value of the instruction.
+ * @return True if the instruction needs an operand, false otherwise.
+*/
+bool stackinterpreter::instruction_has_operand(int opcode) noexcept{
+    return opcode == stackinterpreter::Instructions::PUSHI ||
+           opcode == stackinterpreter::Instructions::PUSH  ||
+           opcode == stackinterpreter::Instructions::POP   ||
+           opcode == stackinterpreter::Instructions::INPUTN ||
+           instruction_is_branch(opcode);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @brief Check if the operand of an instruction is a branch target (Absolute bytecode offset resolved at load time).
+ * @param opcode - Enum value of the instruction.
+ * @return True for JMP, JZ, JNZ and CALL, false otherwise.
+*/
+bool stackinterpreter::instruction_is_branch(int opcode) noexcept{
+    return opcode == stackinterpreter::Instructions::JMP ||
+           opcode == stackinterpreter::Instructions::JZ  ||
+           opcode == stackinterpreter::Instructions::JNZ ||
+           opcode == stackinterpreter::Instructions::CALL;
+}
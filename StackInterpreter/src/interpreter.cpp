@@ -0,0 +1,494 @@
+/**
+ * @file interpreter.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/interpreter.h"
+#include <algorithm>
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(STACKINTERPRETER_SWITCH_DISPATCH)
+#define STACKINTERPRETER_COMPUTED_GOTO
+#endif
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Load a program, opcodes out of the instruction set and branches out of the program are replaced by Instructions::ERROR (Traps when executed).
+ * @param program - Assembled program.
+ * @param optimize - Fuse the instruction pairs of the superinstruction table (PeepholeOptimizer).
+*/
+stackinterpreter::Interpreter::Interpreter(const Program &program, bool optimize) : code(program.get_code()), fused(0){
+    const qsizetype program_size = code.size();
+    for(stackinterpreter::bytecode_cell &cell : code){
+        if(cell.opcode < 0 || cell.opcode > stackinterpreter::Instructions::ERROR)
+            cell.opcode = stackinterpreter::Instructions::ERROR;
+        else if(stackinterpreter::instruction_is_branch(cell.opcode) && (cell.operand < 0 || cell.operand > program_size))
+            cell.opcode = stackinterpreter::Instructions::ERROR;
+    }
+    verified = verifier.verify(program);
+    if(optimize)
+        fused = stackinterpreter::PeepholeOptimizer().optimize(code); // After the verifier, superinstructions keep every offset
+    code.append(stackinterpreter::bytecode_cell(stackinterpreter::END_OF_PROGRAM, 0));
+}
+
+/// @brief Return true if the run loop uses computed goto dispatch
+bool stackinterpreter::Interpreter::threaded_dispatch() noexcept{
+#ifdef STACKINTERPRETER_COMPUTED_GOTO
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Run the loaded program until HLT (or the end of the program), a trap or a missing input value.
+ * @param stack - Instance of Stack class that will execute the program.
+ * @param pc - Offset of the first instruction to be executed (0 to start, run_result::pc to resume).
+ * @param io - Values consumed by INPUT and written by PRINT.
+ * @return The trap that stopped the run, where it stopped and how many instructions were executed.
+ * @details Same semantics (and traps) as InstructionHandler::run, without writing the instruction and memory logs.
+ *          The interrupt flag is only read on taken branches (Once per basic block), a run stopped by it resumes at
+ *          the branch target.
+*/
+stackinterpreter::run_result stackinterpreter::Interpreter::run(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept{
+    return resume(stack, pc, io, -1, -1);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Run the loaded program like run(), stopping before the instruction at target (Run to cursor, step over a CALL).
+ * @param stack - Instance of Stack class that will execute the program.
+ * @param pc - Offset of the first instruction to be executed.
+ * @param io - Values consumed by INPUT and written by PRINT.
+ * @param target - Offset where the run stops with Trap::BREAKPOINT (Out of the program: never).
+ * @param call_depth - The run only stops at target with at most call_depth return addresses (-1: at any depth), so a step
+ *                     over a recursive CALL stops in the caller.
+ * @return Same as run(), a run stopped at target or at a breakpoint reports Trap::BREAKPOINT with its offset.
+ * @details The target is patched like a breakpoint while the run lasts.
+*/
+stackinterpreter::run_result stackinterpreter::Interpreter::run_to(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io, qsizetype target, qsizetype call_depth) noexcept{
+    if(target < 0 || target >= size())
+        return resume(stack, pc, io, -1, -1);
+    patch(target, stops);
+    const stackinterpreter::run_result result = resume(stack, pc, io, target, call_depth);
+    for(auto it = stops.cbegin(); it != stops.cend(); ++it)
+        code[it.key()].opcode = it.value();
+    stops.clear();
+    return result;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Stop the runs before the instruction at pc (Trap::BREAKPOINT), its cell opcode is replaced by BREAKPOINT.
+ * @param pc - Offset of the instruction.
+ * @return False if pc is out of the program.
+*/
+bool stackinterpreter::Interpreter::set_breakpoint(qsizetype pc) noexcept{
+    if(pc < 0 || pc >= size())
+        return false;
+    patch(pc, breakpoints);
+    return true;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Remove a breakpoint, its cell gets its opcode back.
+ * @param pc - Offset of the instruction.
+*/
+void stackinterpreter::Interpreter::clear_breakpoint(qsizetype pc) noexcept{
+    if(breakpoints.contains(pc))
+        code[pc].opcode = breakpoints.take(pc);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Remove every breakpoint.
+*/
+void stackinterpreter::Interpreter::clear_breakpoints() noexcept{
+    for(auto it = breakpoints.cbegin(); it != breakpoints.cend(); ++it)
+        code[it.key()].opcode = it.value();
+    breakpoints.clear();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Return the offsets of the breakpoints, in ascending order.
+*/
+QList<qsizetype> stackinterpreter::Interpreter::get_breakpoints() const{
+    QList<qsizetype> offsets = breakpoints.keys();
+    std::sort(offsets.begin(), offsets.end());
+    return offsets;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Return the opcode a cell has without its breakpoint (Or run_to target).
+*/
+qint32 stackinterpreter::Interpreter::original_opcode(qsizetype pc) const noexcept{
+    return breakpoints.value(pc, stops.value(pc, code[pc].opcode));
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Replace the opcode of a cell by BREAKPOINT (Nothing to do if it already is).
+ * @param pc - Offset of the cell.
+ * @param patched - Receives the replaced opcode.
+ * @details The second instruction of a superinstruction never dispatches when the pair is run from its first one, so
+ *          the previous cell is split back to its first instruction (Until the program is loaded again).
+*/
+void stackinterpreter::Interpreter::patch(qsizetype pc, QHash<qsizetype, qint32> &patched) noexcept{
+    if(code[pc].opcode == stackinterpreter::BREAKPOINT)
+        return;
+    if(pc > 0){
+        qint32 &previous = breakpoints.contains(pc - 1) ? breakpoints[pc - 1] : stops.contains(pc - 1) ? stops[pc - 1] : code[pc - 1].opcode;
+        previous = stackinterpreter::PeepholeOptimizer::split(previous);
+    }
+    patched.insert(pc, code[pc].opcode);
+    code[pc].opcode = stackinterpreter::BREAKPOINT;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Run the loaded program from pc, stepping over the breakpoint it starts at (See run_to for target and call_depth).
+*/
+stackinterpreter::run_result stackinterpreter::Interpreter::resume(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io, qsizetype target, qsizetype call_depth) noexcept{
+    stackinterpreter::run_result result;
+    if(pc < 0 || pc > size()){
+        result.trap = stackinterpreter::Trap::INVALID_INSTRUCTION;
+        result.pc = pc;
+        return result;
+    }
+    quint64 executed = 0;
+    for(;;){
+        if(code[pc].opcode == stackinterpreter::BREAKPOINT){ // Runs the instruction alone with its opcode, then patches the cell again
+            code[pc].opcode = original_opcode(pc);
+            result = !profile ? run_policy<true, stackinterpreter::NoProfiling>(stack, pc, io) : profile->is_timed() ? run_policy<true, stackinterpreter::Profiling<true>>(stack, pc, io)
+                                                                                                                   : run_policy<true, stackinterpreter::Profiling<false>>(stack, pc, io);
+            code[pc].opcode = stackinterpreter::BREAKPOINT;
+            executed += result.executed;
+            pc = result.pc;
+            if(result.trap != stackinterpreter::Trap::INTERRUPTED || (interrupt && interrupt->load(std::memory_order_relaxed)))
+                break;
+        }
+        result = !profile ? run_policy<false, stackinterpreter::NoProfiling>(stack, pc, io) : profile->is_timed() ? run_policy<false, stackinterpreter::Profiling<true>>(stack, pc, io)
+                                                                                                                : run_policy<false, stackinterpreter::Profiling<false>>(stack, pc, io);
+        executed += result.executed;
+        pc = result.pc;
+        if(result.trap != stackinterpreter::Trap::BREAKPOINT || pc != target || breakpoints.contains(pc) || call_depth < 0 || stack.return_stack.size() <= call_depth)
+            break;
+        // The target reached in a deeper call (Recursion), the run goes on
+    }
+    result.executed = executed;
+    return result;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Check if the verified depths hold for the current stack, so the run can skip the stack checks.
+ * @param stack - Stack that will execute the program.
+ * @param pc - Offset where the run starts.
+ * @return True if the run can not overflow/underflow the stack or the return stack.
+ * @details Only the main program depths are known, so a run resumed inside a subroutine (Non empty return stack) is checked.
+*/
+bool stackinterpreter::Interpreter::can_run_unchecked(const stackinterpreter::Stack &stack, qsizetype pc) const noexcept{
+    if(!verified || !stack.return_stack.empty() || pc >= verifier.get_depths().size())
+        return false;
+    const qint32 relative_depth = verifier.get_depths()[pc];
+    if(relative_depth == stackinterpreter::Verifier::UNKNOWN_DEPTH)
+        return false;
+    const qsizetype entry_depth = stack.depth - relative_depth; // Depth the program had at pc 0
+    return entry_depth >= verifier.get_required_depth() &&
+           entry_depth + verifier.get_max_growth() <= stack.max_size &&
+           verifier.get_max_call_nesting() <= stack.max_call_depth;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Pick the run loop instantiation of a run: checked or not (Single steps are always checked), tracking the writes or not.
+*/
+template<bool Single, class Policy>
+stackinterpreter::run_result stackinterpreter::Interpreter::run_policy(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept{
+    if(Single)
+        return track_writes ? run_loop<true, true, true, Policy>(stack, pc, io) : run_loop<true, false, true, Policy>(stack, pc, io);
+    const bool unchecked = can_run_unchecked(stack, pc);
+    if(track_writes)
+        return unchecked ? run_loop<false, true, false, Policy>(stack, pc, io) : run_loop<true, true, false, Policy>(stack, pc, io);
+    return unchecked ? run_loop<false, false, false, Policy>(stack, pc, io) : run_loop<true, false, false, Policy>(stack, pc, io);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Interpreter
+ * @brief Run loop, Checked = false removes the stack overflow/underflow and return stack checks (Verified programs only).
+ * @details Tracked = true marks the memory slots written by PUSH and POP as dirty (Untracked runs leave the dirty bits as they are).
+ *          Single = true stops after one dispatch (Trap::INTERRUPTED at the next instruction), used to resume from a breakpoint.
+ *          Policy receives the executed instructions and the taken branches (NoProfiling or Profiling, see profiler.h).
+*/
+template<bool Checked, bool Tracked, bool Single, class Policy>
+stackinterpreter::run_result stackinterpreter::Interpreter::run_loop(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept{
+    stackinterpreter::run_result result;
+    /// The stack values live in the flat buffer [stack_base, sp), the top of stack is cached in tos (Its buffer slot, sp[-1], is stale while running)
+    int *const stack_base = stack.buffer.data() + 1;
+    int *const stack_limit = stack_base + stack.max_size;
+    int *sp = stack_base + stack.depth;
+    int tos = stack.depth ? sp[-1] : 0;
+    QStack<qsizetype> &return_stack = stack.return_stack;
+    const qsizetype max_call_depth = stack.max_call_depth;
+    qint32 *const mem = stack.values.data();
+    quint64 *const occupancy = stack.occupancy.data();
+    quint64 *const dirty = stack.dirty.data();
+    const qsizetype mem_size = stack.max_mem_size;
+    const stackinterpreter::bytecode_cell *const base = code.constData();
+    const stackinterpreter::bytecode_cell *ip = base + pc;
+    quint64 executed = 0;
+    stackinterpreter::Trap trap = stackinterpreter::Trap::NONE;
+    static const std::atomic<bool> never(false);
+    const std::atomic<bool> &interrupted = interrupt ? *interrupt : never;
+    Policy policy(profile, pc);
+
+#ifdef STACKINTERPRETER_COMPUTED_GOTO
+    /// Indexed by opcode, must follow the order of the Instructions and InternalInstructions enums
+#define SUPERINSTRUCTION_LABEL(name, first, second) &&target_##name,
+    static const void *const dispatch_table[] = {
+        &&target_PUSHI, &&target_PUSH, &&target_POP, &&target_INPUT, &&target_PRINT,
+        &&target_ADD, &&target_SUB, &&target_MUL, &&target_DIV, &&target_SWAP,
+        &&target_DROP, &&target_DUP, &&target_HLT, &&target_JMP, &&target_JZ,
+        &&target_JNZ, &&target_CALL, &&target_RET, &&target_INPUTN, &&target_ERROR, &&target_END_OF_PROGRAM, &&target_BREAKPOINT,
+        STACKINTERPRETER_SUPERINSTRUCTIONS(SUPERINSTRUCTION_LABEL)
+    };
+#undef SUPERINSTRUCTION_LABEL
+    static_assert(sizeof(dispatch_table) / sizeof(dispatch_table[0]) == stackinterpreter::INTERNAL_INSTRUCTIONS_END, "dispatch_table must have one entry per opcode");
+#define TARGET(op) target_##op:
+#define DISPATCH() goto *dispatch_table[ip->opcode]
+#define DISPATCH_BEGIN DISPATCH();
+#define DISPATCH_END
+#else
+#define TARGET(op) case op:
+#define DISPATCH() continue
+#define DISPATCH_BEGIN for(;;){ switch(ip->opcode){
+#define DISPATCH_END default: trap = stackinterpreter::Trap::INVALID_INSTRUCTION; goto stop; } }
+    using stackinterpreter::Instructions::PUSHI; using stackinterpreter::Instructions::PUSH; using stackinterpreter::Instructions::POP;
+    using stackinterpreter::Instructions::INPUT; using stackinterpreter::Instructions::PRINT; using stackinterpreter::Instructions::ADD;
+    using stackinterpreter::Instructions::SUB; using stackinterpreter::Instructions::MUL; using stackinterpreter::Instructions::DIV;
+    using stackinterpreter::Instructions::SWAP; using stackinterpreter::Instructions::DROP; using stackinterpreter::Instructions::DUP;
+    using stackinterpreter::Instructions::HLT; using stackinterpreter::Instructions::JMP; using stackinterpreter::Instructions::JZ;
+    using stackinterpreter::Instructions::JNZ; using stackinterpreter::Instructions::CALL; using stackinterpreter::Instructions::RET;
+    using stackinterpreter::Instructions::INPUTN; using stackinterpreter::Instructions::ERROR;
+#endif
+    /// cell is the instruction being executed: ip for a single instruction, ip + 1 for the second half of a superinstruction
+#define ADVANCE(n) { \
+        policy.executed(ip - base, (n)); \
+        executed += (n); \
+        ip += (n); \
+        if(Single){ trap = stackinterpreter::Trap::INTERRUPTED; goto stop; } \
+        DISPATCH(); }
+#define JUMP_AT(cell, target) { \
+        const qsizetype jump_target = (target); /* Read once (RET pops it) */ \
+        policy.executed(ip - base, (cell) - ip + 1); \
+        policy.branch((cell) - base, jump_target); \
+        executed += (cell) - ip + 1; \
+        ip = base + jump_target; \
+        if(Single || Q_UNLIKELY(interrupted.load(std::memory_order_relaxed))){ trap = stackinterpreter::Trap::INTERRUPTED; goto stop; } \
+        DISPATCH(); }
+#define HALT_AT(cell) { policy.executed(ip - base, (cell) - ip + 1); executed += (cell) - ip + 1; ip = (cell); goto stop; }
+#define RAISE_AT(cell, t) { policy.executed(ip - base, (cell) - ip); executed += (cell) - ip; ip = (cell); trap = (t); goto stop; }
+
+    /// Instruction handlers, a handler either falls through or leaves through JUMP_AT, HALT_AT or RAISE_AT
+#define STEP_PUSHI(cell) { \
+        if(Checked && sp == stack_limit) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_OVERFLOW); \
+        sp[-1] = tos; /* Spills the old top (Writes the scratch slot when the stack is empty) */ \
+        tos = (cell)->operand; \
+        ++sp; }
+#define STEP_PUSH(cell) { \
+        if(Checked && sp == stack_base) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_UNDERFLOW); \
+        const qint32 address = (cell)->operand; \
+        if(address < 0 || address >= mem_size) \
+            RAISE_AT(cell, stackinterpreter::Trap::INVALID_ADDRESS); \
+        mem[address] = tos; \
+        occupancy[address >> 6] |= quint64(1) << (address & 63); \
+        if(Tracked) \
+            dirty[address >> 12] |= quint64(1) << ((address >> 6) & 63); \
+        --sp; \
+        tos = sp[-1]; }
+#define STEP_POP(cell) { \
+        if(Checked && sp == stack_limit) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_OVERFLOW); \
+        const qint32 address = (cell)->operand; \
+        if(address < 0 || address >= mem_size) \
+            RAISE_AT(cell, stackinterpreter::Trap::INVALID_ADDRESS); \
+        if(!((occupancy[address >> 6] >> (address & 63)) & 1)) \
+            RAISE_AT(cell, stackinterpreter::Trap::EMPTY_MEMORY_SLOT); \
+        sp[-1] = tos; \
+        tos = mem[address]; \
+        ++sp; \
+        occupancy[address >> 6] &= ~(quint64(1) << (address & 63)); \
+        if(Tracked) \
+            dirty[address >> 12] |= quint64(1) << ((address >> 6) & 63); }
+#define STEP_INPUT(cell) { \
+        if(Checked && sp == stack_limit) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_OVERFLOW); \
+        if(io.input_position == io.input.size()) \
+            RAISE_AT(cell, stackinterpreter::Trap::WAITING_INPUT); \
+        sp[-1] = tos; \
+        tos = io.input[io.input_position++]; \
+        ++sp; }
+#define STEP_INPUTN(cell) { \
+        const qint32 count = (cell)->operand; \
+        if(count < 0) \
+            RAISE_AT(cell, stackinterpreter::Trap::INVALID_OPERAND); \
+        if(Checked && stack_limit - sp < count) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_OVERFLOW); \
+        if(io.input.size() - io.input_position < count) \
+            RAISE_AT(cell, stackinterpreter::Trap::WAITING_INPUT); \
+        sp[-1] = tos; \
+        std::copy(io.input.constData() + io.input_position, io.input.constData() + io.input_position + count, sp); \
+        sp += count; \
+        tos = sp[-1]; \
+        io.input_position += count; }
+#define STEP_PRINT(cell) { \
+        if(Checked && sp == stack_base) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_UNDERFLOW); \
+        io.print(tos); \
+        --sp; \
+        tos = sp[-1]; }
+#define STEP_BINARY(cell, expression) { \
+        if(Checked && sp - stack_base < 2) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_UNDERFLOW); \
+        --sp; \
+        tos = expression; }
+#define STEP_ADD(cell) STEP_BINARY(cell, stackinterpreter::wrapping_add(sp[-1], tos))
+#define STEP_SUB(cell) STEP_BINARY(cell, stackinterpreter::wrapping_sub(sp[-1], tos))
+#define STEP_MUL(cell) STEP_BINARY(cell, stackinterpreter::wrapping_mul(sp[-1], tos))
+#define STEP_DIV(cell) { \
+        if(Checked && sp - stack_base < 2) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_UNDERFLOW); \
+        if(tos == 0) \
+            RAISE_AT(cell, stackinterpreter::Trap::DIVISION_BY_ZERO); \
+        --sp; \
+        tos = stackinterpreter::wrapping_div(sp[-1], tos); }
+#define STEP_SWAP(cell) { \
+        if(Checked && sp - stack_base < 2) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_UNDERFLOW); \
+        const int value = sp[-2]; \
+        sp[-2] = tos; \
+        tos = value; }
+#define STEP_DROP(cell) { \
+        if(Checked && sp == stack_base) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_UNDERFLOW); \
+        --sp; \
+        tos = sp[-1]; }
+#define STEP_DUP(cell) { \
+        if(Checked && sp == stack_base) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_UNDERFLOW); \
+        if(Checked && sp == stack_limit) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_OVERFLOW); \
+        sp[-1] = tos; \
+        ++sp; }
+#define STEP_HLT(cell) { \
+        sp = stack_base; \
+        return_stack.clear(); \
+        HALT_AT(cell); }
+#define STEP_JMP(cell) JUMP_AT(cell, (cell)->operand)
+#define STEP_CONDITIONAL_JUMP(cell, condition) { \
+        if(Checked && sp == stack_base) \
+            RAISE_AT(cell, stackinterpreter::Trap::STACK_UNDERFLOW); \
+        const int value = tos; \
+        --sp; \
+        tos = sp[-1]; \
+        if(condition) \
+            JUMP_AT(cell, (cell)->operand); }
+#define STEP_JZ(cell) STEP_CONDITIONAL_JUMP(cell, value == 0)
+#define STEP_JNZ(cell) STEP_CONDITIONAL_JUMP(cell, value != 0)
+#define STEP_CALL(cell) { \
+        if(Checked && return_stack.size() == max_call_depth) \
+            RAISE_AT(cell, stackinterpreter::Trap::CALL_STACK_OVERFLOW); \
+        return_stack.push((cell) - base + 1); \
+        JUMP_AT(cell, (cell)->operand); }
+#define STEP_RET(cell) { \
+        if(Checked && return_stack.empty()) \
+            RAISE_AT(cell, stackinterpreter::Trap::CALL_STACK_UNDERFLOW); \
+        JUMP_AT(cell, return_stack.pop()); }
+
+    DISPATCH_BEGIN
+
+    TARGET(PUSHI){ STEP_PUSHI(ip) ADVANCE(1) }
+    TARGET(PUSH){ STEP_PUSH(ip) ADVANCE(1) }
+    TARGET(POP){ STEP_POP(ip) ADVANCE(1) }
+    TARGET(INPUT){ STEP_INPUT(ip) ADVANCE(1) }
+    TARGET(PRINT){ STEP_PRINT(ip) ADVANCE(1) }
+    TARGET(ADD){ STEP_ADD(ip) ADVANCE(1) }
+    TARGET(SUB){ STEP_SUB(ip) ADVANCE(1) }
+    TARGET(MUL){ STEP_MUL(ip) ADVANCE(1) }
+    TARGET(DIV){ STEP_DIV(ip) ADVANCE(1) }
+    TARGET(SWAP){ STEP_SWAP(ip) ADVANCE(1) }
+    TARGET(DROP){ STEP_DROP(ip) ADVANCE(1) }
+    TARGET(DUP){ STEP_DUP(ip) ADVANCE(1) }
+    TARGET(HLT){ STEP_HLT(ip) }
+    TARGET(JMP){ STEP_JMP(ip) }
+    TARGET(JZ){ STEP_JZ(ip) ADVANCE(1) }
+    TARGET(JNZ){ STEP_JNZ(ip) ADVANCE(1) }
+    TARGET(CALL){ STEP_CALL(ip) }
+    TARGET(RET){ STEP_RET(ip) }
+    TARGET(INPUTN){ STEP_INPUTN(ip) ADVANCE(1) }
+    TARGET(ERROR){ RAISE_AT(ip, stackinterpreter::Trap::INVALID_INSTRUCTION); }
+    TARGET(END_OF_PROGRAM){ goto stop; }
+    TARGET(BREAKPOINT){ RAISE_AT(ip, stackinterpreter::Trap::BREAKPOINT); }
+
+    /// Superinstructions: both handlers back to back, the second one reads its operand from its own (untouched) cell
+#define SUPERINSTRUCTION_TARGET(name, first, second) TARGET(name){ STEP_##first(ip) STEP_##second(ip + 1) ADVANCE(2) }
+    STACKINTERPRETER_SUPERINSTRUCTIONS(SUPERINSTRUCTION_TARGET)
+#undef SUPERINSTRUCTION_TARGET
+
+    DISPATCH_END
+
+stop:
+#undef TARGET
+#undef DISPATCH
+#undef DISPATCH_BEGIN
+#undef DISPATCH_END
+#undef ADVANCE
+#undef JUMP_AT
+#undef HALT_AT
+#undef RAISE_AT
+#undef STEP_PUSHI
+#undef STEP_PUSH
+#undef STEP_POP
+#undef STEP_INPUT
+#undef STEP_INPUTN
+#undef STEP_PRINT
+#undef STEP_BINARY
+#undef STEP_ADD
+#undef STEP_SUB
+#undef STEP_MUL
+#undef STEP_DIV
+#undef STEP_SWAP
+#undef STEP_DROP
+#undef STEP_DUP
+#undef STEP_HLT
+#undef STEP_JMP
+#undef STEP_CONDITIONAL_JUMP
+#undef STEP_JZ
+#undef STEP_JNZ
+#undef STEP_CALL
+#undef STEP_RET
+    policy.stop();
+    sp[-1] = tos; // Writes the cached top back (The scratch slot when the stack is empty)
+    stack.depth = sp - stack_base;
+    result.trap = trap;
+    result.pc = ip - base;
+    result.executed = executed;
+    return result;
+}
@@ -0,0 +1,559 @@
+/**
+ * @file jit.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/jit.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define STACKINTERPRETER_JIT
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sys/mman.h>
+#endif
+
+#ifdef STACKINTERPRETER_JIT
+namespace{
+
+/// State shared with the native code (Read on entry, written back on exit)
+typedef struct jit_context{
+    int *sp;                                   /// --> One past the top of the stack (sp[-1] is stale while running)
+    int *stack_base;
+    int *stack_limit;
+    qsizetype *return_base;                    /// --> Return stack (Storage of Stack::return_stack)
+    qsizetype *return_sp;
+    qsizetype *return_limit;
+    qint32 *mem;                               /// --> Memory values (Storage of Memory::values)
+    quint64 *occupancy;                        /// --> Memory occupancy bitset
+    qsizetype mem_size;
+    stackinterpreter::io_buffers *io;
+    quint64 executed;
+    qsizetype pc;                              /// --> Where the native code stopped
+    qint32 tos;
+    qint32 trap;                               /// --> Trap enum value
+    qint32 halted;                             /// --> 1 if HLT was executed
+} jit_context;
+
+/// Returned by jit_input when the input buffer is empty
+constexpr qint64 NO_INPUT = -9223372036854775807LL - 1;
+
+/// @brief INPUT callback, return the next input value or NO_INPUT
+qint64 jit_input(jit_context *context) noexcept{
+    stackinterpreter::io_buffers &io = *context->io;
+    if(io.input_position == io.input.size())
+        return NO_INPUT;
+    return io.input[io.input_position++];
+}
+
+/// @brief INPUTN callback, pushes count input values on the context stack, return the Trap enum value
+qint32 jit_input_n(jit_context *context, qint32 count) noexcept{
+    stackinterpreter::io_buffers &io = *context->io;
+    if(context->stack_limit - context->sp < count)
+        return static_cast<qint32>(stackinterpreter::Trap::STACK_OVERFLOW);
+    if(io.input.size() - io.input_position < count)
+        return static_cast<qint32>(stackinterpreter::Trap::WAITING_INPUT);
+    context->sp[-1] = context->tos;
+    std::copy(io.input.constData() + io.input_position, io.input.constData() + io.input_position + count, context->sp);
+    context->sp += count;
+    context->tos = context->sp[-1];
+    io.input_position += count;
+    return static_cast<qint32>(stackinterpreter::Trap::NONE);
+}
+
+/// @brief PRINT callback
+void jit_print(jit_context *context, int value) noexcept{
+    context->io->print(value);
+}
+
+/// x86-64 registers (Low 3 bits in ModRM, high bit in REX)
+enum Register{ RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7, R12 = 12, R13 = 13, R14 = 14, R15 = 15 };
+
+/// Condition codes of Jcc
+enum Condition{ NOT_CARRY = 0x3, BELOW_EQUAL = 0x6, EQUAL = 0x4, NOT_EQUAL = 0x5, LESS_EQUAL = 0xE };
+
+/// Registers of the native code, all callee saved so the callbacks keep them
+constexpr int SP = RBX;       /// --> jit_context::sp
+constexpr int TOS = R12;      /// --> jit_context::tos
+constexpr int CONTEXT = R13;  /// --> jit_context*
+constexpr int BASE = R14;     /// --> jit_context::stack_base
+constexpr int LIMIT = R15;    /// --> jit_context::stack_limit
+constexpr int EXECUTED = RBP; /// --> jit_context::executed
+
+/**
+ * @brief Minimal x86-64 encoder, only the forms used by the instruction templates.
+ * @details Memory operands are always [base + disp32]. Jumps are rel32, their offset is returned to be patched later.
+*/
+class CodeBuffer{
+public:
+    QVector<quint8> bytes;
+
+    void byte(quint8 value) noexcept { bytes.append(value); }
+    void dword(quint32 value) noexcept { for(int i = 0; i < 4; ++i) byte(static_cast<quint8>(value >> (8 * i))); }
+    void qword(quint64 value) noexcept { for(int i = 0; i < 8; ++i) byte(static_cast<quint8>(value >> (8 * i))); }
+    [[nodiscard]] qsizetype position() const noexcept { return bytes.size(); }
+
+    void rex(bool wide, int reg, int rm) noexcept{
+        const quint8 prefix = 0x40 | (wide ? 0x08 : 0) | ((reg >> 3) & 1) << 2 | ((rm >> 3) & 1);
+        if(prefix != 0x40)
+            byte(prefix);
+    }
+    /// op reg, rm (Both registers), reg may be an opcode extension
+    void rr(bool wide, quint8 opcode, int reg, int rm) noexcept{
+        rex(wide, reg, rm);
+        byte(opcode);
+        byte(0xC0 | (reg & 7) << 3 | (rm & 7));
+    }
+    /// op reg, [base + disp], reg may be an opcode extension
+    void rm(bool wide, quint8 opcode, int reg, int base, qint32 disp) noexcept{
+        rex(wide, reg, base);
+        byte(opcode);
+        modrm_disp(reg, base, disp);
+    }
+    void modrm_disp(int reg, int base, qint32 disp) noexcept{
+        byte(0x80 | (reg & 7) << 3 | (base & 7));
+        if((base & 7) == RSP)
+            byte(0x24); // SIB: no index
+        dword(static_cast<quint32>(disp));
+    }
+
+    void mov32(int dst, int src) noexcept { rr(false, 0x89, src, dst); }
+    void mov64(int dst, int src) noexcept { rr(true, 0x89, src, dst); }
+    void load32(int dst, int base, qint32 disp) noexcept { rm(false, 0x8B, dst, base, disp); }
+    void load64(int dst, int base, qint32 disp) noexcept { rm(true, 0x8B, dst, base, disp); }
+    void store32(int base, qint32 disp, int src) noexcept { rm(false, 0x89, src, base, disp); }
+    void store64(int base, qint32 disp, int src) noexcept { rm(true, 0x89, src, base, disp); }
+    void store_imm32(int base, qint32 disp, qint32 value) noexcept { rm(false, 0xC7, 0, base, disp); dword(static_cast<quint32>(value)); }
+    void store_imm64(int base, qint32 disp, qint32 value) noexcept { rm(true, 0xC7, 0, base, disp); dword(static_cast<quint32>(value)); }
+    /// bt/bts/btr qword [base + disp], bit (extension 4/5/6, bt sets the carry flag to the bit)
+    void bit_mem64(int extension, int base, qint32 disp, quint8 bit) noexcept { rex(true, extension, base); byte(0x0F); byte(0xBA); modrm_disp(extension, base, disp); byte(bit); }
+    void cmp_imm32_mem64(int base, qint32 disp, qint32 value) noexcept { rm(true, 0x81, 7, base, disp); dword(static_cast<quint32>(value)); }
+    void mov_imm32(int dst, qint32 value) noexcept { rex(false, 0, dst); byte(0xB8 + (dst & 7)); dword(static_cast<quint32>(value)); }
+    void mov_imm64(int dst, quint64 value) noexcept { rex(true, 0, dst); byte(0xB8 + (dst & 7)); qword(value); }
+    void lea64(int dst, int base, qint32 disp) noexcept { rm(true, 0x8D, dst, base, disp); }
+    void add_imm8(int dst, qint8 value) noexcept { rr(true, 0x83, 0, dst); byte(static_cast<quint8>(value)); }
+    void sub_imm8(int dst, qint8 value) noexcept { rr(true, 0x83, 5, dst); byte(static_cast<quint8>(value)); }
+    void add64(int dst, int src) noexcept { rr(true, 0x01, src, dst); }
+    void cmp64(int lhs, int rhs) noexcept { rr(true, 0x39, rhs, lhs); }
+    void cmp_imm32(int lhs, qint32 value) noexcept { rr(false, 0x81, 7, lhs); dword(static_cast<quint32>(value)); }
+    void test32(int lhs, int rhs) noexcept { rr(false, 0x85, rhs, lhs); }
+    void add32_mem(int dst, int base, qint32 disp) noexcept { rm(false, 0x03, dst, base, disp); }
+    void sub32(int dst, int src) noexcept { rr(false, 0x29, src, dst); }
+    void imul32_mem(int dst, int base, qint32 disp) noexcept { rex(false, dst, base); byte(0x0F); byte(0xAF); modrm_disp(dst, base, disp); }
+    void idiv32(int divisor) noexcept { rr(false, 0xF7, 7, divisor); }
+    void cdq() noexcept { byte(0x99); }
+    void neg32(int dst) noexcept { rr(false, 0xF7, 3, dst); }
+    void add_imm32(int dst, qint32 value) noexcept { rr(true, 0x81, 0, dst); dword(static_cast<quint32>(value)); }
+    void call(int target) noexcept { rr(false, 0xFF, 2, target); }
+    void jmp_table(int table, int index) noexcept { rex(false, 0, table); byte(0xFF); byte(0x24); byte(0xC0 | (index & 7) << 3 | (table & 7)); } // jmp [table + index * 8]
+    void jmp_reg(int target) noexcept { rr(false, 0xFF, 4, target); }
+    void push(int reg) noexcept { rex(false, 0, reg); byte(0x50 + (reg & 7)); }
+    void pop(int reg) noexcept { rex(false, 0, reg); byte(0x58 + (reg & 7)); }
+    void ret() noexcept { byte(0xC3); }
+    [[nodiscard]] qsizetype jmp() noexcept { byte(0xE9); dword(0); return position() - 4; }
+    [[nodiscard]] qsizetype jcc(Condition condition) noexcept { byte(0x0F); byte(0x80 | condition); dword(0); return position() - 4; }
+    void patch(qsizetype rel32, qsizetype target) noexcept{
+        const quint32 offset = static_cast<quint32>(target - (rel32 + 4));
+        for(int i = 0; i < 4; ++i)
+            bytes[rel32 + i] = static_cast<quint8>(offset >> (8 * i));
+    }
+};
+
+/// Jump to the trap exit of an instruction (Emitted after the program)
+typedef struct trap_fixup{
+    qsizetype rel32;
+    qsizetype pc;
+    stackinterpreter::Trap trap;
+    qint32 pending; /// --> Instructions executed but not yet counted when the trap is raised
+} trap_fixup;
+
+/// Jump to the native code of an instruction
+typedef struct branch_fixup{
+    qsizetype rel32;
+    qsizetype target;
+} branch_fixup;
+
+} // namespace
+#endif // STACKINTERPRETER_JIT
+
+/// @brief Return true if this build can compile programs to native code
+bool stackinterpreter::Jit::supported() noexcept{
+#ifdef STACKINTERPRETER_JIT
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Jit
+ * @brief Compile a program, opcodes out of the instruction set and branches out of the program trap when executed (Like the Interpreter).
+ * @param program - Assembled program.
+*/
+stackinterpreter::Jit::Jit(const Program &program){
+    QVector<stackinterpreter::bytecode_cell> code = program.get_code();
+    for(stackinterpreter::bytecode_cell &cell : code){
+        if(cell.opcode < 0 || cell.opcode > stackinterpreter::Instructions::ERROR)
+            cell.opcode = stackinterpreter::Instructions::ERROR;
+        else if(stackinterpreter::instruction_is_branch(cell.opcode) && (cell.operand < 0 || cell.operand > code.size()))
+            cell.opcode = stackinterpreter::Instructions::ERROR;
+    }
+    entries.fill(nullptr, code.size() + 1);
+    pending_at.fill(0, code.size() + 1);
+    compile(code);
+}
+
+stackinterpreter::Jit::~Jit(){
+#ifdef STACKINTERPRETER_JIT
+    if(native)
+        munmap(native, static_cast<size_t>(native_size));
+#endif
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Jit
+ * @brief Emit the machine code of every instruction and map it executable.
+ * @param code - Program bytecode (Invalid instructions already replaced by Instructions::ERROR).
+ * @details Native code layout: entry (Saves the registers, loads the context, jumps to start), one template per
+ *          instruction, the end of the program, one exit per trap and the common exit (Stores the context back).
+*/
+void stackinterpreter::Jit::compile(const QVector<stackinterpreter::bytecode_cell> &code) noexcept{
+#ifdef STACKINTERPRETER_JIT
+    CodeBuffer a;
+    QVector<qsizetype> offsets(code.size() + 1);
+    QVector<trap_fixup> traps;
+    QVector<branch_fixup> branches;
+    QVector<qsizetype> exits; /// Jumps to the common exit
+    QVector<bool> leader(code.size() + 1, false);
+    for(const stackinterpreter::bytecode_cell &cell : code)
+        if(stackinterpreter::instruction_is_branch(cell.opcode))
+            leader[cell.operand] = true;
+    /// The executed count is added once per basic block: pending instructions are counted before every branch, branch
+    /// target and exit. An entry in the middle of a block starts the count at -pending (See run).
+    qint32 pending = 0;
+    auto count = [&](qint32 instructions){
+        if(instructions)
+            a.add_imm32(EXECUTED, instructions);
+    };
+    const qint32 CONTEXT_SP = offsetof(jit_context, sp), CONTEXT_TOS = offsetof(jit_context, tos);
+    const qint32 CONTEXT_PC = offsetof(jit_context, pc), CONTEXT_TRAP = offsetof(jit_context, trap);
+    const qint32 CONTEXT_RETURN_SP = offsetof(jit_context, return_sp), CONTEXT_MEM = offsetof(jit_context, mem);
+    const qint32 CONTEXT_OCCUPANCY = offsetof(jit_context, occupancy);
+    constexpr quint8 BT = 4, BTS = 5, BTR = 6;
+
+    auto raise_if = [&](Condition condition, qsizetype pc, stackinterpreter::Trap trap){ traps.append(trap_fixup{a.jcc(condition), pc, trap, pending}); };
+    auto raise = [&](qsizetype pc, stackinterpreter::Trap trap){ traps.append(trap_fixup{a.jmp(), pc, trap, pending}); };
+    auto check_underflow = [&](qsizetype pc, int values){
+        if(values == 1)
+            a.cmp64(SP, BASE);
+        else{
+            a.lea64(RAX, BASE, 4 * (values - 1));
+            a.cmp64(SP, RAX);
+        }
+        raise_if(values == 1 ? EQUAL : BELOW_EQUAL, pc, stackinterpreter::Trap::STACK_UNDERFLOW);
+    };
+    auto check_overflow = [&](qsizetype pc){
+        a.cmp64(SP, LIMIT);
+        raise_if(EQUAL, pc, stackinterpreter::Trap::STACK_OVERFLOW);
+    };
+    auto check_address = [&](qsizetype pc, qint32 address){ /// Leaves the value address in RAX and the occupancy word address in RCX
+        if(address < 0){
+            raise(pc, stackinterpreter::Trap::INVALID_ADDRESS);
+            return;
+        }
+        a.cmp_imm32_mem64(CONTEXT, offsetof(jit_context, mem_size), address);
+        raise_if(LESS_EQUAL, pc, stackinterpreter::Trap::INVALID_ADDRESS);
+        a.load64(RAX, CONTEXT, CONTEXT_MEM);
+        a.mov_imm64(RCX, static_cast<quint64>(address) * sizeof(qint32));
+        a.add64(RAX, RCX);
+        a.load64(RCX, CONTEXT, CONTEXT_OCCUPANCY);
+        a.mov_imm64(RDX, static_cast<quint64>(address >> 6) * sizeof(quint64));
+        a.add64(RCX, RDX);
+    };
+    auto push_value = [&](){ a.store32(SP, -4, TOS); a.add_imm8(SP, 4); }; /// Spills TOS, the caller sets the new TOS
+    auto pop_value = [&](){ a.sub_imm8(SP, 4); a.load32(TOS, SP, -4); };
+    auto call = [&](const void *function){ a.mov_imm64(RAX, reinterpret_cast<quint64>(function)); a.call(RAX); };
+    auto stop = [&](qsizetype pc){ a.store_imm64(CONTEXT, CONTEXT_PC, static_cast<qint32>(pc)); exits.append(a.jmp()); };
+
+    // Entry: void entry(jit_context *context, const void *start)
+    a.push(RBX); a.push(RBP); a.push(R12); a.push(R13); a.push(R14); a.push(R15);
+    a.sub_imm8(RSP, 8); // Aligns the stack for the callbacks
+    a.mov64(CONTEXT, RDI);
+    a.load64(SP, CONTEXT, CONTEXT_SP);
+    a.load32(TOS, CONTEXT, CONTEXT_TOS);
+    a.load64(BASE, CONTEXT, offsetof(jit_context, stack_base));
+    a.load64(LIMIT, CONTEXT, offsetof(jit_context, stack_limit));
+    a.load64(EXECUTED, CONTEXT, offsetof(jit_context, executed));
+    a.jmp_reg(RSI);
+
+    for(qsizetype pc = 0; pc < code.size(); ++pc){
+        if(leader[pc]){
+            count(pending);
+            pending = 0;
+        }
+        offsets[pc] = a.position();
+        pending_at[pc] = pending;
+        const qint32 operand = code[pc].operand;
+        switch(code[pc].opcode){
+            case stackinterpreter::Instructions::PUSHI:
+                check_overflow(pc);
+                push_value();
+                a.mov_imm32(TOS, operand);
+                break;
+            case stackinterpreter::Instructions::PUSH:
+                check_underflow(pc, 1);
+                check_address(pc, operand);
+                if(operand < 0)
+                    continue;
+                a.store32(RAX, 0, TOS);
+                a.bit_mem64(BTS, RCX, 0, static_cast<quint8>(operand & 63));
+                pop_value();
+                break;
+            case stackinterpreter::Instructions::POP:
+                check_overflow(pc);
+                check_address(pc, operand);
+                if(operand < 0)
+                    continue;
+                a.bit_mem64(BT, RCX, 0, static_cast<quint8>(operand & 63));
+                raise_if(NOT_CARRY, pc, stackinterpreter::Trap::EMPTY_MEMORY_SLOT);
+                push_value();
+                a.load32(TOS, RAX, 0);
+                a.bit_mem64(BTR, RCX, 0, static_cast<quint8>(operand & 63));
+                break;
+            case stackinterpreter::Instructions::INPUT:
+                check_overflow(pc);
+                a.mov64(RDI, CONTEXT);
+                call(reinterpret_cast<const void*>(&jit_input));
+                a.mov_imm64(RCX, static_cast<quint64>(NO_INPUT));
+                a.cmp64(RAX, RCX);
+                raise_if(EQUAL, pc, stackinterpreter::Trap::WAITING_INPUT);
+                push_value();
+                a.mov32(TOS, RAX);
+                break;
+            case stackinterpreter::Instructions::INPUTN: // The callback works on the context stack
+                if(operand < 0){
+                    raise(pc, stackinterpreter::Trap::INVALID_OPERAND);
+                    continue;
+                }
+                a.store64(CONTEXT, CONTEXT_SP, SP);
+                a.store32(CONTEXT, CONTEXT_TOS, TOS);
+                a.mov64(RDI, CONTEXT);
+                a.mov_imm32(RSI, operand);
+                call(reinterpret_cast<const void*>(&jit_input_n));
+                a.load64(SP, CONTEXT, CONTEXT_SP);
+                a.load32(TOS, CONTEXT, CONTEXT_TOS);
+                a.cmp_imm32(RAX, static_cast<qint32>(stackinterpreter::Trap::STACK_OVERFLOW));
+                raise_if(EQUAL, pc, stackinterpreter::Trap::STACK_OVERFLOW);
+                a.cmp_imm32(RAX, static_cast<qint32>(stackinterpreter::Trap::WAITING_INPUT));
+                raise_if(EQUAL, pc, stackinterpreter::Trap::WAITING_INPUT);
+                break;
+            case stackinterpreter::Instructions::PRINT:
+                check_underflow(pc, 1);
+                a.mov64(RDI, CONTEXT);
+                a.mov32(RSI, TOS);
+                call(reinterpret_cast<const void*>(&jit_print));
+                pop_value();
+                break;
+            case stackinterpreter::Instructions::ADD:
+                check_underflow(pc, 2);
+                a.sub_imm8(SP, 4);
+                a.add32_mem(TOS, SP, -4);
+                break;
+            case stackinterpreter::Instructions::SUB:
+                check_underflow(pc, 2);
+                a.sub_imm8(SP, 4);
+                a.load32(RAX, SP, -4);
+                a.sub32(RAX, TOS);
+                a.mov32(TOS, RAX);
+                break;
+            case stackinterpreter::Instructions::MUL:
+                check_underflow(pc, 2);
+                a.sub_imm8(SP, 4);
+                a.imul32_mem(TOS, SP, -4);
+                break;
+            case stackinterpreter::Instructions::DIV:
+                check_underflow(pc, 2);
+                a.test32(TOS, TOS);
+                raise_if(EQUAL, pc, stackinterpreter::Trap::DIVISION_BY_ZERO);
+                a.sub_imm8(SP, 4);
+                a.load32(RAX, SP, -4);
+                a.cmp_imm32(TOS, -1);
+                {
+                    const qsizetype divide = a.jcc(NOT_EQUAL);
+                    a.neg32(RAX); // INT_MIN / -1 wraps to INT_MIN (idiv would fault)
+                    const qsizetype done = a.jmp();
+                    a.patch(divide, a.position());
+                    a.cdq();
+                    a.idiv32(TOS);
+                    a.patch(done, a.position());
+                }
+                a.mov32(TOS, RAX);
+                break;
+            case stackinterpreter::Instructions::SWAP:
+                check_underflow(pc, 2);
+                a.load32(RAX, SP, -8);
+                a.store32(SP, -8, TOS);
+                a.mov32(TOS, RAX);
+                break;
+            case stackinterpreter::Instructions::DROP:
+                check_underflow(pc, 1);
+                pop_value();
+                break;
+            case stackinterpreter::Instructions::DUP:
+                check_underflow(pc, 1);
+                check_overflow(pc);
+                push_value();
+                break;
+            case stackinterpreter::Instructions::HLT:
+                a.mov64(SP, BASE);
+                count(pending + 1);
+                pending = 0;
+                a.store_imm32(CONTEXT, offsetof(jit_context, halted), 1);
+                stop(pc);
+                continue;
+            case stackinterpreter::Instructions::JMP:
+                count(pending + 1);
+                pending = 0;
+                branches.append(branch_fixup{a.jmp(), operand});
+                continue;
+            case stackinterpreter::Instructions::JZ:
+            case stackinterpreter::Instructions::JNZ:
+                check_underflow(pc, 1);
+                a.mov32(RAX, TOS);
+                pop_value();
+                count(pending + 1); // Before the test (add writes the flags)
+                pending = 0;
+                a.test32(RAX, RAX);
+                branches.append(branch_fixup{a.jcc(code[pc].opcode == stackinterpreter::Instructions::JZ ? EQUAL : NOT_EQUAL), operand});
+                continue;
+            case stackinterpreter::Instructions::CALL:
+                a.load64(RAX, CONTEXT, CONTEXT_RETURN_SP);
+                a.load64(RCX, CONTEXT, offsetof(jit_context, return_limit));
+                a.cmp64(RAX, RCX);
+                raise_if(EQUAL, pc, stackinterpreter::Trap::CALL_STACK_OVERFLOW);
+                a.store_imm64(RAX, 0, static_cast<qint32>(pc + 1));
+                a.add_imm8(RAX, 8);
+                a.store64(CONTEXT, CONTEXT_RETURN_SP, RAX);
+                count(pending + 1);
+                pending = 0;
+                branches.append(branch_fixup{a.jmp(), operand});
+                continue;
+            case stackinterpreter::Instructions::RET:
+                a.load64(RAX, CONTEXT, CONTEXT_RETURN_SP);
+                a.load64(RCX, CONTEXT, offsetof(jit_context, return_base));
+                a.cmp64(RAX, RCX);
+                raise_if(EQUAL, pc, stackinterpreter::Trap::CALL_STACK_UNDERFLOW);
+                a.sub_imm8(RAX, 8);
+                a.store64(CONTEXT, CONTEXT_RETURN_SP, RAX);
+                a.load64(RAX, RAX, 0);
+                count(pending + 1);
+                pending = 0;
+                a.mov_imm64(RCX, reinterpret_cast<quint64>(entries.constData()));
+                a.jmp_table(RCX, RAX);
+                continue;
+            default: // Instructions::ERROR
+                raise(pc, stackinterpreter::Trap::INVALID_INSTRUCTION);
+                continue;
+        }
+        ++pending;
+    }
+    count(pending);
+    offsets[code.size()] = a.position();
+    pending_at[code.size()] = 0;
+    stop(code.size()); // End of the program
+
+    for(const trap_fixup &fixup : traps){
+        a.patch(fixup.rel32, a.position());
+        count(fixup.pending);
+        a.store_imm32(CONTEXT, CONTEXT_TRAP, static_cast<qint32>(fixup.trap));
+        stop(fixup.pc);
+    }
+    const qsizetype exit = a.position();
+    for(qsizetype rel32 : exits)
+        a.patch(rel32, exit);
+    for(const branch_fixup &fixup : branches)
+        a.patch(fixup.rel32, offsets[fixup.target]);
+    a.store64(CONTEXT, CONTEXT_SP, SP);
+    a.store32(CONTEXT, CONTEXT_TOS, TOS);
+    a.store64(CONTEXT, offsetof(jit_context, executed), EXECUTED);
+    a.add_imm8(RSP, 8);
+    a.pop(R15); a.pop(R14); a.pop(R13); a.pop(R12); a.pop(RBP); a.pop(RBX);
+    a.ret();
+
+    // W^X: written while writable, executable only once read only
+    native_size = a.bytes.size();
+    void *region = mmap(nullptr, static_cast<size_t>(native_size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED){
+        native_size = 0;
+        return;
+    }
+    std::memcpy(region, a.bytes.constData(), static_cast<size_t>(native_size));
+    if(mprotect(region, static_cast<size_t>(native_size), PROT_READ | PROT_EXEC) != 0){
+        munmap(region, static_cast<size_t>(native_size));
+        native_size = 0;
+        return;
+    }
+    native = region;
+    for(qsizetype pc = 0; pc < offsets.size(); ++pc)
+        entries[pc] = static_cast<const quint8*>(native) + offsets[pc];
+    entry = reinterpret_cast<native_entry>(native);
+#else
+    Q_UNUSED(code);
+#endif
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Jit
+ * @brief Run the compiled program until HLT (or the end of the program), a trap or a missing input value.
+ * @param stack - Instance of Stack class that will execute the program.
+ * @param pc - Offset of the first instruction to be executed (0 to start, run_result::pc to resume).
+ * @param io - Values consumed by INPUT and written by PRINT.
+ * @return The trap that stopped the run, where it stopped and how many instructions were executed.
+*/
+stackinterpreter::run_result stackinterpreter::Jit::run(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept{
+    stackinterpreter::run_result result;
+    if(!entry || pc < 0 || pc > size()){
+        result.trap = stackinterpreter::Trap::INVALID_INSTRUCTION;
+        result.pc = pc;
+        return result;
+    }
+#ifdef STACKINTERPRETER_JIT
+    jit_context context;
+    context.stack_base = stack.buffer.data() + 1;
+    context.stack_limit = context.stack_base + stack.max_size;
+    context.sp = context.stack_base + stack.depth;
+    context.tos = stack.depth ? context.sp[-1] : 0;
+    /// The native code pushes the return offsets directly in the storage of the return stack
+    const qsizetype return_depth = stack.return_stack.size();
+    stack.return_stack.resize(qMax(stack.max_call_depth, return_depth));
+    context.return_base = stack.return_stack.data();
+    context.return_sp = context.return_base + return_depth;
+    context.return_limit = context.return_base + stack.max_call_depth;
+    context.mem = stack.values.data();
+    context.occupancy = stack.occupancy.data();
+    context.mem_size = stack.max_mem_size;
+    context.io = &io;
+    context.executed = static_cast<quint64>(-static_cast<qint64>(pending_at[pc])); // Counted again at the end of the block
+    context.pc = pc;
+    context.trap = static_cast<qint32>(stackinterpreter::Trap::NONE);
+    context.halted = 0;
+
+    entry(&context, entries[pc]);
+
+    context.sp[-1] = context.tos; // Writes the cached top back (The scratch slot when the stack is empty)
+    stack.depth = context.sp - context.stack_base;
+    stack.return_stack.resize(context.return_sp - context.return_base);
+    if(context.halted)
+        stack.return_stack.clear();
+    stack.mark_all_dirty(); // The native code does not track its stores
+    result.trap = static_cast<stackinterpreter::Trap>(context.trap);
+    result.pc = context.pc;
+    result.executed = context.executed;
+#else
+    Q_UNUSED(stack);
+    Q_UNUSED(io);
+#endif
+    return result;
+}
@@ -1,29 +1,67 @@
 #include "../headers/mainwindow.h"
 #include "../headers/asmexporter.h"
+#include "../headers/assembler.h"
 #include "../headers/cppexporter.h"
 #include "../headers/customoptions.h"
 #include "../headers/instruction_handler.h"
 #include "../headers/instructions.h"
+#include "../headers/view_models.h"
 #include "ui_mainwindow.h"
 #include "QMessageBox"
 #include "QFileDialog"
 #include "QDir"
+#include "QFile"
+#include "QFileInfo"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
+    , input_source(this)
 {
     ui->setupUi(this);
+    instruction_handler.set_input_source(&input_source);
+    output_sink = new stackinterpreter::ConsoleOutputSink(ui->console);
+    instruction_handler.set_output_sink(output_sink);
+    instruction_handler.get_trace().set_depth(log_depth);
+    stack_model = new stackinterpreter::StackModel(stack, this);
+    instruction_model = new stackinterpreter::TraceModel(instruction_handler.get_trace(), this);
+    memory_model = new stackinterpreter::MemoryLogModel(instruction_handler.get_trace(), this);
+    ui->stack_view->setModel(stack_model);
+    ui->instruction_log->setModel(instruction_model);
+    ui->memory_log->setModel(memory_model);
+    program_model = new stackinterpreter::ProgramModel(this);
+    ui->program_view->setModel(program_model);
     init_selector();
     ui->stack_pb->setRange(0, 100);
     ui->stack_pb->setValue(0);
     ui->label_stack->setText("Stack (Current max size: " + QString::number(stack.get_max_size()) + ")");
+    qRegisterMetaType<stackinterpreter::vm_state>();
+    worker = new stackinterpreter::VMWorker(stack, instruction_handler);
+    worker->moveToThread(&worker_thread);
+    connect(&worker_thread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(worker, &stackinterpreter::VMWorker::state_changed, this, &MainWindow::vm_state_changed); // Queued, the worker lives in worker_thread
+    connect(worker, &stackinterpreter::VMWorker::stopped, this, &MainWindow::vm_stopped);
+    connect(&state_timer, &QTimer::timeout, this, &MainWindow::request_vm_state);
+    state_timer.setInterval(state_interval);
+    worker_thread.start();
+    memory_inspector_model = new stackinterpreter::MemoryModel(stack, this);
+    memory_inspector = new stackinterpreter::MemoryInspector(memory_inspector_model, this);
+    connect(memory_inspector, &stackinterpreter::MemoryInspector::visible_changed, this, [this](qsizetype first, qsizetype count){
+        worker->set_memory_window(first, count); // The running program copies these slots in its states
+    });
+    ui->run_button->setEnabled(false); // Until a program is loaded
+    ui->step_button->setEnabled(false);
+    set_running(false);
 }
 
 MainWindow::~MainWindow()
 {
+    worker->request_stop();
+    worker_thread.quit();
+    worker_thread.wait();
     delete ui;
     delete options_dialog_box;
+    delete output_sink;
 }
 
 /**
@@ -44,17 +82,20 @@ void MainWindow::init_selector() noexcept
     ui->instructions_select->addItem("DROP", stackinterpreter::Instructions::DROP);
     ui->instructions_select->addItem("DUP", stackinterpreter::Instructions::DUP);
     ui->instructions_select->addItem("HLT", stackinterpreter::Instructions::HLT);
+    ui->instructions_select->addItem("INPUTN", stackinterpreter::Instructions::INPUTN);
 }
 
 /**
  * @brief Set the line edit to read only or not, also changes the placeholder based on read only or not
- * @param index The index of the option (Relative with enum type)
+ * @param index The index of the option (Its item data is the enum type)
 */
 void MainWindow::on_instructions_select_currentIndexChanged(int index)
 {
-    if(index == stackinterpreter::Instructions::PUSHI ||
-       index == stackinterpreter::Instructions::PUSH  ||
-       index == stackinterpreter::Instructions::POP)
+    const int instruction = ui->instructions_select->itemData(index).toInt();
+    if(instruction == stackinterpreter::Instructions::PUSHI ||
+       instruction == stackinterpreter::Instructions::PUSH  ||
+       instruction == stackinterpreter::Instructions::POP   ||
+       instruction == stackinterpreter::Instructions::INPUTN)
     {
         ui->flagged_values->setReadOnly(false);
         ui->flagged_values->setPlaceholderText("Type here...");
@@ -71,15 +112,40 @@ void MainWindow::on_instructions_select_currentIndexChanged(int index)
 */
 void MainWindow::on_exec_button_clicked()
 {
-    ui->instruction_log->setText("");
-    stackinterpreter::instruction_tuple instruction_buffer = instruction_handler.handle_instruction(ui->instructions_select->currentIndex(), ui->flagged_values->text());
-    instruction_handler.execute(this, stack, instruction_buffer.instruction, instruction_buffer.value, instruction_handler, ui->instructions_select->currentText());
+    const int selected = ui->instructions_select->currentData().toInt();
+    stackinterpreter::instruction_tuple instruction_buffer = instruction_handler.handle_instruction(selected, ui->flagged_values->text());
+    stackinterpreter::Trap trap = instruction_handler.execute(stack, instruction_buffer.instruction, instruction_buffer.value, instruction_handler); // INPUT and INPUTN ask through the input source
+    if(trap == stackinterpreter::Trap::WAITING_INPUT)
+        QMessageBox::information(this, "Warning", "Instruction canceled!");
+    else if(trap != stackinterpreter::Trap::NONE)
+        report_trap(trap);
+    static_cast<void>(output_sink->flush()); // PRINT writes to the console pane
     update_stack_progressbar();
-    if(ui->instructions_select->currentIndex() == stackinterpreter::Instructions::HLT)
-        ui->instruction_log->setText("");
-    *ui->stackostream << stack;
-    stack.display_memory_log(*ui->memostream);
-    *ui->instruction_log << instruction_handler;
+    sync_views(); // HLT cleared the trace, its rows are removed
+}
+
+/**
+ * @brief Update the stack and log views with what changed since the last update (Row inserts and removals only)
+*/
+void MainWindow::sync_views() noexcept
+{
+    stack_model->sync();
+    instruction_model->sync();
+    memory_model->sync();
+    memory_inspector_model->sync();
+    if(stack_model->rowCount())
+        ui->stack_view->scrollTo(stack_model->index(stack_model->rowCount() - 1)); // The top is the last item of the row
+    ui->instruction_log->scrollToBottom();
+    ui->memory_log->scrollToBottom();
+}
+
+/**
+ * @brief Show the error dialog of a trap raised by the interpreter core
+ * @param trap The trap returned by the executed instruction
+*/
+void MainWindow::report_trap(stackinterpreter::Trap trap) noexcept
+{
+    QMessageBox::critical(this, "Error!", stackinterpreter::trap_message(trap));
 }
 
 /**
@@ -87,7 +153,7 @@ void MainWindow::on_exec_button_clicked()
 */
 void MainWindow::update_stack_progressbar()
 {
-    int stack_size = static_cast<int>(stack.get_stack().size());
+    int stack_size = static_cast<int>(stack.get_size());
     int percentage = static_cast<int>((static_cast<float>(stack_size) / stack.get_max_size()) * 100);
     ui->stack_pb->setValue(percentage);
 }
@@ -97,12 +163,17 @@ void MainWindow::update_stack_progressbar()
 */
 void MainWindow::on_cpp_export_button_clicked()
 {
+    QVector<stackinterpreter::bytecode_cell> code;
+    if(!instruction_handler.get_trace().executed_code(code)){
+        QMessageBox::critical(this, "Error", "The log only holds the last " + QString::number(instruction_handler.get_trace().get_depth()) + " executed instructions, the export needs every instruction since the program started!");
+        return;
+    }
     QString filename = QFileDialog::getSaveFileName(this, "Save file", QDir::homePath(), "C++ files (*.cpp)");
     if(filename.isNull())
         return;
     filename += ".cpp";
     stackinterpreter::CPPExporter exporter(filename.toStdString().c_str());
-    if(!exporter.export_to_file(instruction_handler.get_log())){
+    if(!exporter.export_to_file(code)){
         QMessageBox::critical(this, "Error", "Error exporting to .cpp file, please, try again!");
         return;
     }
@@ -110,16 +181,21 @@ void MainWindow::on_cpp_export_button_clicked()
 }
 
 /**
- * @brief Export the instructions executed in the stack until the export moment to a .asm (Assembly file) using x86 assembly.
+ * @brief Export the instructions executed in the stack until the export moment to a .asm (Assembly file) using x86-64 Linux assembly (GNU as).
 */
 void MainWindow::on_asm_export_button_clicked()
 {
+    QVector<stackinterpreter::bytecode_cell> code;
+    if(!instruction_handler.get_trace().executed_code(code)){
+        QMessageBox::critical(this, "Error", "The log only holds the last " + QString::number(instruction_handler.get_trace().get_depth()) + " executed instructions, the export needs every instruction since the program started!");
+        return;
+    }
     QString filename = QFileDialog::getSaveFileName(this, "Save file", QDir::homePath(), "Assembly files (*.asm)");
     if(filename.isNull())
         return;
     filename += ".asm";
-    stackinterpreter::ASMExporter exporter(filename.toStdString().c_str());
-    if(!exporter.export_to_file(instruction_handler.get_log())){
+    stackinterpreter::ASMExporter exporter(filename.toStdString().c_str(), stack);
+    if(!exporter.export_to_file(code)){
         QMessageBox::critical(this, "Error", "Error exporting to .asm file, please, try again!");
         return;
     }
@@ -142,10 +218,11 @@ void MainWindow::on_options_button_clicked()
                 QMessageBox::critical(this, "Error", "Not allowed to set sizes smallers than the actual number of elements in the stack/memory!");
                 return;
             }
-            int stack_size = static_cast<int>(stack.get_stack().size());
+            int stack_size = static_cast<int>(stack.get_size());
             int percentage = static_cast<int>((static_cast<float>(stack_size) / stack.get_max_size()) * 100);
             ui->stack_pb->setValue(percentage);
             ui->label_stack->setText("Stack (Current max size: " + QString::number(stack.get_max_size()) + ")");
+            memory_inspector_model->sync(); // Rows follow the memory size
             QMessageBox::information(this, "Success", "New sizes successfully applied!");
         }
         else if(value1 > stack.get_max_possible_size() || value2 > stack.get_max_possible_mem_size())
@@ -157,9 +234,242 @@ void MainWindow::on_options_button_clicked()
         QMessageBox::information(this, "Sucess", "Successfully canceled!");
 }
 
+/**
+ * @brief Enable the controls allowed while a program runs (Pause, stop) or while it does not (Everything touching the stack)
+ * @param running True once a run or a step was handed to the worker
+*/
+void MainWindow::set_running(bool running) noexcept
+{
+    vm_running = running;
+    stop_pending = false;
+    const bool loaded = !ui->label_program->text().isEmpty();
+    ui->run_button->setEnabled(!running && loaded);
+    ui->step_button->setEnabled(!running && loaded);
+    ui->step_count->setEnabled(!running);
+    ui->step_into_button->setEnabled(!running && loaded);
+    ui->step_over_button->setEnabled(!running && loaded);
+    ui->run_to_cursor_button->setEnabled(!running && loaded);
+    ui->breakpoint_button->setEnabled(loaded); // Applied by a running program at its next taken branch
+    ui->load_button->setEnabled(!running);
+    ui->pause_button->setEnabled(running);
+    ui->stop_button->setEnabled(running || loaded);
+    ui->exec_button->setEnabled(!running);
+    ui->options_button->setEnabled(!running);
+    ui->cpp_export_button->setEnabled(!running);
+    ui->asm_export_button->setEnabled(!running);
+    ui->clear_instructions_log_button->setEnabled(!running);
+    ui->clear_memory_log_button->setEnabled(!running);
+    if(running){
+        /// The worker writes the trace while it runs: the logs keep the rows visible now, vm_stopped syncs them
+        auto freeze = [](QListView *view, auto *model){
+            const int first = view->indexAt(QPoint(0, 0)).row(), last = view->indexAt(QPoint(0, view->viewport()->height() - 1)).row();
+            model->freeze(first, last < 0 ? model->rowCount() - 1 : last);
+        };
+        freeze(ui->instruction_log, instruction_model);
+        freeze(ui->memory_log, memory_model);
+        state_timer.start();
+    }
+    else
+        state_timer.stop();
+}
+
+/**
+ * @brief Assemble a program file and hand it to the worker (Run and Step start it from its first instruction)
+*/
+void MainWindow::on_load_button_clicked()
+{
+    const QString filename = QFileDialog::getOpenFileName(this, "Load program", QDir::homePath(), "Stack programs (*.stk)");
+    if(filename.isNull())
+        return;
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly)){
+        QMessageBox::critical(this, "Error", "Error reading the program file, please, try again!");
+        return;
+    }
+    stackinterpreter::Assembler assembler;
+    stackinterpreter::Program program;
+    if(!assembler.assemble(QString::fromUtf8(file.readAll()), program)){
+        const stackinterpreter::assembler_error error = assembler.get_errors().isEmpty() ? stackinterpreter::assembler_error() : assembler.get_errors().first();
+        QMessageBox::critical(this, "Error", QString("Line %1, column %2: %3").arg(error.line).arg(error.column).arg(error.message));
+        return;
+    }
+    worker->discard_breakpoints(); // Set on the previous program
+    QMetaObject::invokeMethod(worker, [this, program]{ worker->load(program); }, Qt::QueuedConnection);
+    program_model->set_program(program);
+    ui->label_program->setText(QFileInfo(filename).fileName() + " (" + QString::number(program.size()) + " instructions)");
+    ui->label_vm->setText("Ready");
+    ui->run_button->setText("Run");
+    set_running(false);
+}
+
+/**
+ * @brief Run the loaded program on the worker thread until it halts, traps, reaches a breakpoint or is paused/stopped (Continue resumes a paused one)
+*/
+void MainWindow::on_run_button_clicked()
+{
+    set_running(true);
+    QMetaObject::invokeMethod(worker, &stackinterpreter::VMWorker::run, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Run the next instructions of the loaded program (Number set in the spin box), they are traced in the logs
+*/
+void MainWindow::on_step_button_clicked()
+{
+    const quint64 count = static_cast<quint64>(ui->step_count->value());
+    set_running(true);
+    QMetaObject::invokeMethod(worker, [this, count]{ worker->step(count); }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Run the next instruction of the loaded program (Traced), a CALL enters its subroutine
+*/
+void MainWindow::on_step_into_button_clicked()
+{
+    set_running(true);
+    QMetaObject::invokeMethod(worker, [this]{ worker->step(1); }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Run the next instruction of the loaded program, a CALL runs until its subroutine returns (Or a breakpoint)
+*/
+void MainWindow::on_step_over_button_clicked()
+{
+    set_running(true);
+    QMetaObject::invokeMethod(worker, &stackinterpreter::VMWorker::step_over, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Run the loaded program until it reaches the instruction selected in the program view (Or a breakpoint)
+*/
+void MainWindow::on_run_to_cursor_button_clicked()
+{
+    const qsizetype target = ui->program_view->currentIndex().row();
+    if(target < 0)
+        return;
+    set_running(true);
+    QMetaObject::invokeMethod(worker, [this, target]{ worker->run_to_cursor(target); }, Qt::QueuedConnection);
+}
+
+///@brief Both member functions set or remove the breakpoint of an instruction (The selected one or the one double clicked)
+void MainWindow::on_breakpoint_button_clicked(){ toggle_breakpoint(ui->program_view->currentIndex().row()); }
+void MainWindow::on_program_view_doubleClicked(const QModelIndex &index){ toggle_breakpoint(index.row()); }
+
+/**
+ * @brief Set or remove the breakpoint of an instruction, the worker patches it in the program (Even while it runs)
+ * @param offset Offset of the instruction
+*/
+void MainWindow::toggle_breakpoint(qsizetype offset) noexcept
+{
+    if(offset < 0 || offset >= program_model->rowCount())
+        return;
+    worker->set_breakpoint(offset, program_model->toggle_breakpoint(offset));
+}
+
+///@brief Pause the running program at its next taken branch, Run or Step resumes it
+void MainWindow::on_pause_button_clicked(){ worker->request_pause(); }
+
+/**
+ * @brief Stop the running program (Or forget a paused one), the next run starts it over
+*/
+void MainWindow::on_stop_button_clicked()
+{
+    if(vm_running){
+        stop_pending = true;
+        worker->request_stop();
+        return;
+    }
+    QMetaObject::invokeMethod(worker, &stackinterpreter::VMWorker::reset, Qt::QueuedConnection);
+    ui->label_vm->setText("Stopped");
+    ui->run_button->setText("Run");
+    program_model->set_pc(-1);
+}
+
+/**
+ * @brief Ask the running program for its state, unless the previous state was not displayed yet (States never pile up in the event queue)
+*/
+void MainWindow::request_vm_state()
+{
+    if(state_pending)
+        return;
+    state_pending = true;
+    worker->request_state();
+}
+
+/**
+ * @brief Display the state published by the running program (Stack top, counters and printed values only)
+ * @param state The state published by the worker
+*/
+void MainWindow::display_vm_state(const stackinterpreter::vm_state &state) noexcept
+{
+    ui->label_vm->setText("pc " + QString::number(state.pc) + " | " + QString::number(state.executed) + " executed | depth " + QString::number(state.depth));
+    stack_model->sync(state);
+    if(stack_model->rowCount())
+        ui->stack_view->scrollTo(stack_model->index(stack_model->rowCount() - 1));
+    ui->stack_pb->setValue(static_cast<int>((static_cast<float>(state.depth) / stack.get_max_size()) * 100));
+    memory_inspector_model->sync(state);
+    program_model->set_pc(state.pc);
+    output_sink->write(state.output.constData(), state.output.size());
+    static_cast<void>(output_sink->flush());
+}
+
+void MainWindow::vm_state_changed(const stackinterpreter::vm_state &state)
+{
+    state_pending = false;
+    display_vm_state(state);
+}
+
+/**
+ * @brief Display the program stopped by the worker (The stack and the trace belong to the GUI again) and report why it stopped
+ * @param state The last state of the program
+*/
+void MainWindow::vm_stopped(const stackinterpreter::vm_state &state)
+{
+    const bool stopped_by_user = stop_pending;
+    state_pending = false;
+    set_running(false);
+    display_vm_state(state);
+    sync_views();
+    ui->program_view->scrollTo(program_model->index(static_cast<int>(state.pc)));
+    const bool resumable = (state.trap == stackinterpreter::Trap::INTERRUPTED && !stopped_by_user) || state.trap == stackinterpreter::Trap::BREAKPOINT ||
+                           state.trap == stackinterpreter::Trap::WAITING_INPUT;
+    ui->run_button->setText(resumable ? "Continue" : "Run");
+    switch(state.trap){
+        case stackinterpreter::Trap::NONE:
+            ui->label_vm->setText(ui->label_vm->text() + " | halted");
+            break;
+        case stackinterpreter::Trap::INTERRUPTED:
+            ui->label_vm->setText(ui->label_vm->text() + (stopped_by_user ? " | stopped" : " | paused"));
+            break;
+        case stackinterpreter::Trap::BREAKPOINT:
+            ui->label_vm->setText(ui->label_vm->text() + (program_model->has_breakpoint(state.pc) ? " | breakpoint" : " | paused"));
+            break;
+        case stackinterpreter::Trap::WAITING_INPUT:{
+            QVector<int> values(state.input_needed);
+            if(input_source.read(values.data(), values.size()) != values.size()){
+                ui->label_vm->setText(ui->label_vm->text() + " | waiting for input");
+                break;
+            }
+            set_running(true);
+            QMetaObject::invokeMethod(worker, [this, values]{ worker->provide_input(values); }, Qt::QueuedConnection);
+            break;
+        }
+        default:
+            report_trap(state.trap);
+            break;
+    }
+}
+
 ///@brief Both member functions clear the display
-void MainWindow::on_clear_memory_log_button_clicked(){ ui->memostream->setText(""); }
-void MainWindow::on_clear_instructions_log_button_clicked(){ ui->instruction_log->setText(""); }
+void MainWindow::on_clear_memory_log_button_clicked(){ memory_model->clear(); }
+void MainWindow::on_clear_instructions_log_button_clicked(){ instruction_model->clear(); }
+
+///@brief Show the memory inspector (Non modal, it follows the memory while programs run)
+void MainWindow::on_memory_inspector_triggered()
+{
+    memory_inspector->show();
+    memory_inspector->raise();
+}
 
 ///@brief Used to show some informations about what the project is
 void MainWindow::on_about_triggered()
@@ -1,30 +1,27 @@
 #include "../headers/memory.h"
 #include "../headers/stack.h"
-#include <QMessageBox>
+#include <QtAlgorithms>
+#include <algorithm>
 
 /**
  * @namespace stackinterpreter
  * @class Memory
  * @brief Constructor - Represents the memory module of the stack interpreter.
  * @param _max_mem_size - Maximum size of the memory.
- * @details Provides functionalities for managing memory slots.
+ * @details Provides functionalities for managing memory slots, every slot starts free.
 */
-stackinterpreter::Memory::Memory(qsizetype _max_mem_size) : max_mem_size(_max_mem_size){
-    mem.resize(max_mem_size);
-    mem.assign(max_mem_size, stackinterpreter::mem_slot());
-}
+stackinterpreter::Memory::Memory(qsizetype _max_mem_size) : values(qBound<qsizetype>(0, _max_mem_size, max_possible_mem_size)),
+    occupancy(words(values.size())), dirty(words(words(values.size()))), max_mem_size(values.size()){}
 
 /**
  * @namespace stackinterpreter
  * @class Memory
  * @brief Copy constructor for the Memory class.
  * @param cpy - Memory object to be copied.
- * @details Initializes a new Memory object with the same properties as the provided object.
+ * @details Initializes a new Memory object with the same size, every slot starts free.
 */
-stackinterpreter::Memory::Memory(const Memory &cpy) : mem(cpy.mem), max_mem_size(cpy.max_mem_size){
-    mem.resize(max_mem_size);
-    mem.assign(max_mem_size, stackinterpreter::mem_slot());
-}
+stackinterpreter::Memory::Memory(const Memory &cpy) : values(cpy.max_mem_size), occupancy(words(cpy.max_mem_size)), dirty(words(words(cpy.max_mem_size))),
+    max_mem_size(cpy.max_mem_size){}
 
 /**
  * @namespace stackinterpreter
@@ -36,8 +33,11 @@ stackinterpreter::Memory::Memory(const Memory &cpy) : mem(cpy.mem), max_mem_size
 */
 stackinterpreter::Memory& stackinterpreter::Memory::operator=(const Memory &rhs){
     if(this != &rhs){
-        mem = rhs.mem;
+        values = rhs.values;
+        occupancy = rhs.occupancy;
+        dirty = rhs.dirty;
         max_mem_size = rhs.max_mem_size;
+        mark_all_dirty();
     }
     return *this;
 }
@@ -45,44 +45,37 @@ stackinterpreter::Memory& stackinterpreter::Memory::operator=(const Memory &rhs)
 /**
  * @namespace stackinterpreter
  * @class Memory
- * @brief Pushes a value into the memory slot.
- * @param slot - Memory slot to insert the value.
- * @param stack - Stack object for error handling.
- * @return True if the operation is successful, false otherwise.
- * @details Inserts a value into the memory slot and handles errors using QMessageBox.
+ * @brief Drops the top of the stack into a memory slot.
+ * @param address - Address of the memory slot.
+ * @param stack - Stack object wich the value is dropped from.
+ * @return Trap::NONE if the operation is successful, Trap::INVALID_ADDRESS otherwise.
+ * @details Inserts a value into the memory slot, the caller is responsible for reporting the trap.
 */
-bool stackinterpreter::Memory::push_in(const mem_slot &slot, stackinterpreter::Stack &stack) noexcept{
-    if(slot.address == -1 || slot.address >= max_mem_size){
-        QMessageBox::critical(nullptr, "Error!", "Error inserting the value in memory, check hexadecimal address!");
-        return false;
-    }
-    int value = stack.DROP();
-    mem[slot.address] = stackinterpreter::mem_slot(slot.address, value, true);
-    return true;
+stackinterpreter::Trap stackinterpreter::Memory::push_in(qsizetype address, stackinterpreter::Stack &stack) noexcept{
+    if(address < 0 || address >= max_mem_size)
+        return stackinterpreter::Trap::INVALID_ADDRESS;
+    occupy(address, stack.DROP());
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Memory
- * @brief Pops a value out of the memory slot.
- * @param slot - Memory slot to remove the value from.
- * @param stack - Stack object for error handling.
- * @return True if the operation is successful, false otherwise.
- * @details Removes a value from the memory slot and handles errors using QMessageBox.
+ * @brief Pops a value out of a memory slot onto the stack.
+ * @param address - Address of the memory slot.
+ * @param value - Receives the removed value.
+ * @param stack - Stack object wich the value is pushed to.
+ * @return Trap::NONE if the operation is successful, Trap::INVALID_ADDRESS or Trap::EMPTY_MEMORY_SLOT otherwise.
+ * @details Removes a value from the memory slot, the caller is responsible for reporting the trap.
 */
-bool stackinterpreter::Memory::pop_out(const mem_slot &slot, stackinterpreter::Stack &stack) noexcept{
-    if(slot.address == -1 || slot.address >= max_mem_size){
-        QMessageBox::critical(nullptr, "Error!", "Error removing the value in memory, check hexadecimal address!");
-        return false;
-    }
-    else if(!is_occupied(slot.address)){
-        QMessageBox::critical(nullptr, "Error!", "Error removing empty memory slot!");
-        return false;
-    }
-    int value = slot.value;
-    mem[slot.address] = stackinterpreter::mem_slot();
-    stack.PUSHI(value);
-    return true;
+stackinterpreter::Trap stackinterpreter::Memory::pop_out(qsizetype address, int &value, stackinterpreter::Stack &stack) noexcept{
+    if(address < 0 || address >= max_mem_size)
+        return stackinterpreter::Trap::INVALID_ADDRESS;
+    else if(!is_occupied(address))
+        return stackinterpreter::Trap::EMPTY_MEMORY_SLOT;
+    value = values[address];
+    release(address);
+    return stack.PUSHI(value);
 }
 
 /**
@@ -91,11 +84,119 @@ bool stackinterpreter::Memory::pop_out(const mem_slot &slot, stackinterpreter::S
  * @brief Resizes the memory.
  * @param new_size - New size for the memory.
  * @return True if the operation is successful, false otherwise.
- * @details Resizes the memory to the specified size, if it's valid.
+ * @details Grows (The new slots are free) or shrinks (The slots past the new size are dropped) the storage, sizes
+ *          out of [0, max_possible_mem_size] are refused. Growing only reserves address space.
 */
 bool stackinterpreter::Memory::resize_memory(qsizetype new_size) noexcept{
-    if(new_size < max_mem_size && new_size < mem.size())
+    if(new_size < 0 || new_size > max_possible_mem_size || !values.resize(new_size) || !occupancy.resize(words(new_size)) || !dirty.resize(words(words(new_size))))
         return false;
+    if(new_size < max_mem_size && (new_size & 63)) // Frees the dropped slots sharing the last word (Grown slots start free)
+        occupancy[new_size >> 6] &= (quint64(1) << (new_size & 63)) - 1;
     max_mem_size = new_size;
+    mark_all_dirty();
     return true;
 }
+
+/**
+ * @namespace stackinterpreter
+ * @class Memory
+ * @brief Collect the slots written since the last clear_dirty() inside [from, to).
+ * @param from - First slot of the window.
+ * @param to - Slot after the last one of the window.
+ * @param ranges - Receives the dirty ranges in increasing order, adjacent blocks merged and clipped to the window.
+ * @details Slots are tracked by blocks of dirty_block, the cost is one bit test per block of the window.
+*/
+void stackinterpreter::Memory::dirty_ranges(qsizetype from, qsizetype to, QVector<stackinterpreter::memory_range> &ranges) const{
+    ranges.clear();
+    from = qMax<qsizetype>(from, 0);
+    to = qMin(to, max_mem_size);
+    for(qsizetype block = from / dirty_block; block * dirty_block < to; ++block){
+        if(!((dirty[block >> 6] >> (block & 63)) & 1))
+            continue;
+        const qsizetype first = qMax(block * dirty_block, from), end = qMin((block + 1) * dirty_block, to);
+        if(!ranges.isEmpty() && ranges.last().end == first)
+            ranges.last().end = end;
+        else
+            ranges.append(stackinterpreter::memory_range(first, end));
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Memory
+ * @brief Mark every slot as written (After the memory was replaced, or written by code that does not track its stores).
+*/
+void stackinterpreter::Memory::mark_all_dirty() noexcept{
+    std::fill(dirty.data(), dirty.data() + dirty.size(), ~quint64(0));
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Memory
+ * @brief Return the number of occupied memory slots (Population count of the occupancy bitset).
+*/
+qsizetype stackinterpreter::Memory::occupied_count() const noexcept{
+    qsizetype count = 0;
+    for(qsizetype word = 0; word < occupancy.size(); ++word)
+        count += qPopulationCount(occupancy[word]);
+    return count;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Memory
+ * @brief Return the address of the first occupied slot at or after an address.
+ * @param from - First address to look at.
+ * @return The address, -1 if every slot from there is free.
+ * @details Skips 64 free slots at a time, the slot inside a word is found by counting the trailing zero bits.
+*/
+qsizetype stackinterpreter::Memory::next_occupied(qsizetype from) const noexcept{
+    if(from < 0)
+        from = 0;
+    if(from >= max_mem_size)
+        return -1;
+    qsizetype word = from >> 6;
+    quint64 bits = occupancy[word] & (~quint64(0) << (from & 63));
+    while(!bits){
+        if(++word == occupancy.size())
+            return -1;
+        bits = occupancy[word];
+    }
+    return (word << 6) + qCountTrailingZeroBits(bits);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Memory
+ * @brief Return the address of the first free slot at or after an address.
+ * @param from - First address to look at.
+ * @return The address, -1 if every slot from there is occupied.
+*/
+qsizetype stackinterpreter::Memory::next_free(qsizetype from) const noexcept{
+    if(from < 0)
+        from = 0;
+    if(from >= max_mem_size)
+        return -1;
+    qsizetype word = from >> 6;
+    quint64 bits = ~occupancy[word] & (~quint64(0) << (from & 63));
+    while(!bits){
+        if(++word == occupancy.size())
+            return -1;
+        bits = ~occupancy[word];
+    }
+    const qsizetype address = (word << 6) + qCountTrailingZeroBits(bits);
+    return address < max_mem_size ? address : -1; // The bits past max_mem_size in the last word are free
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Memory
+ * @brief Return the address of the last occupied slot.
+ * @return The address, -1 if every slot is free.
+*/
+qsizetype stackinterpreter::Memory::last_occupied() const noexcept{
+    for(qsizetype word = occupancy.size() - 1; word >= 0; --word)
+        if(occupancy[word])
+            return (word << 6) + 63 - qCountLeadingZeroBits(occupancy[word]);
+    return -1;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file memory_inspector.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/memory_inspector.h"
+#include <QFontDatabase>
+#include <QHeaderView>
+#include <QScrollBar>
+#include <QVBoxLayout>
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryInspector
+ * @extends QDialog
+ * @brief Constructor - Builds the grid and the hexadecimal/decimal switch.
+ * @param _model - Model of the memory slots.
+ * @param parent - Parent widget.
+*/
+stackinterpreter::MemoryInspector::MemoryInspector(stackinterpreter::MemoryModel *_model, QWidget *parent) : QDialog(parent), model(_model){
+    QVBoxLayout *main = new QVBoxLayout(this);
+    setWindowTitle("Memory inspector");
+    resize(1000, 600);
+
+    hex_box = new QCheckBox("Hexadecimal", this);
+    hex_box->setChecked(true);
+    view = new QTableView(this);
+    view->setModel(model);
+    view->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    view->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    view->setWordWrap(false);
+    view->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed); // Fixed sections: no per row size to compute over millions of rows
+    view->horizontalHeader()->setDefaultSectionSize(80);
+    view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    view->verticalHeader()->setDefaultSectionSize(view->fontMetrics().height() + 4);
+
+    main->addWidget(hex_box);
+    main->addWidget(view);
+
+    connect(hex_box, &QCheckBox::toggled, model, &stackinterpreter::MemoryModel::set_hex);
+    connect(view->verticalScrollBar(), &QScrollBar::valueChanged, this, &stackinterpreter::MemoryInspector::update_visible);
+    connect(model, &QAbstractItemModel::rowsInserted, this, &stackinterpreter::MemoryInspector::update_visible);
+    connect(model, &QAbstractItemModel::rowsRemoved, this, &stackinterpreter::MemoryInspector::update_visible);
+}
+
+void stackinterpreter::MemoryInspector::showEvent(QShowEvent *event){
+    QDialog::showEvent(event);
+    update_visible();
+}
+
+void stackinterpreter::MemoryInspector::hideEvent(QHideEvent *event){
+    QDialog::hideEvent(event);
+    model->set_visible(0, 0);
+    emit visible_changed(0, 0);
+}
+
+void stackinterpreter::MemoryInspector::resizeEvent(QResizeEvent *event){
+    QDialog::resizeEvent(event);
+    update_visible();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryInspector
+ * @brief Compute the slots of the rows in the viewport and hand them to the model (And to the listeners of visible_changed).
+*/
+void stackinterpreter::MemoryInspector::update_visible(){
+    const int first_row = view->rowAt(0);
+    int last_row = view->rowAt(view->viewport()->height() - 1);
+    if(first_row < 0 || !isVisible()){
+        model->set_visible(0, 0);
+        emit visible_changed(0, 0);
+        return;
+    }
+    if(last_row < 0) // The rows end before the bottom of the viewport
+        last_row = model->rowCount() - 1;
+    const qsizetype first = static_cast<qsizetype>(first_row) * stackinterpreter::MemoryModel::columns;
+    const qsizetype end = static_cast<qsizetype>(last_row + 1) * stackinterpreter::MemoryModel::columns;
+    model->set_visible(first, end);
+    emit visible_changed(first, end - first);
+}
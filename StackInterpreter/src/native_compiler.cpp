@@ -0,0 +1,442 @@
+/**
+ * @file native_compiler.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/native_compiler.h"
+#include "../headers/buffered_writer.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QStandardPaths>
+#include <cstring>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define STACKINTERPRETER_NATIVE
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+namespace{
+
+/// Part of the program hash, must change whenever the generated code or the context layout changes (Invalidates the cache)
+constexpr const char *native_abi = "stackinterpreter-native-4";
+
+/// Symbol of the entry point in the shared object
+constexpr const char *entry_symbol = "stackinterpreter_native_run";
+
+/// State shared with the native code (Read on entry, written back on exit), mirrored by context in native_prologue
+typedef struct native_context{
+    int *sp;                                   /// --> One past the top of the stack (sp[-1] is stale while running)
+    int *stack_base;
+    int *stack_limit;
+    qsizetype *return_base;                    /// --> Return stack (Storage of Stack::return_stack)
+    qsizetype *return_sp;
+    qsizetype *return_limit;
+    qint32 *mem;                               /// --> Memory values (Storage of Memory::values)
+    quint64 *occupancy;                        /// --> Memory occupancy bitset
+    qsizetype mem_size;
+    qint64 (*input)(void *io) noexcept;
+    qint32 (*input_n)(void *io, int *values, qint64 count) noexcept;
+    void (*print)(void *io, int value) noexcept;
+    stackinterpreter::io_buffers *io;
+    quint64 executed;
+    qsizetype pc;                              /// --> Where to start, then where the native code stopped
+    qint32 tos;
+    qint32 trap;                               /// --> Trap enum value
+} native_context;
+
+/// Declarations of the generated C file (Same layout as native_context)
+constexpr const char *native_prologue =
+    "#include <stdint.h>\n\n"
+    "typedef struct context{\n"
+    "    int32_t *sp, *stack_base, *stack_limit;\n"
+    "    int64_t *return_base, *return_sp, *return_limit;\n"
+    "    int32_t *mem;\n"
+    "    uint64_t *occupancy;\n"
+    "    int64_t mem_size;\n"
+    "    int64_t (*input)(void *io);\n"
+    "    int32_t (*input_n)(void *io, int32_t *values, int64_t count);\n"
+    "    void (*print)(void *io, int32_t value);\n"
+    "    void *io;\n"
+    "    uint64_t executed;\n"
+    "    int64_t pc;\n"
+    "    int32_t tos, trap;\n"
+    "} context;\n\n"
+    "#define NO_INPUT (-9223372036854775807LL - 1)\n"
+    "#define RAISE(at, t) { pc = (at); trap = (t); goto stop; }\n"
+    "#define WRAP(lhs, op, rhs) ((int32_t)((uint32_t)(lhs) op (uint32_t)(rhs)))\n"
+    "#define WRAP_DIV(lhs, rhs) ((rhs) == -1 ? WRAP(0, -, lhs) : (lhs) / (rhs))\n"
+    "#define BIT(address) ((uint64_t)1 << ((address) & 63))\n\n";
+
+/// Returned by native_input when the input buffer is empty
+constexpr qint64 NO_INPUT = -9223372036854775807LL - 1;
+
+/// @brief INPUT callback, return the next input value or NO_INPUT
+qint64 native_input(void *io_buffers) noexcept{
+    stackinterpreter::io_buffers &io = *static_cast<stackinterpreter::io_buffers*>(io_buffers);
+    if(io.input_position == io.input.size())
+        return NO_INPUT;
+    return io.input[io.input_position++];
+}
+
+/// @brief INPUTN callback, copy the next count input values, return 0 if fewer are buffered (Nothing consumed)
+qint32 native_input_n(void *io_buffers, int *values, qint64 count) noexcept{
+    return static_cast<stackinterpreter::io_buffers*>(io_buffers)->take_input(values, count) ? 1 : 0;
+}
+
+/// @brief PRINT callback
+void native_print(void *io_buffers, int value) noexcept{
+    static_cast<stackinterpreter::io_buffers*>(io_buffers)->print(value);
+}
+
+/// @brief Write the trap enum value of a RAISE
+qint64 trap_code(stackinterpreter::Trap trap) noexcept{
+    return static_cast<qint64>(trap);
+}
+
+} // namespace
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCompiler
+ * @brief Constructor - Loads the shared object of a program from the cache, or generates, compiles and caches it first.
+ * @param program - Assembled program.
+ * @param _cache_directory - Directory of the cached shared objects (Created if missing).
+*/
+stackinterpreter::NativeCompiler::NativeCompiler(const Program &program, const QString &_cache_directory) :
+    program_size(program.size()), cache_directory(_cache_directory){
+    if(!supported()){
+        failure = "Shared objects can not be loaded in this build";
+        return;
+    }
+    const QVector<stackinterpreter::bytecode_cell> &code = program.get_code();
+    const QString hash = program_hash(code);
+    object_path = cache_directory + "/" + hash + ".so";
+    if(QFile::exists(object_path)){
+        if(load(object_path)){
+            cache_hit = true;
+            return;
+        }
+        QFile::remove(object_path); // Truncated or stale, built again
+    }
+    if(!QDir().mkpath(cache_directory)){
+        failure = "Cannot create the cache directory " + cache_directory;
+        return;
+    }
+#ifdef STACKINTERPRETER_NATIVE
+    /// Built under a name of its own and renamed, so concurrent runs never load a partially written object
+    const QString stem = cache_directory + "/" + hash + "." + QString::number(static_cast<qint64>(getpid()));
+    const QString source_path = stem + ".c", temporary_path = stem + ".so";
+    const bool built = generate(code, source_path) && compile(source_path, temporary_path);
+    QFile::remove(source_path);
+    if(!built){
+        QFile::remove(temporary_path);
+        return;
+    }
+    if(!QFile::rename(temporary_path, object_path))
+        QFile::remove(temporary_path); // Another run cached the same program first
+    static_cast<void>(load(object_path)); // The failure holds the loader error
+#endif
+}
+
+/// @brief Destructor - Unloads the shared object
+stackinterpreter::NativeCompiler::~NativeCompiler(){
+#ifdef STACKINTERPRETER_NATIVE
+    if(library)
+        dlclose(library);
+#endif
+}
+
+/// @brief Return true if this build can load shared objects
+bool stackinterpreter::NativeCompiler::supported() noexcept{
+#ifdef STACKINTERPRETER_NATIVE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/// @brief Return the default directory of the cached shared objects (Under the user cache directory)
+QString stackinterpreter::NativeCompiler::default_cache_directory(){
+    const QString cache = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation);
+    return (cache.isEmpty() ? QDir::tempPath() : cache) + "/stackinterpreter";
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCompiler
+ * @brief Return the cache key of a program: SHA-256 of its bytecode (And of the native ABI version), in hexadecimal.
+ * @param code - Program bytecode.
+*/
+QString stackinterpreter::NativeCompiler::program_hash(const QVector<stackinterpreter::bytecode_cell> &code){
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(QByteArrayView(native_abi, static_cast<qsizetype>(std::strlen(native_abi))));
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(code.constData()), code.size() * static_cast<qsizetype>(sizeof(stackinterpreter::bytecode_cell))));
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCompiler
+ * @brief Write the C file of a program: one function running it from any offset (A switch on the start offset).
+ * @param code - Program bytecode.
+ * @param source_path - Path of the C file.
+ * @return False if the file could not be written.
+ * @details Every instruction is a case of the switch and falls through to the next one, branches jump to the label of
+ *          their target and RET goes back to the switch with the popped offset. The checks and their order are the
+ *          ones of the Interpreter run loop.
+*/
+bool stackinterpreter::NativeCompiler::generate(const QVector<stackinterpreter::bytecode_cell> &code, const QString &source_path){
+    const qsizetype size = code.size();
+    QVector<bool> targets(size + 1, false);
+    for(const stackinterpreter::bytecode_cell &cell : code)
+        if(stackinterpreter::instruction_is_branch(cell.opcode) && cell.operand >= 0 && cell.operand <= size)
+            targets[cell.operand] = true;
+
+    stackinterpreter::BufferedWriter out(source_path);
+    out << "/* Generated by StackInterpreter (NativeCompiler) */\n" << native_prologue;
+    out << "void " << entry_symbol << "(context *c){\n"
+           "    int32_t *const base = c->stack_base, *const limit = c->stack_limit;\n"
+           "    int32_t *sp = c->sp, tos = c->tos;\n"
+           "    int64_t *const return_base = c->return_base, *const return_limit = c->return_limit;\n"
+           "    int64_t *rsp = c->return_sp;\n"
+           "    int32_t *const mem = c->mem;\n"
+           "    uint64_t *const occupancy = c->occupancy;\n"
+           "    const int64_t mem_size = c->mem_size;\n"
+           "    uint64_t executed = 0;\n"
+           "    int64_t pc = c->pc;\n"
+           "    int32_t trap = 0;\n"
+           "    (void)base; (void)limit; (void)return_base; (void)return_limit; (void)mem; (void)occupancy; (void)mem_size;\n"
+           "dispatch:\n"
+           "    switch(pc){\n"
+           "    default: RAISE(pc, " << trap_code(stackinterpreter::Trap::INVALID_INSTRUCTION) << ")\n";
+    auto raise = [&out](const char *condition, qsizetype pc, stackinterpreter::Trap trap) -> void{
+        if(condition)
+            out << "    if(" << condition << ") ";
+        else
+            out << "    ";
+        out << "RAISE(" << pc << ", " << trap_code(trap) << ")\n";
+    };
+    for(qsizetype pc = 0; pc < size; ++pc){
+        const stackinterpreter::bytecode_cell &cell = code[pc];
+        out << "    case " << pc << ":";
+        if(targets[pc])
+            out << " L" << pc << ":";
+        out << "\n";
+        if(stackinterpreter::instruction_is_branch(cell.opcode) && (cell.operand < 0 || cell.operand > size)){
+            raise(nullptr, pc, stackinterpreter::Trap::INVALID_INSTRUCTION);
+            continue;
+        }
+        switch(cell.opcode){
+            case stackinterpreter::Instructions::PUSHI:
+                raise("sp == limit", pc, stackinterpreter::Trap::STACK_OVERFLOW);
+                out << "    sp[-1] = tos; tos = " << cell.operand << "; ++sp;\n";
+                break;
+            case stackinterpreter::Instructions::PUSH:
+                raise("sp == base", pc, stackinterpreter::Trap::STACK_UNDERFLOW);
+                if(cell.operand < 0){
+                    raise(nullptr, pc, stackinterpreter::Trap::INVALID_ADDRESS);
+                    continue;
+                }
+                out << "    if(" << cell.operand << " >= mem_size) RAISE(" << pc << ", " << trap_code(stackinterpreter::Trap::INVALID_ADDRESS) << ")\n";
+                out << "    mem[" << cell.operand << "] = tos; occupancy[" << (cell.operand >> 6) << "] |= BIT(" << cell.operand << ");\n    --sp; tos = sp[-1];\n";
+                break;
+            case stackinterpreter::Instructions::POP:
+                raise("sp == limit", pc, stackinterpreter::Trap::STACK_OVERFLOW);
+                if(cell.operand < 0){
+                    raise(nullptr, pc, stackinterpreter::Trap::INVALID_ADDRESS);
+                    continue;
+                }
+                out << "    if(" << cell.operand << " >= mem_size) RAISE(" << pc << ", " << trap_code(stackinterpreter::Trap::INVALID_ADDRESS) << ")\n";
+                out << "    if(!(occupancy[" << (cell.operand >> 6) << "] & BIT(" << cell.operand << "))) RAISE(" << pc << ", " << trap_code(stackinterpreter::Trap::EMPTY_MEMORY_SLOT) << ")\n";
+                out << "    sp[-1] = tos; tos = mem[" << cell.operand << "]; ++sp; occupancy[" << (cell.operand >> 6) << "] &= ~BIT(" << cell.operand << ");\n";
+                break;
+            case stackinterpreter::Instructions::INPUT:
+                raise("sp == limit", pc, stackinterpreter::Trap::STACK_OVERFLOW);
+                out << "    { const int64_t value = c->input(c->io);\n"
+                       "      if(value == NO_INPUT) RAISE(" << pc << ", " << trap_code(stackinterpreter::Trap::WAITING_INPUT) << ")\n"
+                       "      sp[-1] = tos; tos = (int32_t)value; ++sp; }\n";
+                break;
+            case stackinterpreter::Instructions::INPUTN:
+                if(cell.operand < 0){
+                    raise(nullptr, pc, stackinterpreter::Trap::INVALID_OPERAND);
+                    continue;
+                }
+                out << "    if(limit - sp < " << cell.operand << ") RAISE(" << pc << ", " << trap_code(stackinterpreter::Trap::STACK_OVERFLOW) << ")\n";
+                out << "    sp[-1] = tos;\n"
+                       "    if(!c->input_n(c->io, sp, " << cell.operand << ")) RAISE(" << pc << ", " << trap_code(stackinterpreter::Trap::WAITING_INPUT) << ")\n"
+                       "    sp += " << cell.operand << "; tos = sp[-1];\n";
+                break;
+            case stackinterpreter::Instructions::PRINT:
+                raise("sp == base", pc, stackinterpreter::Trap::STACK_UNDERFLOW);
+                out << "    c->print(c->io, tos); --sp; tos = sp[-1];\n";
+                break;
+            case stackinterpreter::Instructions::ADD:
+            case stackinterpreter::Instructions::SUB:
+            case stackinterpreter::Instructions::MUL:
+                raise("sp - base < 2", pc, stackinterpreter::Trap::STACK_UNDERFLOW);
+                out << "    --sp; tos = WRAP(sp[-1], " << (cell.opcode == stackinterpreter::Instructions::ADD ? "+" : cell.opcode == stackinterpreter::Instructions::SUB ? "-" : "*") << ", tos);\n";
+                break;
+            case stackinterpreter::Instructions::DIV:
+                raise("sp - base < 2", pc, stackinterpreter::Trap::STACK_UNDERFLOW);
+                raise("tos == 0", pc, stackinterpreter::Trap::DIVISION_BY_ZERO);
+                out << "    --sp; tos = WRAP_DIV(sp[-1], tos);\n";
+                break;
+            case stackinterpreter::Instructions::SWAP:
+                raise("sp - base < 2", pc, stackinterpreter::Trap::STACK_UNDERFLOW);
+                out << "    { const int32_t value = sp[-2]; sp[-2] = tos; tos = value; }\n";
+                break;
+            case stackinterpreter::Instructions::DROP:
+                raise("sp == base", pc, stackinterpreter::Trap::STACK_UNDERFLOW);
+                out << "    --sp; tos = sp[-1];\n";
+                break;
+            case stackinterpreter::Instructions::DUP:
+                raise("sp == base", pc, stackinterpreter::Trap::STACK_UNDERFLOW);
+                raise("sp == limit", pc, stackinterpreter::Trap::STACK_OVERFLOW);
+                out << "    sp[-1] = tos; ++sp;\n";
+                break;
+            case stackinterpreter::Instructions::HLT:
+                out << "    sp = base; rsp = return_base; ++executed; pc = " << pc << "; goto stop;\n";
+                continue;
+            case stackinterpreter::Instructions::JMP:
+                out << "    ++executed; goto L" << cell.operand << ";\n";
+                continue;
+            case stackinterpreter::Instructions::JZ:
+            case stackinterpreter::Instructions::JNZ:
+                raise("sp == base", pc, stackinterpreter::Trap::STACK_UNDERFLOW);
+                out << "    ++executed;\n    { const int32_t value = tos; --sp; tos = sp[-1]; if(value " << (cell.opcode == stackinterpreter::Instructions::JZ ? "==" : "!=")
+                    << " 0) goto L" << cell.operand << "; }\n";
+                continue;
+            case stackinterpreter::Instructions::CALL:
+                raise("rsp == return_limit", pc, stackinterpreter::Trap::CALL_STACK_OVERFLOW);
+                out << "    *rsp++ = " << pc + 1 << "; ++executed; goto L" << cell.operand << ";\n";
+                continue;
+            case stackinterpreter::Instructions::RET:
+                raise("rsp == return_base", pc, stackinterpreter::Trap::CALL_STACK_UNDERFLOW);
+                out << "    ++executed; pc = *--rsp; goto dispatch;\n";
+                continue;
+            default: // Instructions::ERROR and opcodes out of the instruction set
+                raise(nullptr, pc, stackinterpreter::Trap::INVALID_INSTRUCTION);
+                continue;
+        }
+        out << "    ++executed;\n";
+    }
+    out << "    case " << size << ": L" << size << ":\n"
+           "        pc = " << size << ";\n"
+           "    }\n"
+           "stop:\n"
+           "    c->sp = sp; c->tos = tos; c->return_sp = rsp;\n"
+           "    c->executed = executed; c->pc = pc; c->trap = trap;\n"
+           "}\n";
+    if(!out.close()){
+        failure = "Cannot write " + source_path;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCompiler
+ * @brief Build a C file into a shared object with the system compiler ($STACKINTERPRETER_CC, default cc).
+ * @param source_path - Path of the C file.
+ * @param output_path - Path of the shared object.
+ * @return False if the compiler could not be started or failed (Its output is kept in the failure).
+*/
+bool stackinterpreter::NativeCompiler::compile(const QString &source_path, const QString &output_path){
+    const QString compiler = qEnvironmentVariable("STACKINTERPRETER_CC", "cc");
+    QProcess process;
+    process.setProcessChannelMode(QProcess::MergedChannels);
+    process.start(compiler, QStringList() << "-O2" << "-shared" << "-fPIC" << "-w" << "-o" << output_path << source_path);
+    if(!process.waitForStarted(-1)){
+        failure = "Cannot start the compiler " + compiler;
+        return false;
+    }
+    process.waitForFinished(-1);
+    if(process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0){
+        failure = compiler + " failed: " + QString::fromUtf8(process.readAll()).trimmed();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCompiler
+ * @brief Load a shared object and resolve its entry point.
+ * @param path - Path of the shared object.
+ * @return False if it could not be loaded (The failure holds the loader error).
+*/
+bool stackinterpreter::NativeCompiler::load(const QString &path){
+#ifdef STACKINTERPRETER_NATIVE
+    void *handle = dlopen(path.toStdString().c_str(), RTLD_NOW | RTLD_LOCAL);
+    if(!handle){
+        failure = QString::fromUtf8(dlerror());
+        return false;
+    }
+    void *symbol = dlsym(handle, entry_symbol);
+    if(!symbol){
+        failure = QString::fromUtf8(dlerror());
+        dlclose(handle);
+        return false;
+    }
+    library = handle;
+    entry = reinterpret_cast<native_entry>(symbol);
+    failure.clear();
+    return true;
+#else
+    Q_UNUSED(path);
+    return false;
+#endif
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCompiler
+ * @brief Run the loaded program until HLT (or the end of the program), a trap or a missing input value.
+ * @param stack - Instance of Stack class that will execute the program.
+ * @param pc - Offset of the first instruction to be executed (0 to start, run_result::pc to resume).
+ * @param io - Values consumed by INPUT and written by PRINT.
+ * @return The trap that stopped the run, where it stopped and how many instructions were executed.
+*/
+stackinterpreter::run_result stackinterpreter::NativeCompiler::run(stackinterpreter::Stack &stack, qsizetype pc, stackinterpreter::io_buffers &io) noexcept{
+    stackinterpreter::run_result result;
+    if(!entry || pc < 0 || pc > size()){
+        result.trap = stackinterpreter::Trap::INVALID_INSTRUCTION;
+        result.pc = pc;
+        return result;
+    }
+    native_context context;
+    context.stack_base = stack.buffer.data() + 1;
+    context.stack_limit = context.stack_base + stack.max_size;
+    context.sp = context.stack_base + stack.depth;
+    context.tos = stack.depth ? context.sp[-1] : 0;
+    /// The native code pushes the return offsets directly in the storage of the return stack
+    const qsizetype return_depth = stack.return_stack.size();
+    stack.return_stack.resize(qMax(stack.max_call_depth, return_depth));
+    context.return_base = stack.return_stack.data();
+    context.return_sp = context.return_base + return_depth;
+    context.return_limit = context.return_base + stack.max_call_depth;
+    context.mem = stack.values.data();
+    context.occupancy = stack.occupancy.data();
+    context.mem_size = stack.max_mem_size;
+    context.input = native_input;
+    context.input_n = native_input_n;
+    context.print = native_print;
+    context.io = &io;
+    context.executed = 0;
+    context.pc = pc;
+    context.trap = static_cast<qint32>(stackinterpreter::Trap::NONE);
+
+    entry(&context);
+
+    context.sp[-1] = context.tos; // Writes the cached top back (The scratch slot when the stack is empty)
+    stack.depth = context.sp - context.stack_base;
+    stack.return_stack.resize(context.return_sp - context.return_base);
+    stack.mark_all_dirty(); // The compiled code does not track its stores
+    result.trap = static_cast<stackinterpreter::Trap>(context.trap);
+    result.pc = context.pc;
+    result.executed = context.executed;
+    return result;
+}
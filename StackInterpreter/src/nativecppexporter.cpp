@@ -0,0 +1,370 @@
+#include "../headers/nativecppexporter.h"
+#include <QFile>
+#include <algorithm>
+
+namespace{
+
+/// @brief Write the name of the local variable holding a stack slot
+stackinterpreter::BufferedWriter& slot(stackinterpreter::BufferedWriter &out, qint32 index){
+    return out << "s" << index;
+}
+
+/// @brief Write the label of an instruction of an inlined routine (The end of the program is the halt label)
+stackinterpreter::BufferedWriter& label(stackinterpreter::BufferedWriter &out, qsizetype id, qsizetype pc, qsizetype size){
+    if(pc == size)
+        return out << "halt";
+    return out << "L" << id << "_" << pc;
+}
+
+} // namespace
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCPPExporter @extends Exporter
+ * @brief Constructor - Takes the sizes of the exported stack, memory and call stack from a Stack.
+ * @param _filename - Path of the .cpp file.
+ * @param stack - Stack whose sizes the exported program must reproduce (Same traps as running the program on it).
+*/
+stackinterpreter::NativeCPPExporter::NativeCPPExporter(const char *_filename, const stackinterpreter::Stack &stack) :
+    filename(_filename), stack_size(stack.get_max_size()), memory_size(stack.get_max_mem_size()), call_depth(stack.get_max_call_depth()){}
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCPPExporter @extends Exporter
+ * @name export_to_file
+ * @brief Create a .cpp (C++ file) running the program with every stack slot in a local variable
+ * @param code - Assembled program (Control flow included)
+ * @return true if successfully exported, else false (See get_failure())
+ */
+bool stackinterpreter::NativeCPPExporter::export_to_file(const QVector<stackinterpreter::bytecode_cell> &code) const{
+    failure.clear();
+    if(!code.size())
+        return fail("Empty program");
+    export_state state;
+    state.code = &code;
+    state.instances.append(routine_instance(0, 0));
+    if(!analyze(state, 0, 0))
+        return false;
+
+    stackinterpreter::BufferedWriter cppfile(filename);
+    const qsizetype memory_cells = qMax<qsizetype>(memory_size, 1);
+    cppfile << "// Exported by StackInterpreter: every stack slot is a local variable and the memory is a flat array\n";
+    cppfile << "#include <cstdio>\n#include <cstdlib>\n\n";
+    if(state.uses_memory)
+        cppfile << "static int memory[" << memory_cells << "];\nstatic bool occupied[" << memory_cells << "];\n\n";
+    cppfile << "[[noreturn, maybe_unused]] static void trap(int pc, const char *message){\n"
+               "    std::fflush(stdout);\n"
+               "    std::fprintf(stderr, \"trap at pc %d: %s\\n\", pc, message);\n"
+               "    std::exit(1);\n}\n\n";
+    cppfile << "[[maybe_unused]] static int input(int pc){\n"
+               "    int value;\n"
+               "    if(std::scanf(\"%d\", &value) != 1)\n"
+               "        trap(pc, \"" << stackinterpreter::trap_message(stackinterpreter::Trap::WAITING_INPUT) << "\");\n"
+               "    return value;\n}\n\n";
+    cppfile << "static inline int wrap_add(int lhs, int rhs){ return static_cast<int>(static_cast<unsigned>(lhs) + static_cast<unsigned>(rhs)); }\n"
+               "static inline int wrap_sub(int lhs, int rhs){ return static_cast<int>(static_cast<unsigned>(lhs) - static_cast<unsigned>(rhs)); }\n"
+               "static inline int wrap_mul(int lhs, int rhs){ return static_cast<int>(static_cast<unsigned>(lhs) * static_cast<unsigned>(rhs)); }\n"
+               "static inline int wrap_div(int lhs, int rhs){ return rhs == -1 ? wrap_sub(0, lhs) : lhs / rhs; }\n\n";
+    cppfile << "int main(){\n";
+    for(qint32 index = 0; index < state.max_depth; ++index)
+        slot(cppfile << (index ? ", " : "    [[maybe_unused]] int "), index) << " = 0";
+    if(state.max_depth)
+        cppfile << ";\n";
+    emit_instance(state, 0, cppfile);
+    if(state.halts)
+        cppfile << "halt:\n";
+    cppfile << "    std::fflush(stdout);\n    return 0;\n}\n";
+    if(!cppfile.close()){
+        QFile::remove(filename);
+        return fail("Write error");
+    }
+    return true;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCPPExporter @extends Exporter
+ * @brief Simulate the stack depth of every instruction reached by an instance, inlining the subroutines it calls.
+ * @param state - Export state (The instance is state.instances[id]).
+ * @param id - Index of the instance.
+ * @param entry_depth - Stack depth when the instance starts.
+ * @return False if the instance can not be exported.
+*/
+bool stackinterpreter::NativeCPPExporter::analyze(export_state &state, qsizetype id, qint32 entry_depth) const{
+    const QVector<stackinterpreter::bytecode_cell> &code = *state.code;
+    const qsizetype size = code.size();
+    const qsizetype entry = state.instances[id].entry;
+    const qint32 nesting = state.instances[id].nesting;
+    QVector<qsizetype> worklist;
+    qint32 return_depth = -1;
+    state.call_chain.append(entry);
+
+    auto reach = [&](qsizetype to, qint32 depth) -> bool{
+        state.max_depth = qMax(state.max_depth, depth);
+        if(to == size){
+            state.halts = true; // Falls off the program
+            return true;
+        }
+        routine_instance &instance = state.instances[id];
+        if(!instance.depth_at.contains(to)){
+            if(++state.cells > max_cells)
+                return fail("Program too large once the subroutines are inlined");
+            instance.depth_at.insert(to, depth);
+            instance.reached.append(to);
+            worklist.append(to);
+            return true;
+        }
+        return instance.depth_at.value(to) == depth || fail("Inconsistent stack depth at offset " + QString::number(to));
+    };
+
+    if(id)
+        state.instances[id].labels.insert(entry, true); // Jumped to by the CALL
+    if(!reach(entry, entry_depth))
+        return false;
+    while(!worklist.isEmpty()){
+        const qsizetype pc = worklist.takeLast();
+        const stackinterpreter::bytecode_cell &cell = code[pc];
+        const qint32 depth = state.instances[id].depth_at.value(pc);
+        if(static_trap(cell, depth, nesting, size) != stackinterpreter::Trap::NONE)
+            continue;
+        switch(cell.opcode){
+            case stackinterpreter::Instructions::POP:
+                state.uses_memory = true;
+                [[fallthrough]];
+            case stackinterpreter::Instructions::PUSHI:
+            case stackinterpreter::Instructions::INPUT:
+            case stackinterpreter::Instructions::DUP:
+                if(!reach(pc + 1, depth + 1))
+                    return false;
+                break;
+            case stackinterpreter::Instructions::INPUTN: // One line per value
+                if((state.cells += cell.operand) > max_cells)
+                    return fail("Program too large once the subroutines are inlined");
+                if(!reach(pc + 1, depth + cell.operand))
+                    return false;
+                break;
+            case stackinterpreter::Instructions::PUSH:
+                state.uses_memory = true;
+                if(!reach(pc + 1, depth - 1))
+                    return false;
+                break;
+            case stackinterpreter::Instructions::PRINT:
+            case stackinterpreter::Instructions::DROP:
+            case stackinterpreter::Instructions::ADD:
+            case stackinterpreter::Instructions::SUB:
+            case stackinterpreter::Instructions::MUL:
+            case stackinterpreter::Instructions::DIV:
+                if(!reach(pc + 1, depth - 1))
+                    return false;
+                break;
+            case stackinterpreter::Instructions::SWAP:
+                if(!reach(pc + 1, depth))
+                    return false;
+                break;
+            case stackinterpreter::Instructions::JMP:
+                state.instances[id].labels.insert(cell.operand, true);
+                if(!reach(cell.operand, depth))
+                    return false;
+                break;
+            case stackinterpreter::Instructions::JZ:
+            case stackinterpreter::Instructions::JNZ:
+                state.instances[id].labels.insert(cell.operand, true);
+                if(!reach(cell.operand, depth - 1) || !reach(pc + 1, depth - 1))
+                    return false;
+                break;
+            case stackinterpreter::Instructions::CALL:{
+                if(state.call_chain.contains(cell.operand))
+                    return fail("Recursive CALL at offset " + QString::number(pc) + " can not be exported");
+                const qsizetype callee = state.instances.size();
+                state.instances.append(routine_instance(cell.operand, nesting + 1));
+                state.instances[id].callees.insert(pc, callee);
+                if(!analyze(state, callee, depth))
+                    return false;
+                if(state.instances[callee].return_depth >= 0 && !reach(pc + 1, state.instances[callee].return_depth))
+                    return false;
+                break;
+            }
+            case stackinterpreter::Instructions::RET:
+                if(return_depth >= 0 && return_depth != depth)
+                    return fail("Subroutine at offset " + QString::number(entry) + " returns with different stack depths");
+                return_depth = depth;
+                break;
+            default: // HLT
+                state.halts = true;
+                break;
+        }
+    }
+    routine_instance &instance = state.instances[id];
+    instance.return_depth = return_depth;
+    std::sort(instance.reached.begin(), instance.reached.end());
+    state.call_chain.removeLast();
+    return true;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCPPExporter @extends Exporter
+ * @brief Write the code of an instance (And of the instances it inlines) in offset order.
+ * @param state - Analyzed export state.
+ * @param id - Index of the instance.
+ * @param out - Output file.
+ * @details The successor of every instruction wich does not transfer control is the next offset written, the only
+ *          exception is the end of the program (A jump to the halt label).
+*/
+void stackinterpreter::NativeCPPExporter::emit_instance(const export_state &state, qsizetype id, stackinterpreter::BufferedWriter &out) const{
+    const QVector<stackinterpreter::bytecode_cell> &code = *state.code;
+    const qsizetype size = code.size();
+    const routine_instance &instance = state.instances[id];
+    for(const qsizetype pc : instance.reached){
+        const stackinterpreter::bytecode_cell &cell = code[pc];
+        const qint32 depth = instance.depth_at.value(pc);
+        const qint32 top = depth - 1, below = depth - 2;
+        if(instance.labels.contains(pc))
+            label(out, id, pc, size) << ":\n";
+        const stackinterpreter::Trap trap = static_trap(cell, depth, instance.nesting, size);
+        if(trap != stackinterpreter::Trap::NONE){
+            out << "    trap(" << pc << ", \"" << stackinterpreter::trap_message(trap) << "\");\n";
+            continue;
+        }
+        bool falls_through = true;
+        switch(cell.opcode){
+            case stackinterpreter::Instructions::PUSHI:
+                slot(out << "    ", depth) << " = " << cell.operand << ";\n";
+                break;
+            case stackinterpreter::Instructions::PUSH:
+                slot(out << "    memory[" << cell.operand << "] = ", top) << ";\n    occupied[" << cell.operand << "] = true;\n";
+                break;
+            case stackinterpreter::Instructions::POP:
+                out << "    if(!occupied[" << cell.operand << "])\n        trap(" << pc << ", \"" << stackinterpreter::trap_message(stackinterpreter::Trap::EMPTY_MEMORY_SLOT) << "\");\n";
+                slot(out << "    occupied[" << cell.operand << "] = false;\n    ", depth) << " = memory[" << cell.operand << "];\n";
+                break;
+            case stackinterpreter::Instructions::INPUT:
+                slot(out << "    ", depth) << " = input(" << pc << ");\n";
+                break;
+            case stackinterpreter::Instructions::INPUTN:
+                for(qint32 index = depth; index < depth + cell.operand; ++index)
+                    slot(out << "    ", index) << " = input(" << pc << ");\n";
+                break;
+            case stackinterpreter::Instructions::PRINT:
+                slot(out << "    std::printf(\"%d\\n\", ", top) << ");\n";
+                break;
+            case stackinterpreter::Instructions::ADD:
+                slot(slot(slot(out << "    ", below) << " = wrap_add(", below) << ", ", top) << ");\n";
+                break;
+            case stackinterpreter::Instructions::SUB:
+                slot(slot(slot(out << "    ", below) << " = wrap_sub(", below) << ", ", top) << ");\n";
+                break;
+            case stackinterpreter::Instructions::MUL:
+                slot(slot(slot(out << "    ", below) << " = wrap_mul(", below) << ", ", top) << ");\n";
+                break;
+            case stackinterpreter::Instructions::DIV:
+                slot(out << "    if(", top) << " == 0)\n        trap(" << pc << ", \"" << stackinterpreter::trap_message(stackinterpreter::Trap::DIVISION_BY_ZERO) << "\");\n";
+                slot(slot(slot(out << "    ", below) << " = wrap_div(", below) << ", ", top) << ");\n";
+                break;
+            case stackinterpreter::Instructions::SWAP:
+                slot(slot(slot(slot(out << "    { const int swapped = ", top) << "; ", top) << " = ", below) << "; ", below) << " = swapped; }\n";
+                break;
+            case stackinterpreter::Instructions::DROP:
+                break;
+            case stackinterpreter::Instructions::DUP:
+                slot(slot(out << "    ", depth) << " = ", top) << ";\n";
+                break;
+            case stackinterpreter::Instructions::HLT:
+                out << "    goto halt;\n";
+                falls_through = false;
+                break;
+            case stackinterpreter::Instructions::JMP:
+                label(out << "    goto ", id, cell.operand, size) << ";\n";
+                falls_through = false;
+                break;
+            case stackinterpreter::Instructions::JZ:
+            case stackinterpreter::Instructions::JNZ:
+                slot(out << "    if(", top) << (cell.opcode == stackinterpreter::Instructions::JZ ? " == 0)\n" : " != 0)\n");
+                label(out << "        goto ", id, cell.operand, size) << ";\n";
+                break;
+            case stackinterpreter::Instructions::CALL:{
+                const qsizetype callee = instance.callees.value(pc);
+                label(out << "    goto ", callee, cell.operand, size) << ";\n";
+                emit_instance(state, callee, out);
+                if(state.instances[callee].return_depth >= 0)
+                    out << "R" << callee << ":\n";
+                else
+                    falls_through = false;
+                break;
+            }
+            case stackinterpreter::Instructions::RET:
+                out << "    goto R" << id << ";\n";
+                falls_through = false;
+                break;
+            default:
+                break;
+        }
+        if(falls_through && pc + 1 == size)
+            out << "    goto halt;\n";
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class NativeCPPExporter @extends Exporter
+ * @brief Return the trap an instruction always raises at a given stack depth (Same checks and order as the run loops).
+ * @param cell - Instruction.
+ * @param depth - Stack depth before the instruction.
+ * @param nesting - Pending CALL instructions.
+ * @param size - Number of instructions of the program.
+ * @return The trap raised, Trap::NONE if the instruction may execute (Run time checks excluded).
+*/
+stackinterpreter::Trap stackinterpreter::NativeCPPExporter::static_trap(const stackinterpreter::bytecode_cell &cell, qint32 depth, qint32 nesting, qsizetype size) const noexcept{
+    const bool invalid_address = cell.operand < 0 || cell.operand >= memory_size;
+    if(stackinterpreter::instruction_is_branch(cell.opcode) && (cell.operand < 0 || cell.operand > size))
+        return stackinterpreter::Trap::INVALID_INSTRUCTION;
+    switch(cell.opcode){
+        case stackinterpreter::Instructions::PUSHI:
+        case stackinterpreter::Instructions::INPUT:
+            return depth >= stack_size ? stackinterpreter::Trap::STACK_OVERFLOW : stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::INPUTN:
+            if(cell.operand < 0)
+                return stackinterpreter::Trap::INVALID_OPERAND;
+            return cell.operand > stack_size - depth ? stackinterpreter::Trap::STACK_OVERFLOW : stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::PUSH:
+            if(depth < 1)
+                return stackinterpreter::Trap::STACK_UNDERFLOW;
+            return invalid_address ? stackinterpreter::Trap::INVALID_ADDRESS : stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::POP:
+            if(depth >= stack_size)
+                return stackinterpreter::Trap::STACK_OVERFLOW;
+            return invalid_address ? stackinterpreter::Trap::INVALID_ADDRESS : stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::PRINT:
+        case stackinterpreter::Instructions::DROP:
+        case stackinterpreter::Instructions::JZ:
+        case stackinterpreter::Instructions::JNZ:
+            return depth < 1 ? stackinterpreter::Trap::STACK_UNDERFLOW : stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::ADD:
+        case stackinterpreter::Instructions::SUB:
+        case stackinterpreter::Instructions::MUL:
+        case stackinterpreter::Instructions::DIV:
+        case stackinterpreter::Instructions::SWAP:
+            return depth < 2 ? stackinterpreter::Trap::STACK_UNDERFLOW : stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::DUP:
+            if(depth < 1)
+                return stackinterpreter::Trap::STACK_UNDERFLOW;
+            return depth >= stack_size ? stackinterpreter::Trap::STACK_OVERFLOW : stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::HLT:
+        case stackinterpreter::Instructions::JMP:
+            return stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::CALL:
+            return nesting >= call_depth ? stackinterpreter::Trap::CALL_STACK_OVERFLOW : stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::RET:
+            return nesting == 0 ? stackinterpreter::Trap::CALL_STACK_UNDERFLOW : stackinterpreter::Trap::NONE;
+        case stackinterpreter::Instructions::ERROR:
+            return stackinterpreter::Trap::INVALID_OPERAND;
+        default:
+            return stackinterpreter::Trap::INVALID_INSTRUCTION;
+    }
+}
+
+/// @brief Record why the export failed, always returns false
+bool stackinterpreter::NativeCPPExporter::fail(const QString &reason) const{
+    failure = reason;
+    return false;
+}
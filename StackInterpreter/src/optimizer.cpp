@@ -0,0 +1,202 @@
+/**
+ * @file optimizer.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/optimizer.h"
+#include <QHash>
+
+/**
+ * @namespace stackinterpreter
+ * @class Optimizer
+ * @brief Optimize an assembled program.
+ * @param program - Assembled program (Not modified).
+ * @param optimized - Receives the optimized program.
+ * @param memory_size - Memory size the program will run with, 0 keeps every store (Use 0 when the memory is inspected after the run).
+ * @return Number of instructions eliminated.
+*/
+qsizetype stackinterpreter::Optimizer::optimize(const Program &program, Program &optimized, qsizetype memory_size) noexcept{
+    folded = unreachable = dead_stores = 0;
+    QVector<optimized_cell> code;
+    QVector<qsizetype> fold_map, reach_map;
+    fold(program, memory_size, code, fold_map);
+    remove_unreachable(code, reach_map);
+
+    optimized.clear();
+    for(const optimized_cell &cell : code)
+        optimized.append(cell.cell.opcode, cell.cell.operand, cell.line);
+    for(auto it = program.get_labels().cbegin(); it != program.get_labels().cend(); ++it)
+        if(it.value() >= 0 && it.value() <= program.size())
+            optimized.add_label(it.key(), reach_map[fold_map[it.value()]]);
+    return get_eliminated();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Optimizer
+ * @brief Fold the constant expressions of every basic block and drop the dead stores.
+ * @param program - Assembled program.
+ * @param memory_size - Stores to addresses below it which are never read become DROP (0 disables it).
+ * @param out - Receives the folded code (Branch targets already remapped).
+ * @param map - Receives the folded offset of every original offset (Plus the end of the program).
+ * @details The last instructions of out which are PUSHI emitted in the current block are the constants of the top of the
+ *          stack, instructions working only on them are evaluated here. Branch targets and return addresses start a new
+ *          block, so a branch never lands in the middle of a folded expression.
+*/
+void stackinterpreter::Optimizer::fold(const Program &program, qsizetype memory_size, QVector<optimized_cell> &out, QVector<qsizetype> &map) noexcept{
+    const QVector<stackinterpreter::bytecode_cell> &code = program.get_code();
+    const qsizetype size = code.size();
+    QVector<bool> leader(size + 1, false);
+    QHash<qint32, bool> read; /// Addresses loaded by a POP (Sparse, the memory may have up to 2^30 slots)
+    for(qsizetype pc = 0; pc < size; ++pc){
+        if(stackinterpreter::instruction_is_branch(code[pc].opcode) && code[pc].operand >= 0 && code[pc].operand <= size)
+            leader[code[pc].operand] = true;
+        if(code[pc].opcode == stackinterpreter::Instructions::POP && code[pc].operand >= 0 && code[pc].operand < memory_size)
+            read.insert(code[pc].operand, true);
+    }
+
+    out.clear();
+    map.fill(0, size + 1);
+    qsizetype constants = 0; /// Trailing PUSHI of out emitted in the current block
+    for(qsizetype pc = 0; pc < size; ++pc){
+        map[pc] = out.size();
+        if(leader[pc])
+            constants = 0;
+        qint32 opcode = code[pc].opcode;
+        const qint32 operand = code[pc].operand;
+        const int line = program.line_of(pc);
+        if(opcode == stackinterpreter::Instructions::PUSH && operand >= 0 && operand < memory_size && !read.contains(operand)){
+            opcode = stackinterpreter::Instructions::DROP; // Same stack effect and checks, the value is never read back
+            ++dead_stores;
+        }
+        qint32 result;
+        switch(opcode){
+            case stackinterpreter::Instructions::PUSHI:
+                out.append(optimized_cell(opcode, operand, line));
+                ++constants;
+                continue;
+            case stackinterpreter::Instructions::DUP:
+                if(constants < 1)
+                    break;
+                out.append(optimized_cell(stackinterpreter::Instructions::PUSHI, out.last().cell.operand, line));
+                ++constants;
+                continue; // DUP replaced by PUSHI, nothing eliminated
+            case stackinterpreter::Instructions::DROP:
+                if(constants < 1)
+                    break;
+                out.removeLast();
+                --constants;
+                folded += 2;
+                continue;
+            case stackinterpreter::Instructions::SWAP:
+                if(constants < 2)
+                    break;
+                qSwap(out[out.size() - 1].cell.operand, out[out.size() - 2].cell.operand);
+                ++folded;
+                continue;
+            case stackinterpreter::Instructions::ADD:
+            case stackinterpreter::Instructions::SUB:
+            case stackinterpreter::Instructions::MUL:
+            case stackinterpreter::Instructions::DIV:
+                if(constants < 2 || !fold_arithmetic(opcode, out[out.size() - 2].cell.operand, out.last().cell.operand, result))
+                    break;
+                out.removeLast();
+                out.last().cell.operand = result;
+                --constants;
+                folded += 2;
+                continue;
+            case stackinterpreter::Instructions::JZ:
+            case stackinterpreter::Instructions::JNZ:{
+                if(constants < 1)
+                    break;
+                const bool taken = (out.last().cell.operand == 0) == (opcode == stackinterpreter::Instructions::JZ);
+                out.removeLast();
+                --constants;
+                if(taken){
+                    out.append(optimized_cell(stackinterpreter::Instructions::JMP, operand, line));
+                    constants = 0;
+                    ++folded;
+                }
+                else
+                    folded += 2;
+                continue;
+            }
+            default:
+                break;
+        }
+        out.append(optimized_cell(opcode, operand, line));
+        constants = 0;
+    }
+    map[size] = out.size();
+
+    for(optimized_cell &cell : out)
+        if(stackinterpreter::instruction_is_branch(cell.cell.opcode) && cell.cell.operand >= 0 && cell.cell.operand <= size)
+            cell.cell.operand = map[cell.cell.operand];
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Optimizer
+ * @brief Remove the instructions unreachable from pc 0.
+ * @param code - Folded code (Branch targets are remapped).
+ * @param map - Receives the new offset of every folded offset (Plus the end of the program).
+ * @details The instruction after a CALL is always reachable (Return address), even if the subroutine never returns.
+*/
+void stackinterpreter::Optimizer::remove_unreachable(QVector<optimized_cell> &code, QVector<qsizetype> &map) noexcept{
+    const qsizetype size = code.size();
+    QVector<bool> reached(size + 1, false);
+    QVector<qsizetype> worklist;
+    worklist.append(0);
+    while(!worklist.isEmpty()){
+        qsizetype pc = worklist.takeLast();
+        if(pc < 0 || pc > size || reached[pc])
+            continue;
+        reached[pc] = true;
+        if(pc == size)
+            continue;
+        const stackinterpreter::bytecode_cell &cell = code[pc].cell;
+        if(stackinterpreter::instruction_is_branch(cell.opcode))
+            worklist.append(cell.operand);
+        if(cell.opcode != stackinterpreter::Instructions::JMP && cell.opcode != stackinterpreter::Instructions::RET &&
+           cell.opcode != stackinterpreter::Instructions::HLT && cell.opcode != stackinterpreter::Instructions::ERROR)
+            worklist.append(pc + 1);
+    }
+
+    map.fill(0, size + 1);
+    qsizetype kept = 0;
+    for(qsizetype pc = 0; pc < size; ++pc){
+        map[pc] = kept;
+        if(reached[pc])
+            code[kept++] = code[pc];
+    }
+    map[size] = kept;
+    unreachable = size - kept;
+    code.resize(kept);
+    for(optimized_cell &cell : code)
+        if(stackinterpreter::instruction_is_branch(cell.cell.opcode) && cell.cell.operand >= 0 && cell.cell.operand <= size)
+            cell.cell.operand = map[cell.cell.operand];
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Optimizer
+ * @brief Evaluate an arithmetic instruction over two immediates (Wraps around like every backend, see wrapping_add).
+ * @param opcode - ADD, SUB, MUL or DIV.
+ * @param lhs - Value below the top of the stack.
+ * @param rhs - Top of the stack.
+ * @param result - Receives the folded value.
+ * @return False if the instruction must run (Division by zero traps).
+*/
+bool stackinterpreter::Optimizer::fold_arithmetic(qint32 opcode, qint32 lhs, qint32 rhs, qint32 &result) noexcept{
+    switch(opcode){
+        case stackinterpreter::Instructions::ADD: result = stackinterpreter::wrapping_add(lhs, rhs); return true;
+        case stackinterpreter::Instructions::SUB: result = stackinterpreter::wrapping_sub(lhs, rhs); return true;
+        case stackinterpreter::Instructions::MUL: result = stackinterpreter::wrapping_mul(lhs, rhs); return true;
+        case stackinterpreter::Instructions::DIV:
+            if(rhs == 0)
+                return false;
+            result = stackinterpreter::wrapping_div(lhs, rhs);
+            return true;
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * @file output_sink.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/output_sink.h"
+#include <algorithm>
+#include <charconv>
+
+namespace{
+
+/// Longest line written for a value: "-2147483648\n"
+constexpr qsizetype max_line = 12;
+
+} // namespace
+
+/**
+ * @namespace stackinterpreter
+ * @class BufferOutputSink
+ * @brief Append the values to the buffer.
+ * @param printed - Printed values.
+ * @param count - Number of values.
+*/
+void stackinterpreter::BufferOutputSink::write(const int *printed, qsizetype count){
+    const qsizetype size = values.size();
+    values.resize(size + count);
+    std::copy(printed, printed + count, values.data() + size);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TextOutputSink
+ * @brief Constructor - Writes to an open stream.
+ * @param _file - Stream (nullptr discards the values, see is_good()).
+ * @param _owned - True to close the stream in the destructor.
+*/
+stackinterpreter::TextOutputSink::TextOutputSink(std::FILE *_file, bool _owned) : file(_file), owned(_owned), buffer(write_size){}
+
+stackinterpreter::TextOutputSink::~TextOutputSink(){
+    static_cast<void>(flush());
+    if(file && owned)
+        std::fclose(file);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TextOutputSink
+ * @brief Append the values to the buffer, one per line.
+ * @param values - Printed values.
+ * @param count - Number of values.
+*/
+void stackinterpreter::TextOutputSink::write(const int *values, qsizetype count){
+    char *const data = buffer.data();
+    for(qsizetype i = 0; i < count; ++i){
+        if(used + max_line > buffer.size())
+            write_buffer();
+        const std::to_chars_result result = std::to_chars(data + used, data + used + max_line, values[i]);
+        *result.ptr = '\n';
+        used = result.ptr + 1 - data;
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TextOutputSink
+ * @brief Write the buffer and flush the stream.
+ * @return False if a write failed (Now or before).
+*/
+bool stackinterpreter::TextOutputSink::flush(){
+    write_buffer();
+    if(file && !failed && std::fflush(file) != 0)
+        failed = true;
+    return is_good();
+}
+
+/// @brief Write the buffered bytes to the stream (Dropped after a failure)
+void stackinterpreter::TextOutputSink::write_buffer() noexcept{
+    if(used && file && !failed && std::fwrite(buffer.constData(), 1, static_cast<size_t>(used), file) != static_cast<size_t>(used))
+        failed = true;
+    used = 0;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TextFileOutputSink
+ * @brief Constructor - Creates a text file (Discards the values if it can not be created, see is_good()).
+ * @param filename - Path of the file.
+*/
+stackinterpreter::TextFileOutputSink::TextFileOutputSink(const QString &filename) :
+    TextOutputSink(std::fopen(filename.toStdString().c_str(), "wb"), true){}
@@ -0,0 +1,60 @@
+/**
+ * @file peephole.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/peephole.h"
+
+/**
+ * @namespace stackinterpreter
+ * @class PeepholeOptimizer
+ * @brief Find the superinstruction of an instruction pair.
+ * @param first - Opcode of the first instruction.
+ * @param second - Opcode of the second instruction.
+ * @return The superinstruction opcode, or first if the pair is not in the table.
+*/
+qint32 stackinterpreter::PeepholeOptimizer::fuse(qint32 first, qint32 second) noexcept{
+#define STACKINTERPRETER_SUPERINSTRUCTION_FUSE(name, _first, _second) \
+    if(first == stackinterpreter::Instructions::_first && second == stackinterpreter::Instructions::_second) \
+        return stackinterpreter::InternalInstructions::name;
+    STACKINTERPRETER_SUPERINSTRUCTIONS(STACKINTERPRETER_SUPERINSTRUCTION_FUSE)
+#undef STACKINTERPRETER_SUPERINSTRUCTION_FUSE
+    return first;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class PeepholeOptimizer
+ * @brief Find the first instruction of a superinstruction (Used to run the pair as two instructions again).
+ * @param opcode - Opcode of a cell.
+ * @return The opcode of the first instruction, or opcode if it is not a superinstruction.
+*/
+qint32 stackinterpreter::PeepholeOptimizer::split(qint32 opcode) noexcept{
+#define STACKINTERPRETER_SUPERINSTRUCTION_SPLIT(name, _first, _second) \
+    if(opcode == stackinterpreter::InternalInstructions::name) \
+        return stackinterpreter::Instructions::_first;
+    STACKINTERPRETER_SUPERINSTRUCTIONS(STACKINTERPRETER_SUPERINSTRUCTION_SPLIT)
+#undef STACKINTERPRETER_SUPERINSTRUCTION_SPLIT
+    return opcode;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class PeepholeOptimizer
+ * @brief Fuse every instruction pair of the superinstruction table.
+ * @param code - Bytecode with base instructions only (Rewritten in place, the size never changes).
+ * @return Number of fused pairs.
+ * @details Every offset is checked against the original opcodes, so overlapping pairs (EX: DUP; DUP; MUL) are fused at both
+ *          offsets: the first superinstruction runs the first pair, the second one is used when a branch lands on it.
+*/
+qsizetype stackinterpreter::PeepholeOptimizer::optimize(QVector<bytecode_cell> &code) noexcept{
+    qsizetype fused = 0;
+    for(qsizetype pc = 0; pc + 1 < code.size(); ++pc){
+        qint32 next_opcode = code[pc + 1].opcode; // Still the original opcode, pc + 1 is rewritten on the next iteration
+        qint32 opcode = fuse(code[pc].opcode, next_opcode);
+        if(opcode != code[pc].opcode){
+            code[pc].opcode = opcode;
+            ++fused;
+        }
+    }
+    return fused;
+}
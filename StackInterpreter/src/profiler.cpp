@@ -0,0 +1,115 @@
+/**
+ * @file profiler.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/profiler.h"
+#include <algorithm>
+
+namespace{
+
+/// @brief Return the offsets with a non zero value, highest value first (At most top of them)
+QVector<qsizetype> hottest(const QVector<quint64> &values, qsizetype top){
+    QVector<qsizetype> offsets;
+    for(qsizetype pc = 0; pc < values.size(); ++pc)
+        if(values[pc])
+            offsets.append(pc);
+    const qsizetype kept = qMin(top, offsets.size());
+    std::partial_sort(offsets.begin(), offsets.begin() + kept, offsets.end(), [&values](qsizetype lhs, qsizetype rhs){
+        return values[lhs] != values[rhs] ? values[lhs] > values[rhs] : lhs < rhs;
+    });
+    offsets.resize(kept);
+    return offsets;
+}
+
+/// @brief Format a share of a total as a percentage
+QString percent(quint64 value, quint64 total){
+    return QString::number(total ? 100.0 * static_cast<double>(value) / static_cast<double>(total) : 0.0, 'f', 1).rightJustified(6) + "%";
+}
+
+/// @brief Format the instruction at an offset with its source line (The text of the line when the source is known)
+QString locate(const stackinterpreter::Program &program, const QStringList &source, qsizetype pc){
+    if(pc >= program.size())
+        return QString::number(pc).rightJustified(8) + "  end of program";
+    const stackinterpreter::bytecode_cell &cell = program.get_code()[pc];
+    QString instruction = stackinterpreter::instruction_mnemonic(cell.opcode);
+    if(stackinterpreter::instruction_has_operand(cell.opcode))
+        instruction += " " + QString::number(cell.operand);
+    const int line = program.line_of(pc);
+    QString located = QString::number(pc).rightJustified(8) + QString::number(line).rightJustified(7) + "  " + instruction.leftJustified(16);
+    if(line > 0 && line <= source.size())
+        located += "  " + source[line - 1].trimmed();
+    return located;
+}
+
+} // namespace
+
+/**
+ * @namespace stackinterpreter
+ * @class Profile
+ * @brief Clear the profile and size it for a program.
+ * @param cells - Number of bytecode cells of the program (Its end of program sentinel included).
+*/
+void stackinterpreter::Profile::reset(qsizetype cells){
+    counts.fill(0, cells);
+    branches.fill(0, cells);
+    block_entries.fill(0, cells);
+    block_instructions.fill(0, cells);
+    block_cycles.fill(0, cells);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Profile
+ * @brief Return the number of instructions executed by the profiled runs.
+*/
+quint64 stackinterpreter::Profile::get_executed() const noexcept{
+    quint64 executed = 0;
+    for(quint64 count : counts)
+        executed += count;
+    return executed;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Profile
+ * @brief Format the profile: executions per opcode, hottest instructions and hottest blocks with their source lines.
+ * @param program - Program the profile was recorded on (Same offsets as the one loaded by the Interpreter).
+ * @param source - Lines of the source file (Optional, the text of the lines is shown next to the instructions).
+ * @param top - Number of instructions and blocks listed.
+ * @return The report as text.
+*/
+QString stackinterpreter::Profile::report(const stackinterpreter::Program &program, const QStringList &source, qsizetype top) const{
+    const quint64 executed = get_executed();
+    quint64 taken = 0, total_cycles = 0;
+    for(quint64 count : branches)
+        taken += count;
+    for(quint64 count : block_cycles)
+        total_cycles += count;
+    QString text = "Profile: " + QString::number(executed) + " instructions executed, " + QString::number(taken) + " branches taken";
+    if(timed)
+        text += ", " + QString::number(total_cycles) + " cycles";
+    text += "\n\nOpcodes\n   executed       %  opcode\n";
+    QVector<quint64> opcodes(stackinterpreter::Instructions::ERROR + 1, 0);
+    for(qsizetype pc = 0; pc < program.size() && pc < counts.size(); ++pc){
+        const qint32 opcode = program.get_code()[pc].opcode;
+        opcodes[opcode >= 0 && opcode < opcodes.size() ? opcode : stackinterpreter::Instructions::ERROR] += counts[pc];
+    }
+    for(qsizetype opcode : hottest(opcodes, opcodes.size()))
+        text += QString::number(opcodes[opcode]).rightJustified(11) + percent(opcodes[opcode], executed) + "  " + stackinterpreter::instruction_mnemonic(static_cast<int>(opcode)) + "\n";
+
+    text += "\nHot instructions\n   executed       %  branches  offset   line  instruction\n";
+    for(qsizetype pc : hottest(counts, top))
+        text += QString::number(counts[pc]).rightJustified(11) + percent(counts[pc], executed) + QString::number(branches[pc]).rightJustified(10) + locate(program, source, pc) + "\n";
+
+    text += timed ? "\nHot blocks (By cycles)\n     cycles       %    entries  instructions  cycles/entry  offset   line  entry instruction\n"
+                  : "\nHot blocks (By instructions)\n    entries  instructions       %  offset   line  entry instruction\n";
+    for(qsizetype pc : hottest(timed ? block_cycles : block_instructions, top)){
+        if(timed)
+            text += QString::number(block_cycles[pc]).rightJustified(11) + percent(block_cycles[pc], total_cycles) + QString::number(block_entries[pc]).rightJustified(11) +
+                    QString::number(block_instructions[pc]).rightJustified(14) + QString::number(block_cycles[pc] / qMax<quint64>(block_entries[pc], 1)).rightJustified(14);
+        else
+            text += QString::number(block_entries[pc]).rightJustified(11) + QString::number(block_instructions[pc]).rightJustified(14) + percent(block_instructions[pc], executed);
+        text += locate(program, source, pc) + "\n";
+    }
+    return text;
+}
@@ -0,0 +1,29 @@
+/**
+ * @file program.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/program.h"
+
+/**
+ * @namespace stackinterpreter
+ * @class Program
+ * @brief Append a decoded instruction at the end of the bytecode.
+ * @param opcode - Instructions enum value.
+ * @param operand - Decoded operand (0 if the instruction has no operand).
+ * @param line - Source line of the instruction.
+*/
+void stackinterpreter::Program::append(qint32 opcode, qint32 operand, int line) noexcept{
+    code.append(stackinterpreter::bytecode_cell(opcode, operand));
+    lines.append(line);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Program
+ * @brief Remove every instruction and label of the program.
+*/
+void stackinterpreter::Program::clear() noexcept{
+    code.clear();
+    lines.clear();
+    labels.clear();
+}
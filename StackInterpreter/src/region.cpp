@@ -0,0 +1,160 @@
+/**
+ * @file region.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/region.h"
+#include <cstdlib>
+
+#if defined(__linux__) || defined(__APPLE__)
+#define STACKINTERPRETER_MMAP
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef STACKINTERPRETER_MMAP
+namespace{
+
+#ifdef MAP_NORESERVE
+constexpr int reserve_flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#else
+constexpr int reserve_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#endif
+
+/// @brief Return the size of a mapping holding bytes (Rounded up to whole pages) plus its guard page
+qsizetype mapped_size(qsizetype bytes) noexcept{
+    return stackinterpreter::Mapping::round_up(bytes) + stackinterpreter::Mapping::page_size();
+}
+
+/// @brief Make the page after the data of a mapping inaccessible
+bool protect_guard(void *address, qsizetype bytes) noexcept{
+    return mprotect(static_cast<char*>(address) + stackinterpreter::Mapping::round_up(bytes), static_cast<size_t>(stackinterpreter::Mapping::page_size()), PROT_NONE) == 0;
+}
+
+} // namespace
+#endif
+
+/// @brief Return the size of a page (1 without mmap, the heap is not page aligned)
+qsizetype stackinterpreter::Mapping::page_size() noexcept{
+#ifdef STACKINTERPRETER_MMAP
+    static const qsizetype size = static_cast<qsizetype>(sysconf(_SC_PAGESIZE));
+    return size;
+#else
+    return 1;
+#endif
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Mapping
+ * @brief Reserve a zeroed region followed by a guard page.
+ * @param bytes - Size of the region.
+ * @return The region, nullptr if it could not be reserved.
+*/
+void* stackinterpreter::Mapping::map(qsizetype bytes) noexcept{
+#ifdef STACKINTERPRETER_MMAP
+    void *address = mmap(nullptr, static_cast<size_t>(mapped_size(bytes)), PROT_READ | PROT_WRITE, reserve_flags, -1, 0);
+    if(address == MAP_FAILED)
+        return nullptr;
+    if(!protect_guard(address, bytes)){
+        munmap(address, static_cast<size_t>(mapped_size(bytes)));
+        return nullptr;
+    }
+    return address;
+#else
+    return std::calloc(static_cast<size_t>(bytes), 1);
+#endif
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Mapping
+ * @brief Grow or shrink a region returned by map, keeping its first bytes.
+ * @param address - Region.
+ * @param old_bytes - Current size of the region.
+ * @param new_bytes - New size of the region.
+ * @return The region (It may have moved), nullptr if it could not be resized (The old region is kept).
+ * @details Linux moves the page tables (mremap), nothing is copied or committed. Elsewhere the touched content is
+ *          copied to a new mapping. The bytes past the old pages are zero.
+*/
+void* stackinterpreter::Mapping::remap(void *address, qsizetype old_bytes, qsizetype new_bytes) noexcept{
+#ifdef STACKINTERPRETER_MMAP
+    if(mapped_size(old_bytes) == mapped_size(new_bytes))
+        return address; // Same pages, the guard page does not move
+#ifdef __linux__
+    /// The guard page is a mapping of its own (Other protection), made accessible so the whole region moves at once
+    if(mprotect(static_cast<char*>(address) + round_up(old_bytes), static_cast<size_t>(page_size()), PROT_READ | PROT_WRITE) != 0)
+        return nullptr;
+    void *moved = mremap(address, static_cast<size_t>(mapped_size(old_bytes)), static_cast<size_t>(mapped_size(new_bytes)), MREMAP_MAYMOVE);
+    if(moved == MAP_FAILED){
+        protect_guard(address, old_bytes);
+        /// Regions holding file pages (map_file) are several mappings, mremap only moves one: copied instead
+        if(!(moved = map(new_bytes)))
+            return nullptr;
+        std::memcpy(moved, address, static_cast<size_t>(qMin(old_bytes, new_bytes)));
+        unmap(address, old_bytes);
+        return moved;
+    }
+    if(new_bytes > old_bytes) // The old guard page was never written, but mremap keeps its content: cleared like fresh pages
+        std::memset(static_cast<char*>(moved) + round_up(old_bytes), 0, static_cast<size_t>(page_size()));
+    protect_guard(moved, new_bytes);
+    return moved;
+#else
+    void *moved = map(new_bytes);
+    if(!moved)
+        return nullptr;
+    std::memcpy(moved, address, static_cast<size_t>(qMin(old_bytes, new_bytes)));
+    unmap(address, old_bytes);
+    return moved;
+#endif
+#else
+    void *moved = std::realloc(address, static_cast<size_t>(new_bytes));
+    if(moved && new_bytes > old_bytes)
+        std::memset(static_cast<char*>(moved) + old_bytes, 0, static_cast<size_t>(new_bytes - old_bytes));
+    return moved;
+#endif
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Mapping
+ * @brief Release a region returned by map or remap (Nothing if address is nullptr).
+ * @param address - Region.
+ * @param bytes - Size of the region.
+*/
+void stackinterpreter::Mapping::unmap(void *address, qsizetype bytes) noexcept{
+    if(!address)
+        return;
+#ifdef STACKINTERPRETER_MMAP
+    munmap(address, static_cast<size_t>(mapped_size(bytes)));
+#else
+    Q_UNUSED(bytes);
+    std::free(address);
+#endif
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Mapping
+ * @brief Map a file over the first pages of a region returned by map or remap, copy-on-write.
+ * @param address - Region.
+ * @param bytes - Number of bytes of the region replaced by the file (Rounded up to whole pages).
+ * @param fd - File descriptor of the file, opened for reading.
+ * @param offset - Offset of the bytes in the file (Page aligned).
+ * @return False if the file could not be mapped (Always without mmap), the region is unchanged then.
+ * @details The pages are only read from the file when they are first touched and writes stay private to the process,
+ *          so a huge file is usable at once. The bytes of the last page past the end of the file read as zero, a page
+ *          entirely past the end of the file faults.
+*/
+bool stackinterpreter::Mapping::map_file(void *address, qsizetype bytes, int fd, qint64 offset) noexcept{
+#ifdef STACKINTERPRETER_MMAP
+    if(!address || fd < 0 || offset % page_size())
+        return false;
+    return mmap(address, static_cast<size_t>(round_up(bytes)), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, static_cast<off_t>(offset)) != MAP_FAILED;
+#else
+    Q_UNUSED(address);
+    Q_UNUSED(bytes);
+    Q_UNUSED(fd);
+    Q_UNUSED(offset);
+    return false;
+#endif
+}
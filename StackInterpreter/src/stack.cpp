@@ -3,9 +3,46 @@
  * @author Guilherme Martinelli Taglietti
 */
 #include "../headers/stack.h"
-#include "qtextedit.h"
-#include <QMessageBox>
-#include <QInputDialog>
+#include "../headers/buffered_writer.h"
+#include "../headers/snapshot.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <cstdio>
+
+namespace{
+
+/// @brief Return an offset of an image file rounded up to the next section boundary
+qint64 align_section(qint64 offset) noexcept{
+    return (offset + stackinterpreter::snapshot_alignment - 1) & ~(stackinterpreter::snapshot_alignment - 1);
+}
+
+/// @brief Write zeros up to the next section boundary of an image file
+void pad_section(stackinterpreter::BufferedWriter &out, qint64 &offset) noexcept{
+    static const char zeros[4096] = {};
+    for(const qint64 end = align_section(offset); offset < end;){
+        const qint64 size = qMin<qint64>(static_cast<qint64>(sizeof(zeros)), end - offset);
+        out.write(zeros, size);
+        offset += size;
+    }
+}
+
+/// @brief Fill the section offsets of a header from its sizes (The layout described in snapshot.h)
+void layout_sections(stackinterpreter::snapshot_header &header) noexcept{
+    header.stack_offset = align_section(static_cast<qint64>(sizeof(header)) + header.return_depth * static_cast<qint64>(sizeof(qint64)));
+    header.values_offset = align_section(header.stack_offset + (header.depth + 1) * static_cast<qint64>(sizeof(qint32)));
+    header.occupancy_offset = align_section(header.values_offset + header.stored_values * static_cast<qint64>(sizeof(qint32)));
+}
+
+/// @brief Load a section of an image file into a region: mapped copy-on-write, read if it can not be mapped
+template<typename T>
+bool load_section(QFile &file, qint64 offset, stackinterpreter::Region<T> &region, qsizetype elements){
+    if(region.map_file(file.handle(), offset, elements))
+        return true;
+    const qint64 bytes = elements * static_cast<qint64>(sizeof(T));
+    return file.seek(offset) && file.read(reinterpret_cast<char*>(region.data()), bytes) == bytes;
+}
+
+} // namespace
 
 /**
  * @namespace stackinterpreter
@@ -14,7 +51,13 @@
  * @param _max_size - Maximum size of the stack.
  * @details Provides functionalities for managing the stack.
 */
-stackinterpreter::Stack::Stack(qsizetype _max_size){ max_size =_max_size > max_possible_size ? max_possible_size : _max_size; }
+stackinterpreter::Stack::Stack(qsizetype _max_size) : depth(0){
+    max_size = qBound<qsizetype>(0, _max_size, max_possible_size);
+    if(!buffer.resize(max_size + 1)){ // Could not be reserved, every push overflows
+        max_size = 0;
+        static_cast<void>(buffer.resize(1));
+    }
+}
 
 /**
  * @namespace stackinterpreter
@@ -27,7 +70,9 @@ stackinterpreter::Stack::Stack(qsizetype _max_size){ max_size =_max_size > max_p
 stackinterpreter::Stack& stackinterpreter::Stack::operator=(const Stack &rhs){
     if(this != &rhs){
         max_size = rhs.max_size;
-        stack = rhs.stack;
+        buffer = rhs.buffer;
+        depth = rhs.depth;
+        return_stack = rhs.return_stack;
     }
     return *this;
 }
@@ -37,34 +82,29 @@ stackinterpreter::Stack& stackinterpreter::Stack::operator=(const Stack &rhs){
  * @class Stack
  * @brief Pushes an integer value onto the stack.
  * @param value - Integer value to be pushed onto the stack.
- * @details Checks for stack overflow and handles errors using QMessageBox.
+ * @return Trap::STACK_OVERFLOW if the stack is full, Trap::NONE otherwise.
 */
-void stackinterpreter::Stack::PUSHI(int value) noexcept{
-    if(stack.size() == max_size){
-        QMessageBox::critical(nullptr, "Error!", "Stack overflow! Please clear or resize the stack to continue...");
-        return;
-    }
-    stack.push(value);
+stackinterpreter::Trap stackinterpreter::Stack::PUSHI(int value) noexcept{
+    if(depth == max_size)
+        return stackinterpreter::Trap::STACK_OVERFLOW;
+    push_value(value);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
- * @brief Pushes an integer value onto the stack with additional logging functionality.
+ * @brief Pushes an integer value onto the stack and records it in the trace.
  * @param value - Integer value to be pushed onto the stack.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack overflow and handles errors using QMessageBox.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_OVERFLOW if the stack is full, Trap::NONE otherwise.
 */
-void stackinterpreter::Stack::PUSHI(int value, const QString &description, QVector<QString> &log) noexcept{
-    if(stack.size() == max_size){
-        QMessageBox::critical(nullptr, "Error!", "Stack overflow! Please clear or resize the stack to continue...");
-        return;
-    }
-    else if(value == -1)
-        return;
-    stackutil::log_write(description, log, QString::number(value));
-    stack.push(value);
+stackinterpreter::Trap stackinterpreter::Stack::PUSHI(int value, stackinterpreter::Trace &trace) noexcept{
+    if(depth == max_size)
+        return stackinterpreter::Trap::STACK_OVERFLOW;
+    trace.record(stackinterpreter::Instructions::PUSHI, value, 0, 0, value);
+    push_value(value);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
@@ -72,23 +112,19 @@ void stackinterpreter::Stack::PUSHI(int value, const QString &description, QVect
  * @class Stack
  * @brief Pushes an integer value onto the stack.
  * @param value - Integer value to be pushed onto the stack.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack underflow, pushes the value onto the stack, and logs the action.
+ * @param trace - Records the executed instruction.
+ * @return Trap raised by the stack or by the memory, Trap::NONE if the value was stored.
+ * @details Checks for stack underflow, pushes the value onto the stack, and records the action in the trace.
 */
-void stackinterpreter::Stack::PUSH(int value, const QString &description, QVector<QString> &log) noexcept{
-    if(stack.empty()){
-        QMessageBox::critical(nullptr, "Error!", "Stack underflow! Not enough values to execute the instruction...");
-        return;
-    }
-    else if(value == -1)
-        return;
-    int value1 = stack.top();
-    bool ok = push_in(stackinterpreter::mem_slot(value, value1, true), *this);
-    if(ok){
-        mem_log.append("Address " + QString::number(value) + " pushed in memory the value: " + QString::number(value1) + "\n");
-        stackutil::log_write(description, log, QString::number(value1));
+stackinterpreter::Trap stackinterpreter::Stack::PUSH(int value, stackinterpreter::Trace &trace) noexcept{
+    if(depth == 0)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
+    int value1 = top_value();
+    stackinterpreter::Trap trap = push_in(value, *this);
+    if(trap == stackinterpreter::Trap::NONE){
+        trace.record(stackinterpreter::Instructions::PUSH, value, value1);
     }
+    return trap;
 }
 
 /**
@@ -96,128 +132,136 @@ void stackinterpreter::Stack::PUSH(int value, const QString &description, QVecto
  * @class Stack
  * @brief Pops a value from memory and pushes it onto the stack.
  * @param value - Address of the memory slot.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack overflow, pops a value from memory, pushes it onto the stack, and logs the action.
+ * @param trace - Records the executed instruction.
+ * @return Trap raised by the stack or by the memory, Trap::NONE if the value was loaded.
+ * @details Checks for stack overflow, pops a value from memory, pushes it onto the stack, and records the action in the trace.
 */
-void stackinterpreter::Stack::POP(int value, const QString &description, QVector<QString> &log) noexcept{
-    if(stack.size() == max_size){
-        QMessageBox::critical(nullptr, "Error!", "Stack overflow! Please clear or resize the stack to continue...");
-        return;
-    }
-    else if(value == -1)
-        return;
-    stackinterpreter::mem_slot slot_buffer = stackinterpreter::mem_slot(value, mem[value].value, false);
-    bool ok = pop_out(slot_buffer, *this);
-    if(ok){
-        mem_log.append("Address " + QString::number(value) + " removed the value " + QString::number(slot_buffer.value) + " from the memory and pushed it to the stack\n" );
-        stackutil::log_write(description, log, QString::number(value));
+stackinterpreter::Trap stackinterpreter::Stack::POP(int value, stackinterpreter::Trace &trace) noexcept{
+    if(depth == max_size)
+        return stackinterpreter::Trap::STACK_OVERFLOW;
+    int loaded = 0;
+    stackinterpreter::Trap trap = pop_out(value, loaded, *this);
+    if(trap == stackinterpreter::Trap::NONE){
+        trace.record(stackinterpreter::Instructions::POP, value, 0, 0, loaded);
     }
+    return trap;
 }
 
 
 /**
  * @namespace stackinterpreter
  * @class Stack
- * @brief Reads input from the user and pushes it onto the stack.
- * @param parent - Parent widget for input dialog.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack overflow, reads input from the user, pushes it onto the stack, and logs the action.
+ * @brief Pushes a value read by the client (GUI dialog, CLI stdin...) onto the stack.
+ * @param value - Value read from the user.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_OVERFLOW if the stack is full, Trap::NONE otherwise.
+ * @details Checks for stack overflow, pushes the input onto the stack, and records the action in the trace.
 */
-void stackinterpreter::Stack::INPUT(QWidget *parent, const QString &description, QVector<QString> &log) noexcept{
-    if(stack.size() == max_size){
-        QMessageBox::critical(nullptr, "Error!", "Stack overflow! Please clear or resize the stack to continue...");
-        return;
-    }
-    bool ok;
-    int value = QInputDialog::getInt(parent, "Type a number", "Number:", 0, -2147483647, 2147483647, 1, &ok);
-    if(ok){
-        stack.push(value);
-        stackutil::log_write(description, log, QString::number(value));
-    }
-    else
-        QMessageBox::information(parent, "Warning", "Instruction canceled!");
+stackinterpreter::Trap stackinterpreter::Stack::INPUT(int value, stackinterpreter::Trace &trace) noexcept{
+    if(depth == max_size)
+        return stackinterpreter::Trap::STACK_OVERFLOW;
+    push_value(value);
+    trace.record(stackinterpreter::Instructions::INPUT, 0, 0, 0, value);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
- * @brief Prints the top value of the stack and discards it.
- * @param parent - Parent widget for message box.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack underflow, prints the top value of the stack, discards it, and logs the action.
+ * @brief Pushes several values read by the client onto the stack, the last one on top.
+ * @param values - Values read from the user.
+ * @param count - Number of values (The INPUTN operand).
+ * @param trace - Records the executed instruction.
+ * @return Trap::INVALID_OPERAND if count is negative, Trap::STACK_OVERFLOW if the values do not fit, Trap::NONE otherwise.
+ * @details Nothing is pushed if a trap is raised. Every value is traced as an INPUT (Replayed as a PUSHI by the exporters).
 */
-void stackinterpreter::Stack::PRINT(QWidget *parent, const QString &description, QVector<QString> &log) noexcept{
-    if(stack.empty()){
-        QMessageBox::critical(nullptr, "Error!", "Stack underflow! Not enough values to execute the instruction...");
-        return;
+stackinterpreter::Trap stackinterpreter::Stack::INPUTN(const int *values, qsizetype count, stackinterpreter::Trace &trace) noexcept{
+    if(count < 0)
+        return stackinterpreter::Trap::INVALID_OPERAND;
+    if(count > max_size - depth)
+        return stackinterpreter::Trap::STACK_OVERFLOW;
+    for(qsizetype i = 0; i < count; ++i){
+        push_value(values[i]);
+        trace.record(stackinterpreter::Instructions::INPUT, 0, 0, 0, values[i]);
     }
-    int value = stack.top();
-    stack.pop();
-    stackutil::log_write(description, log, QString::number(value));
-    QMessageBox::information(parent, "PRINT Instruction", "Value discarded and printed: " + QString::fromStdString(std::to_string(value)));
+    return stackinterpreter::Trap::NONE;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Stack
+ * @brief Discards the top value of the stack and hands it to the client to be printed.
+ * @param value - Receives the discarded value.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW if the stack is empty, Trap::NONE otherwise.
+ * @details Checks for stack underflow, discards the top value of the stack, and records the action in the trace.
+*/
+stackinterpreter::Trap stackinterpreter::Stack::PRINT(int &value, stackinterpreter::Trace &trace) noexcept{
+    if(depth == 0)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
+    value = pop_value();
+    trace.record(stackinterpreter::Instructions::PRINT, 0, value);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
  * @brief Adds the top two values of the stack.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack underflow, pops the top two values from the stack, adds them, pushes the result onto the stack, and logs the action.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW if there are less than two values, Trap::NONE otherwise.
+ * @details Checks for stack underflow, pops the top two values from the stack, adds them (Wrapping around), pushes the result onto the stack, and records the action in the trace.
 */
-void stackinterpreter::Stack::ADD(const QString &description, QVector<QString> &log) noexcept{
-    if(stack.empty() || stack.size() == 1){
-        QMessageBox::critical(nullptr, "Error!", "Stack underflow! Not enough values to execute the instruction...");
-        return;
-    }
+stackinterpreter::Trap stackinterpreter::Stack::ADD(stackinterpreter::Trace &trace) noexcept{
+    if(depth < 2)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
     int value1, value2;
-    value1 = stack.top(); stack.pop();
-    value2 = stack.top(); stack.pop();
-    stack.push(value2 + value1);
-    stackutil::log_write(description, log, QString::number(value1), QString::number(value2));
+    value1 = pop_value();
+    value2 = pop_value();
+    const int result = stackinterpreter::wrapping_add(value2, value1);
+    push_value(result);
+    trace.record(stackinterpreter::Instructions::ADD, 0, value1, value2, result);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
  * @brief Subtracts the top value from the second top value of the stack.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack underflow, pops the top two values from the stack, subtracts them, pushes the result onto the stack, and logs the action.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW if there are less than two values, Trap::NONE otherwise.
+ * @details Checks for stack underflow, pops the top two values from the stack, subtracts them (Wrapping around), pushes the result onto the stack, and records the action in the trace.
 */
-void stackinterpreter::Stack::SUB(const QString &description, QVector<QString> &log) noexcept{
-    if(stack.empty() || stack.size() == 1){
-        QMessageBox::critical(nullptr, "Error!", "Stack underflow! Not enough values to execute the instruction...");
-        return;
-    }
+stackinterpreter::Trap stackinterpreter::Stack::SUB(stackinterpreter::Trace &trace) noexcept{
+    if(depth < 2)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
     int value1, value2;
-    value1 = stack.top(); stack.pop();
-    value2 = stack.top(); stack.pop();
-    stack.push(value2 - value1);
-    stackutil::log_write(description, log, QString::number(value1), QString::number(value2));
+    value1 = pop_value();
+    value2 = pop_value();
+    const int result = stackinterpreter::wrapping_sub(value2, value1);
+    push_value(result);
+    trace.record(stackinterpreter::Instructions::SUB, 0, value1, value2, result);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
  * @brief Multiplies the top two values of the stack.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack underflow, pops the top two values from the stack, multiplies them, pushes the result onto the stack, and logs the action.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW if there are less than two values, Trap::NONE otherwise.
+ * @details Checks for stack underflow, pops the top two values from the stack, multiplies them (Wrapping around), pushes the result onto the stack, and records the action in the trace.
 */
-void stackinterpreter::Stack::MUL(const QString &description, QVector<QString> &log) noexcept{
-    if(stack.empty() || stack.size() == 1){
-        QMessageBox::critical(nullptr, "Error!", "Stack underflow! Not enough values to execute the instruction...");
-        return;
-    }
+stackinterpreter::Trap stackinterpreter::Stack::MUL(stackinterpreter::Trace &trace) noexcept{
+    if(depth < 2)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
     int value1, value2;
-    value1 = stack.top(); stack.pop();
-    value2 = stack.top(); stack.pop();
-    stack.push(value2 * value1);
-    stackutil::log_write(description, log, QString::number(value1), QString::number(value2));
+    value1 = pop_value();
+    value2 = pop_value();
+    const int result = stackinterpreter::wrapping_mul(value2, value1);
+    push_value(result);
+    trace.record(stackinterpreter::Instructions::MUL, 0, value1, value2, result);
+    return stackinterpreter::Trap::NONE;
 }
 
 
@@ -225,45 +269,42 @@ void stackinterpreter::Stack::MUL(const QString &description, QVector<QString> &
  * @namespace stackinterpreter
  * @class Stack
  * @brief Divides the second top value by the top value of the stack.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack underflow, pops the top two values from the stack, divides them, pushes the result onto the stack, and logs the action.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW or Trap::DIVISION_BY_ZERO on failure, Trap::NONE otherwise.
+ * @details Checks for stack underflow, pops the top two values from the stack, divides them (INT_MIN / -1 wraps to INT_MIN), pushes the result onto the stack, and records the action in the trace.
 */
-void stackinterpreter::Stack::DIV(const QString &description, QVector<QString> &log) noexcept{
-    if(stack.empty() || stack.size() == 1){
-        QMessageBox::critical(nullptr, "Error!", "Stack underflow! Not enough values to execute the instruction...");
-        return;
-    }
-    else if(stack.top() == 0){
-        QMessageBox::critical(nullptr, "Error!", "Division by zero is impossible!");
-        return;
-    }
+stackinterpreter::Trap stackinterpreter::Stack::DIV(stackinterpreter::Trace &trace) noexcept{
+    if(depth < 2)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
+    else if(top_value() == 0)
+        return stackinterpreter::Trap::DIVISION_BY_ZERO;
     int value1, value2;
-    value1 = stack.top(); stack.pop();
-    value2 = stack.top(); stack.pop();
-    stack.push(value2 / value1);
-    stackutil::log_write(description, log, QString::number(value1), QString::number(value2));
+    value1 = pop_value();
+    value2 = pop_value();
+    const int result = stackinterpreter::wrapping_div(value2, value1);
+    push_value(result);
+    trace.record(stackinterpreter::Instructions::DIV, 0, value1, value2, result);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
  * @brief Swaps the top two values of the stack.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack underflow, pops the top two values from the stack, swaps them, and pushes them back onto the stack, then logs the action.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW if there are less than two values, Trap::NONE otherwise.
+ * @details Checks for stack underflow, pops the top two values from the stack, swaps them, and pushes them back onto the stack, then records the action in the trace.
 */
-void stackinterpreter::Stack::SWAP(const QString &description, QVector<QString> &log) noexcept{
-    if(stack.empty() || stack.size() == 1){
-        QMessageBox::critical(nullptr, "Error!", "Stack underflow! Not enough values to execute the instruction...");
-        return;
-    }
+stackinterpreter::Trap stackinterpreter::Stack::SWAP(stackinterpreter::Trace &trace) noexcept{
+    if(depth < 2)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
     int value1, value2;
-    value1 = stack.top(); stack.pop();
-    value2 = stack.top(); stack.pop();
-    stack.push(value1);
-    stack.push(value2);
-    stackutil::log_write(description, log, QString::number(value1), QString::number(value2));
+    value1 = pop_value();
+    value2 = pop_value();
+    push_value(value1);
+    push_value(value2);
+    trace.record(stackinterpreter::Instructions::SWAP, 0, value1, value2);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
@@ -274,157 +315,258 @@ void stackinterpreter::Stack::SWAP(const QString &description, QVector<QString>
  * @details Checks for stack underflow, removes and returns the top value of the stack.
 */
 int stackinterpreter::Stack::DROP() noexcept{
-    if(stack.empty()){
-        QMessageBox::critical(nullptr, "Error!", "Stack underflow! Not enough values to execute the instruction...");
+    if(depth == 0)
         return -1;
-    }
-    int value = stack.top();
-    stack.pop();
+    int value = pop_value();
     return value;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
- * @brief Removes and returns the top value of the stack, and logs the action.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @return The top value of the stack.
- * @details Checks for stack underflow, removes and returns the top value of the stack, and logs the action.
+ * @brief Removes the top value of the stack, and records the action in the trace.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW if the stack is empty, Trap::NONE otherwise.
+ * @details Checks for stack underflow, removes the top value of the stack, and records the action in the trace.
 */
-int stackinterpreter::Stack::DROP(const QString &description, QVector<QString> &log) noexcept{
-    if(stack.empty()){
-        QMessageBox::critical(nullptr, "Error!", "Stack underflow! Not enough values to execute the instruction...");
-        return -1;
-    }
-    int value = stack.top();
-    stack.pop();
-    stackutil::log_write(description, log, QString::number(value));
-    return value;
+stackinterpreter::Trap stackinterpreter::Stack::DROP(stackinterpreter::Trace &trace) noexcept{
+    if(depth == 0)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
+    int value = pop_value();
+    trace.record(stackinterpreter::Instructions::DROP, 0, value);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
  * @brief Duplicates the top value of the stack and pushes it onto the stack.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Checks for stack overflow, duplicates the top value of the stack, pushes it onto the stack, and logs the action.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW or Trap::STACK_OVERFLOW on failure, Trap::NONE otherwise.
+ * @details Checks for stack underflow and overflow, duplicates the top value of the stack, pushes it onto the stack, and records the action in the trace.
 */
-void stackinterpreter::Stack::DUP(const QString &description, QVector<QString> &log) noexcept{
-    if(stack.size() == max_size){
-        QMessageBox::critical(nullptr, "Error!", "Stack overflow! Please clear or resize the stack to continue...");
-        return;
-    }
-    int value = stack.top();
-    stack.push(value);
-    stackutil::log_write(description, log, QString::number(value));
+stackinterpreter::Trap stackinterpreter::Stack::DUP(stackinterpreter::Trace &trace) noexcept{
+    if(depth == 0)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
+    else if(depth == max_size)
+        return stackinterpreter::Trap::STACK_OVERFLOW;
+    int value = top_value();
+    push_value(value);
+    trace.record(stackinterpreter::Instructions::DUP, 0, value, 0, value);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
- * @brief Halts the program by clearing the stack and logging the action.
- * @param description - Description of the instruction.
- * @param log - Vector to store the instruction log.
- * @details Clears the stack and logs the action
+ * @brief Halts the program by clearing the stack and recording the action in the trace.
+ * @param trace - Records the executed instruction.
+ * @return Always Trap::NONE.
+ * @details Clears the stack (And the return stack) and records the action in the trace
 */
-void stackinterpreter::Stack::HLT(const QString &description, QVector<QString> &log) noexcept{
-    while(!stack.empty())
-        stack.pop();
-    stackutil::log_write(description, log);
-    clear_log();
+stackinterpreter::Trap stackinterpreter::Stack::HLT(stackinterpreter::Trace &trace) noexcept{
+    depth = 0;
+    return_stack.clear();
+    trace.record(stackinterpreter::Instructions::HLT, 0);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
- * @brief Resizes the stack to a new size if possible.
- * @param new_size - The new size for the stack.
- * @return True if the resizing was successful, false otherwise.
- * @details Checks if the new size is smaller than the current maximum size and smaller than the current stack size. If so, updates the maximum size and returns true, indicating success. Otherwise, returns false.
+ * @brief Pops the top value of the stack to decide if a JZ branch is taken.
+ * @param taken - Receives true if the popped value is zero.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW if the stack is empty, Trap::NONE otherwise.
 */
-bool stackinterpreter::Stack::resize_stack(qsizetype new_size) noexcept{
-    if(new_size < max_size && new_size < stack.size())
-        return false;
-    max_size = new_size;
-    return true;
+stackinterpreter::Trap stackinterpreter::Stack::JZ(bool &taken, stackinterpreter::Trace &trace) noexcept{
+    if(depth == 0)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
+    int value = pop_value();
+    taken = value == 0;
+    trace.record(stackinterpreter::Instructions::JZ, 0, value, 0, taken);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
  * @class Stack
- * @brief Displays the memory log in a QTextEdit widget.
- * @param os - The QTextEdit widget to display the memory log.
- * @details Concatenates all memory log strings and sets the text of the QTextEdit widget to the resulting string.
+ * @brief Pops the top value of the stack to decide if a JNZ branch is taken.
+ * @param taken - Receives true if the popped value is not zero.
+ * @param trace - Records the executed instruction.
+ * @return Trap::STACK_UNDERFLOW if the stack is empty, Trap::NONE otherwise.
 */
-void stackinterpreter::Stack::display_memory_log(QTextEdit &os) const noexcept{
-    QString text;
-    for(const QString &mem_log_str : mem_log)
-        text.append(mem_log_str);
-    os.setText(text);
+stackinterpreter::Trap stackinterpreter::Stack::JNZ(bool &taken, stackinterpreter::Trace &trace) noexcept{
+    if(depth == 0)
+        return stackinterpreter::Trap::STACK_UNDERFLOW;
+    int value = pop_value();
+    taken = value != 0;
+    trace.record(stackinterpreter::Instructions::JNZ, 0, value, 0, taken);
+    return stackinterpreter::Trap::NONE;
 }
 
 /**
  * @namespace stackinterpreter
- * @brief Overloaded operator to display the stack in a QLineEdit widget.
- * @param os - The QLineEdit widget to display the stack.
- * @param stack - The Stack object to display.
- * @details Prepares a copy of the stack, formats it as a string, and sets the text of the QLineEdit widget to the formatted string.
+ * @class Stack
+ * @brief Pushes a return address onto the return stack.
+ * @param return_address - Offset of the instruction following the CALL.
+ * @param trace - Records the executed instruction.
+ * @return Trap::CALL_STACK_OVERFLOW if there are too many nested calls, Trap::NONE otherwise.
 */
-void stackinterpreter::operator<<(QLineEdit &os, const stackinterpreter::Stack &stack){
-    QStack<int> stack_buffer = stack.get_stack();
-    stack_buffer = stackinterpreter::stackutil::prepare(stack_buffer);
-    QString text;
-    while(!stack_buffer.empty()){
-        text += QString::number(stack_buffer.top());
-        stack_buffer.pop();
-        if(!stack_buffer.empty())
-            text += " - ";
-    }
-    os.setText(text);
+stackinterpreter::Trap stackinterpreter::Stack::CALL(qsizetype return_address, stackinterpreter::Trace &trace) noexcept{
+    if(return_stack.size() == max_call_depth)
+        return stackinterpreter::Trap::CALL_STACK_OVERFLOW;
+    return_stack.push(return_address);
+    trace.record(stackinterpreter::Instructions::CALL, 0, 0, 0, static_cast<qint32>(return_address));
+    return stackinterpreter::Trap::NONE;
 }
 
-/// STACKUTIL NAMESPACE IMPLEMENTATIONS BELOW
+/**
+ * @namespace stackinterpreter
+ * @class Stack
+ * @brief Pops the return address pushed by the last CALL.
+ * @param return_address - Receives the offset to return to.
+ * @param trace - Records the executed instruction.
+ * @return Trap::CALL_STACK_UNDERFLOW if there is no pending call, Trap::NONE otherwise.
+*/
+stackinterpreter::Trap stackinterpreter::Stack::RET(qsizetype &return_address, stackinterpreter::Trace &trace) noexcept{
+    if(return_stack.empty())
+        return stackinterpreter::Trap::CALL_STACK_UNDERFLOW;
+    return_address = return_stack.top();
+    return_stack.pop();
+    trace.record(stackinterpreter::Instructions::RET, 0, 0, 0, static_cast<qint32>(return_address));
+    return stackinterpreter::Trap::NONE;
+}
 
 /**
  * @namespace stackinterpreter
- * @namespace stackutil
- * @brief Prepares a copy of a stack for display.
- * @param orig - The original stack.
- * @return A copy of the original stack.
- * @details If the original stack is empty or has only one element, returns the original stack. Otherwise, creates a copy of the original stack by popping all elements and pushing them onto a new stack, then returns the copy.
+ * @class Stack
+ * @brief Resizes the stack to a new size if possible.
+ * @param new_size - The new size for the stack.
+ * @return True if the resizing was successful, false otherwise.
+ * @details Refuses to shrink the stack below the number of elements in it and sizes above max_possible_size, growing only reserves address space.
 */
-QStack<int> stackinterpreter::stackutil::prepare(QStack<int> &orig) noexcept{
-    if(orig.empty() || orig.size() == 1)
-        return orig;
-    QStack<int> cpy;
-    while(!orig.empty()){
-        cpy.push(orig.top());
-        orig.pop();
-    }
-    return cpy;
+bool stackinterpreter::Stack::resize_stack(qsizetype new_size) noexcept{
+    if(new_size < max_size && new_size < depth)
+        return false;
+    if(new_size > max_possible_size || !buffer.resize(new_size + 1))
+        return false;
+    max_size = new_size;
+    return true;
 }
 
 /**
  * @namespace stackinterpreter
- * @namespace stackutil
- * @brief Writes an instruction to the log with optional values.
- * @param instruction - The instruction to write to the log.
- * @param log - The vector to store the instruction log.
- * @param value1 - Optional value 1 to include in the log.
- * @param value2 - Optional value 2 to include in the log.
- * @details If both value1 and value2 are "null", appends only the instruction to the log. If value2 is "null", appends the instruction followed by value1. Otherwise, appends the instruction followed by value1 and value2, separated by a space.
+ * @class Stack
+ * @brief Write the state of the VM (Stack, return stack, memory and program counter) to an image file.
+ * @param filename - Path of the image file (Replaced).
+ * @param pc - Offset of the next instruction to run (EX: run_result::pc of a run stopped by Trap::WAITING_INPUT).
+ * @return False if the file could not be written (filename is left untouched).
+ * @details The layout is described in snapshot.h. The memory is written up to its last occupied slot, every section
+ *          in a single sequential write. The image is written to a file of its own in the same directory and renamed
+ *          over filename, so the image this stack was restored from (Still mapped) is never truncated.
 */
-void stackinterpreter::stackutil::log_write(const QString &instruction, QVector<QString> &log, const QString &value1, const QString &value2) noexcept{
-    if(value1 == "null" && value2 == "null"){
-        log.append(instruction);
-        return;
+bool stackinterpreter::Stack::save_snapshot(const QString &filename, qsizetype pc) const{
+    stackinterpreter::snapshot_header header;
+    std::memcpy(header.magic, stackinterpreter::snapshot_magic, sizeof(header.magic));
+    header.version = stackinterpreter::snapshot_version;
+    header.byte_order = stackinterpreter::snapshot_byte_order;
+    header.pc = pc;
+    header.max_size = max_size;
+    header.depth = depth;
+    header.return_depth = return_stack.size();
+    header.max_mem_size = max_mem_size;
+    header.stored_values = last_occupied() + 1;
+    layout_sections(header);
+
+    const QString temporary = filename + "." + QString::number(QCoreApplication::applicationPid()) + ".tmp";
+    stackinterpreter::BufferedWriter out(temporary);
+    qint64 offset = static_cast<qint64>(sizeof(header)) + header.return_depth * static_cast<qint64>(sizeof(qint64));
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for(qsizetype return_address : return_stack){
+        const qint64 address = return_address;
+        out.write(reinterpret_cast<const char*>(&address), sizeof(address));
     }
-    else if(value2 == "null"){
-        log.append(instruction + "    " + value1);
-        return;
+    pad_section(out, offset);
+    out.write(reinterpret_cast<const char*>(buffer.constData()), (depth + 1) * static_cast<qsizetype>(sizeof(qint32)));
+    offset += (depth + 1) * static_cast<qint64>(sizeof(qint32));
+    pad_section(out, offset);
+    out.write(reinterpret_cast<const char*>(values.constData()), header.stored_values * static_cast<qsizetype>(sizeof(qint32)));
+    offset += header.stored_values * static_cast<qint64>(sizeof(qint32));
+    pad_section(out, offset);
+    out.write(reinterpret_cast<const char*>(occupancy.constData()), words(header.stored_values) * static_cast<qsizetype>(sizeof(quint64)));
+    offset += words(header.stored_values) * static_cast<qint64>(sizeof(quint64));
+    pad_section(out, offset);
+    if(!out.close() || std::rename(temporary.toStdString().c_str(), filename.toStdString().c_str()) != 0){ // rename replaces filename (QFile::rename does not)
+        QFile::remove(temporary);
+        return false;
     }
-    log.append(instruction + "    " + value1 + " " + value2);
+    return true;
 }
 
+/**
+ * @namespace stackinterpreter
+ * @class Stack
+ * @brief Replace the state of the VM with an image file written by save_snapshot.
+ * @param filename - Path of the image file.
+ * @param program_size - Number of instructions of the program that will resume (Bounds the pc and return addresses).
+ * @param pc - Receives the offset of the next instruction to run.
+ * @return False if the file can not be read or is not a valid image (The state is unchanged if the header is refused).
+ * @details Nothing is parsed: the stack, memory and occupancy sections are mapped copy-on-write into their regions,
+ *          pages are only read from the file when the program touches them (Read instead on builds without mmap).
+ *          The sizes of the stack and of the memory become the ones of the image. The image file must not be modified
+ *          while the stack uses it.
+*/
+bool stackinterpreter::Stack::load_snapshot(const QString &filename, qsizetype program_size, qsizetype &pc){
+    QFile file(filename);
+    stackinterpreter::snapshot_header header;
+    if(!file.open(QIODevice::ReadOnly) || file.read(reinterpret_cast<char*>(&header), sizeof(header)) != static_cast<qint64>(sizeof(header)))
+        return false;
+    if(std::memcmp(header.magic, stackinterpreter::snapshot_magic, sizeof(header.magic)) || header.version != stackinterpreter::snapshot_version ||
+       header.byte_order != stackinterpreter::snapshot_byte_order)
+        return false;
+    if(header.pc < 0 || header.pc > program_size || header.max_size < 0 || header.max_size > max_possible_size ||
+       header.depth < 0 || header.depth > header.max_size || header.return_depth < 0 || header.return_depth > max_call_depth ||
+       header.max_mem_size < 0 || header.max_mem_size > max_possible_mem_size || header.stored_values < 0 || header.stored_values > header.max_mem_size)
+        return false;
+    stackinterpreter::snapshot_header expected = header;
+    layout_sections(expected);
+    if(header.stack_offset != expected.stack_offset || header.values_offset != expected.values_offset || header.occupancy_offset != expected.occupancy_offset ||
+       file.size() < align_section(header.occupancy_offset + words(header.stored_values) * static_cast<qint64>(sizeof(quint64))))
+        return false;
+    QStack<qsizetype> return_addresses;
+    for(qint64 i = 0, address; i < header.return_depth; ++i){
+        if(file.read(reinterpret_cast<char*>(&address), sizeof(address)) != static_cast<qint64>(sizeof(address)) || address < 0 || address > program_size)
+            return false;
+        return_addresses.push(address);
+    }
+
+    /// Fresh regions: the pages past the sections are zero, not left over from the previous state
+    if(!buffer.resize(0) || !buffer.resize(header.max_size + 1) || !values.resize(0) || !values.resize(header.max_mem_size) ||
+       !occupancy.resize(0) || !occupancy.resize(words(header.max_mem_size)) || !dirty.resize(words(words(header.max_mem_size)))){
+        static_cast<void>(resize_memory(0));
+        max_size = 0;
+        depth = 0;
+        return_stack.clear();
+        static_cast<void>(buffer.resize(1));
+        return false;
+    }
+    max_size = header.max_size;
+    depth = header.depth;
+    return_stack = return_addresses;
+    max_mem_size = header.max_mem_size;
+    const bool loaded = load_section(file, header.stack_offset, buffer, header.depth + 1) &&
+                        load_section(file, header.values_offset, values, header.stored_values) &&
+                        load_section(file, header.occupancy_offset, occupancy, words(header.stored_values));
+    if(!loaded){
+        clear_stack();
+        return_stack.clear();
+        clear_memory();
+        return false;
+    }
+    if(header.stored_values & 63) // Only the slots below stored_values may be occupied
+        occupancy[header.stored_values >> 6] &= (quint64(1) << (header.stored_values & 63)) - 1;
+    mark_all_dirty();
+    pc = header.pc;
+    return true;
+}
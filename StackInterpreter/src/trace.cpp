@@ -0,0 +1,117 @@
+/**
+ * @file trace.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/trace.h"
+
+/**
+ * @namespace stackinterpreter
+ * @class Trace
+ * @brief Constructor - Allocates the ring buffer.
+ * @param _depth - Max number of entries held (Rounded up to a power of two).
+*/
+stackinterpreter::Trace::Trace(qsizetype _depth){
+    set_depth(_depth);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Trace
+ * @brief Change the max number of entries held, the trace is cleared.
+ * @param depth - New depth (Rounded up to a power of two, at least 1).
+*/
+void stackinterpreter::Trace::set_depth(qsizetype depth) noexcept{
+    qsizetype capacity = 1;
+    while(capacity < depth)
+        capacity <<= 1;
+    entries.fill(trace_entry{-1, stackinterpreter::Instructions::HLT, 0, 0, 0, 0}, capacity);
+    mask = static_cast<quint64>(capacity - 1);
+    head = first = 0;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Trace
+ * @brief Format an entry as an instruction log line (EX: "PUSHI    18", "ADD    5 3").
+ * @param entry - Recorded entry.
+ * @return The mnemonic followed by the values of the instruction.
+*/
+QString stackinterpreter::Trace::format_instruction(const trace_entry &entry){
+    QString line = stackinterpreter::instruction_mnemonic(entry.opcode);
+    switch(entry.opcode){
+        case stackinterpreter::Instructions::PUSHI:
+        case stackinterpreter::Instructions::POP:
+        case stackinterpreter::Instructions::JMP:
+            return line + "    " + QString::number(entry.operand);
+        case stackinterpreter::Instructions::PUSH:
+        case stackinterpreter::Instructions::PRINT:
+        case stackinterpreter::Instructions::DROP:
+        case stackinterpreter::Instructions::DUP:
+        case stackinterpreter::Instructions::JZ:
+        case stackinterpreter::Instructions::JNZ:
+            return line + "    " + QString::number(entry.value1);
+        case stackinterpreter::Instructions::INPUT:
+        case stackinterpreter::Instructions::CALL:
+        case stackinterpreter::Instructions::RET:
+            return line + "    " + QString::number(entry.result);
+        case stackinterpreter::Instructions::ADD:
+        case stackinterpreter::Instructions::SUB:
+        case stackinterpreter::Instructions::MUL:
+        case stackinterpreter::Instructions::DIV:
+        case stackinterpreter::Instructions::SWAP:
+            return line + "    " + QString::number(entry.value1) + " " + QString::number(entry.value2);
+        default:
+            return line;
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Trace
+ * @brief Format an entry as a memory log line.
+ * @param entry - Recorded entry.
+ * @return The memory operation done by the entry, an empty string if it is not a PUSH or POP.
+*/
+QString stackinterpreter::Trace::format_memory(const trace_entry &entry){
+    if(entry.opcode == stackinterpreter::Instructions::PUSH)
+        return "Address " + QString::number(entry.operand) + " pushed in memory the value: " + QString::number(entry.value1) + "\n";
+    if(entry.opcode == stackinterpreter::Instructions::POP)
+        return "Address " + QString::number(entry.operand) + " removed the value " + QString::number(entry.result) + " from the memory and pushed it to the stack\n";
+    return QString();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Trace
+ * @brief Build the straight line program replaying the entries recorded since the last clear, oldest first (Used by the exporters).
+ * @param code - Receives the executed instructions without control flow (Empty on failure).
+ * @return False if the oldest entries were overwritten (The replay would start in the middle of the run).
+ * @details INPUT becomes a PUSHI of the value read, JZ/JNZ become a DROP of the condition they popped and JMP, CALL
+ *          and RET are left out (They never touch the data stack).
+*/
+bool stackinterpreter::Trace::executed_code(QVector<stackinterpreter::bytecode_cell> &code) const{
+    code.clear();
+    if(get_recorded() > static_cast<quint64>(size()))
+        return false;
+    code.reserve(size());
+    for(qsizetype i = 0; i < size(); ++i){
+        const trace_entry &entry = at(i);
+        switch(entry.opcode){
+            case stackinterpreter::Instructions::INPUT:
+                code.append(stackinterpreter::bytecode_cell(stackinterpreter::Instructions::PUSHI, entry.result));
+                break;
+            case stackinterpreter::Instructions::JZ:
+            case stackinterpreter::Instructions::JNZ:
+                code.append(stackinterpreter::bytecode_cell(stackinterpreter::Instructions::DROP, 0));
+                break;
+            case stackinterpreter::Instructions::JMP:
+            case stackinterpreter::Instructions::CALL:
+            case stackinterpreter::Instructions::RET:
+                break;
+            default:
+                code.append(stackinterpreter::bytecode_cell(entry.opcode, entry.operand));
+                break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file trap.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/trap.h"
+
+/**
+ * @namespace stackinterpreter
+ * @brief Return a human readable message for a trap (Used by the clients to report the error).
+ * @param trap - Trap raised by the interpreter core.
+ * @return Message describing the trap.
+*/
+const char* stackinterpreter::trap_message(Trap trap) noexcept{
+    switch(trap){
+        case Trap::NONE:
+            return "No error";
+        case Trap::STACK_OVERFLOW:
+            return "Stack overflow! Please clear or resize the stack to continue...";
+        case Trap::STACK_UNDERFLOW:
+            return "Stack underflow! Not enough values to execute the instruction...";
+        case Trap::DIVISION_BY_ZERO:
+            return "Division by zero is impossible!";
+        case Trap::INVALID_ADDRESS:
+            return "Invalid memory address, check hexadecimal address!";
+        case Trap::EMPTY_MEMORY_SLOT:
+            return "Error removing empty memory slot!";
+        case Trap::INVALID_OPERAND:
+            return "Type a valid number!";
+        case Trap::INVALID_INSTRUCTION:
+            return "Invalid instruction!";
+        case Trap::CALL_STACK_OVERFLOW:
+            return "Return stack overflow! Too many nested CALL instructions...";
+        case Trap::CALL_STACK_UNDERFLOW:
+            return "Return stack underflow! RET without a matching CALL...";
+        case Trap::WAITING_INPUT:
+            return "Waiting for an input value...";
+        case Trap::INTERRUPTED:
+            return "Run interrupted";
+        case Trap::BREAKPOINT:
+            return "Breakpoint reached";
+    }
+    return "Unknown error";
+}
@@ -0,0 +1,174 @@
+/**
+ * @file verifier.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/verifier.h"
+#include "../headers/stack.h" // Stack::max_possible_size
+
+namespace{
+
+/// @brief Number of values an instruction pops and pushes (Control flow is handled by the verifier itself)
+void stack_effect(qint32 opcode, qint32 operand, qint32 &pops, qint32 &pushes) noexcept{
+    switch(opcode){
+        case stackinterpreter::Instructions::PUSHI:
+        case stackinterpreter::Instructions::POP:
+        case stackinterpreter::Instructions::INPUT:
+            pops = 0; pushes = 1; return;
+        case stackinterpreter::Instructions::PUSH:
+        case stackinterpreter::Instructions::PRINT:
+        case stackinterpreter::Instructions::DROP:
+        case stackinterpreter::Instructions::JZ:
+        case stackinterpreter::Instructions::JNZ:
+            pops = 1; pushes = 0; return;
+        case stackinterpreter::Instructions::ADD:
+        case stackinterpreter::Instructions::SUB:
+        case stackinterpreter::Instructions::MUL:
+        case stackinterpreter::Instructions::DIV:
+            pops = 2; pushes = 1; return;
+        case stackinterpreter::Instructions::SWAP:
+            pops = 2; pushes = 2; return;
+        case stackinterpreter::Instructions::DUP:
+            pops = 1; pushes = 2; return;
+        case stackinterpreter::Instructions::INPUTN:
+            pops = 0; pushes = operand; return;
+        default:
+            pops = 0; pushes = 0; return;
+    }
+}
+
+} // namespace
+
+/**
+ * @namespace stackinterpreter
+ * @class Verifier
+ * @brief Verify the stack depth of a program.
+ * @param _program - Assembled program.
+ * @return True if the program is verified, false otherwise (See get_failed_pc() and get_failure()).
+*/
+bool stackinterpreter::Verifier::verify(const Program &_program) noexcept{
+    program = &_program;
+    summaries.clear();
+    call_chain.clear();
+    failed_pc = -1;
+    failure.clear();
+    routine_summary summary;
+    bool ok = analyze(0, false, summary, depths);
+    required_depth = ok ? summary.required : 0;
+    max_growth = ok ? summary.growth : 0;
+    max_call_nesting = ok ? summary.nesting : 0;
+    if(!ok)
+        depths.clear();
+    program = nullptr;
+    return ok;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class Verifier
+ * @brief Follow every path of a routine computing the depth before each instruction.
+ * @param entry - Offset of the first instruction of the routine.
+ * @param subroutine - True for CALL targets (RET allowed), false for the main program.
+ * @param summary - Receives the stack requirements of the routine.
+ * @param depth_at - Receives the depth (Relative to the entry) before every instruction of the routine.
+ * @return True if the routine is verified, false otherwise.
+*/
+bool stackinterpreter::Verifier::analyze(qsizetype entry, bool subroutine, routine_summary &summary, QVector<qint32> &depth_at) noexcept{
+    const QVector<stackinterpreter::bytecode_cell> &code = program->get_code();
+    depth_at.fill(UNKNOWN_DEPTH, code.size() + 1);
+    summary = routine_summary{0, 0, 0, 0, false};
+    qint32 return_depth = UNKNOWN_DEPTH;
+    QVector<qsizetype> worklist;
+    depth_at[entry] = 0;
+    worklist.append(entry);
+
+    /// Propagates the depth to a successor, the depth must be the same on every path
+    auto reach = [&](qsizetype from, qsizetype to, qint32 depth) -> bool{
+        if(to < 0 || to > code.size()) // Program built through the API (The assembler refuses such targets)
+            return fail(from, "Branch target out of the program");
+        if(depth_at[to] == UNKNOWN_DEPTH){
+            depth_at[to] = depth;
+            worklist.append(to);
+            return true;
+        }
+        return depth_at[to] == depth || fail(from, "Inconsistent stack depth at offset " + QString::number(to));
+    };
+
+    while(!worklist.isEmpty()){
+        qsizetype pc = worklist.takeLast();
+        if(pc == code.size())
+            continue; // Falls off the program (Halts)
+        const qint32 depth = depth_at[pc];
+        const stackinterpreter::bytecode_cell &cell = code[pc];
+        qint32 pops, pushes;
+        stack_effect(cell.opcode, cell.operand, pops, pushes);
+        if(pushes < 0)
+            return fail(pc, "Negative value count");
+        if(qint64(depth) - pops + pushes > stackinterpreter::Stack::max_possible_size)
+            return fail(pc, "Stack depth exceeds the max stack size");
+        summary.required = qMax(summary.required, pops - depth);
+        qint32 after = depth - pops + pushes;
+        summary.growth = qMax(summary.growth, after);
+        switch(cell.opcode){
+            case stackinterpreter::Instructions::HLT:
+            case stackinterpreter::Instructions::ERROR:
+                break;
+            case stackinterpreter::Instructions::JMP:
+                if(!reach(pc, cell.operand, after))
+                    return false;
+                break;
+            case stackinterpreter::Instructions::JZ:
+            case stackinterpreter::Instructions::JNZ:
+                if(!reach(pc, cell.operand, after) || !reach(pc, pc + 1, after))
+                    return false;
+                break;
+            case stackinterpreter::Instructions::CALL:{
+                if(cell.operand < 0 || cell.operand > code.size())
+                    return fail(pc, "Branch target out of the program");
+                if(call_chain.contains(cell.operand))
+                    return fail(pc, "Recursive CALL can not be verified");
+                if(!summaries.contains(cell.operand)){
+                    routine_summary callee;
+                    QVector<qint32> callee_depths;
+                    call_chain.append(cell.operand);
+                    bool ok = analyze(cell.operand, true, callee, callee_depths);
+                    call_chain.removeLast();
+                    if(!ok)
+                        return false;
+                    summaries.insert(cell.operand, callee);
+                }
+                const routine_summary callee = summaries.value(cell.operand);
+                if(qint64(depth) + callee.growth > stackinterpreter::Stack::max_possible_size)
+                    return fail(pc, "Stack depth exceeds the max stack size");
+                summary.required = qMax(summary.required, callee.required - depth);
+                summary.growth = qMax(summary.growth, depth + callee.growth);
+                summary.nesting = qMax(summary.nesting, callee.nesting);
+                if(callee.returns && !reach(pc, pc + 1, depth + callee.net))
+                    return false;
+                break;
+            }
+            case stackinterpreter::Instructions::RET:
+                if(!subroutine)
+                    return fail(pc, "RET outside a subroutine");
+                if(return_depth != UNKNOWN_DEPTH && return_depth != depth)
+                    return fail(pc, "Subroutine returns with different stack depths");
+                return_depth = depth;
+                break;
+            default:
+                if(!reach(pc, pc + 1, after))
+                    return false;
+                break;
+        }
+    }
+    summary.returns = return_depth != UNKNOWN_DEPTH;
+    summary.net = summary.returns ? return_depth : 0;
+    if(subroutine)
+        ++summary.nesting;
+    return true;
+}
+
+/// @brief Record why the verification failed, always returns false
+bool stackinterpreter::Verifier::fail(qsizetype pc, const QString &reason) noexcept{
+    failed_pc = pc;
+    failure = reason;
+    return false;
+}
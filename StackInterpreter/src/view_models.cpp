@@ -0,0 +1,498 @@
+/**
+ * @file view_models.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/view_models.h"
+
+int stackinterpreter::StackModel::rowCount(const QModelIndex &parent) const{
+    return parent.isValid() ? 0 : rows;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class StackModel
+ * @brief Format a value of the stack.
+ * @param index - Row of the value (0 is the bottom).
+ * @param role - Only Qt::DisplayRole has data.
+ * @return The value as text.
+*/
+QVariant stackinterpreter::StackModel::data(const QModelIndex &index, int role) const{
+    if(role != Qt::DisplayRole || !index.isValid() || index.row() >= rows)
+        return QVariant();
+    if(!use_published)
+        return index.row() < stack.get_size() ? QString::number(stack.get_data()[index.row()]) : QVariant();
+    if(elided && !index.row())
+        return QString("...");
+    return QString::number(published[index.row() - (elided ? 1 : 0)]);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class StackModel
+ * @brief Show the stack after the GUI ran instructions (The stack belongs to the GUI).
+ * @details Pushed and popped values are inserted and removed at the end, the rows kept are repainted (Only the visible
+ *          ones are formatted again).
+*/
+void stackinterpreter::StackModel::sync(){
+    use_published = false;
+    published.clear();
+    elided = false;
+    resize_rows(static_cast<int>(stack.get_size()));
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class StackModel
+ * @brief Show the top values published by a running program.
+ * @param state - State published by the VMWorker.
+*/
+void stackinterpreter::StackModel::sync(const stackinterpreter::vm_state &state){
+    use_published = true;
+    published.resize(state.top.size());
+    for(qsizetype i = 0; i < state.top.size(); ++i)
+        published[state.top.size() - 1 - i] = state.top[i];
+    elided = state.depth > state.top.size();
+    resize_rows(static_cast<int>(published.size()) + (elided ? 1 : 0));
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class StackModel
+ * @brief Insert or remove rows at the end, then repaint the rows kept.
+ * @param count - New number of rows.
+*/
+void stackinterpreter::StackModel::resize_rows(int count){
+    const int kept = qMin(rows, count);
+    if(count > rows){
+        beginInsertRows(QModelIndex(), rows, count - 1);
+        rows = count;
+        endInsertRows();
+    }
+    else if(count < rows){
+        beginRemoveRows(QModelIndex(), count, rows - 1);
+        rows = count;
+        endRemoveRows();
+    }
+    if(kept)
+        emit dataChanged(index(0), index(kept - 1), {Qt::DisplayRole});
+}
+
+int stackinterpreter::TraceModel::rowCount(const QModelIndex &parent) const{
+    return parent.isValid() ? 0 : static_cast<int>(end - start);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TraceModel
+ * @brief Format an instruction log line.
+ * @param index - Row of the entry (0 is the oldest one).
+ * @param role - Only Qt::DisplayRole has data.
+ * @return The formatted entry (Nothing if it was overwritten since the last sync).
+*/
+QVariant stackinterpreter::TraceModel::data(const QModelIndex &index, int role) const{
+    if(role != Qt::DisplayRole || !index.isValid())
+        return QVariant();
+    if(frozen){
+        const int row = index.row() - frozen_first;
+        return row >= 0 && row < frozen_rows.size() ? frozen_rows[row] : QVariant();
+    }
+    return format_row(index.row());
+}
+
+/// @brief Format the entry of a row from the trace (Nothing if it was overwritten since the last sync)
+QVariant stackinterpreter::TraceModel::format_row(int row) const{
+    const quint64 entry = start + static_cast<quint64>(row), oldest = trace.get_head() - static_cast<quint64>(trace.size());
+    if(entry < oldest || entry >= trace.get_head())
+        return QVariant();
+    return stackinterpreter::Trace::format_instruction(trace.at(static_cast<qsizetype>(entry - oldest)));
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TraceModel
+ * @brief Format rows now and stop reading the trace until the next sync (Called before the worker runs a program).
+ * @param first - First row kept (EX: first visible row).
+ * @param last - Last row kept, the other rows are blank.
+*/
+void stackinterpreter::TraceModel::freeze(int first, int last){
+    frozen_rows.clear();
+    frozen_first = qMax(first, 0);
+    for(int row = frozen_first; row <= last && row < rowCount(); ++row)
+        frozen_rows.append(format_row(row));
+    frozen = true;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TraceModel
+ * @brief Remove the rows of the entries overwritten or cleared, append the rows of the entries recorded since the last sync.
+*/
+void stackinterpreter::TraceModel::sync(){
+    frozen = false;
+    frozen_rows.clear();
+    const quint64 head = trace.get_head(), oldest = qMax(head - static_cast<quint64>(trace.size()), start);
+    if(head < end){ // The trace was resized, nothing is kept
+        beginResetModel();
+        start = end = head;
+        endResetModel();
+        return;
+    }
+    const quint64 removed = qMin(oldest, end) - start;
+    if(removed){
+        beginRemoveRows(QModelIndex(), 0, static_cast<int>(removed) - 1);
+        start += removed;
+        endRemoveRows();
+    }
+    if(oldest > end) // Every row was removed and entries were overwritten before they were shown
+        start = end = oldest;
+    if(head > end){
+        beginInsertRows(QModelIndex(), static_cast<int>(end - start), static_cast<int>(head - start) - 1);
+        end = head;
+        endInsertRows();
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class TraceModel
+ * @brief Remove every row (The trace keeps its entries, only the next ones are shown).
+*/
+void stackinterpreter::TraceModel::clear(){
+    if(end > start){
+        beginRemoveRows(QModelIndex(), 0, static_cast<int>(end - start) - 1);
+        start = end;
+        endRemoveRows();
+    }
+    start = end = trace.get_head();
+}
+
+int stackinterpreter::MemoryLogModel::rowCount(const QModelIndex &parent) const{
+    return parent.isValid() ? 0 : static_cast<int>(entries.size() - front);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryLogModel
+ * @brief Format a memory log line.
+ * @param index - Row of the entry (0 is the oldest one).
+ * @param role - Only Qt::DisplayRole has data.
+ * @return The formatted entry (Nothing if it was overwritten since the last sync).
+*/
+QVariant stackinterpreter::MemoryLogModel::data(const QModelIndex &index, int role) const{
+    if(role != Qt::DisplayRole || !index.isValid())
+        return QVariant();
+    if(frozen){
+        const int row = index.row() - frozen_first;
+        return row >= 0 && row < frozen_rows.size() ? frozen_rows[row] : QVariant();
+    }
+    return format_row(index.row());
+}
+
+/// @brief Format the entry of a row from the trace (Nothing if it was overwritten since the last sync)
+QVariant stackinterpreter::MemoryLogModel::format_row(int row) const{
+    const quint64 entry = entries[front + row], oldest = trace.get_head() - static_cast<quint64>(trace.size());
+    if(entry < oldest || entry >= trace.get_head())
+        return QVariant();
+    QString line = stackinterpreter::Trace::format_memory(trace.at(static_cast<qsizetype>(entry - oldest)));
+    line.chop(1); // One line per row
+    return line;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryLogModel
+ * @brief Format rows now and stop reading the trace until the next sync (Called before the worker runs a program).
+ * @param first - First row kept (EX: first visible row).
+ * @param last - Last row kept, the other rows are blank.
+*/
+void stackinterpreter::MemoryLogModel::freeze(int first, int last){
+    frozen_rows.clear();
+    frozen_first = qMax(first, 0);
+    for(int row = frozen_first; row <= last && row < rowCount(); ++row)
+        frozen_rows.append(format_row(row));
+    frozen = true;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryLogModel
+ * @brief Remove the rows of the entries overwritten or cleared, append the rows of the PUSH and POP entries recorded since the last sync.
+*/
+void stackinterpreter::MemoryLogModel::sync(){
+    frozen = false;
+    frozen_rows.clear();
+    const quint64 head = trace.get_head(), oldest = head - static_cast<quint64>(trace.size());
+    if(head < scanned){ // The trace was resized, nothing is kept
+        beginResetModel();
+        entries.clear();
+        front = 0;
+        scanned = head;
+        endResetModel();
+        return;
+    }
+    qsizetype removed = 0;
+    while(front + removed < entries.size() && entries[front + removed] < oldest)
+        ++removed;
+    if(removed){
+        beginRemoveRows(QModelIndex(), 0, static_cast<int>(removed) - 1);
+        front += removed;
+        if(front > entries.size() / 2){
+            entries.remove(0, front);
+            front = 0;
+        }
+        endRemoveRows();
+    }
+    QVector<quint64> added;
+    for(quint64 entry = qMax(scanned, oldest); entry < head; ++entry){
+        const qint32 opcode = trace.at(static_cast<qsizetype>(entry - oldest)).opcode;
+        if(opcode == stackinterpreter::Instructions::PUSH || opcode == stackinterpreter::Instructions::POP)
+            added.append(entry);
+    }
+    scanned = head;
+    if(!added.isEmpty()){
+        const int rows = rowCount();
+        beginInsertRows(QModelIndex(), rows, rows + static_cast<int>(added.size()) - 1);
+        entries.append(added);
+        endInsertRows();
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryLogModel
+ * @brief Remove every row (The trace keeps its entries, only the next ones are shown).
+*/
+void stackinterpreter::MemoryLogModel::clear(){
+    if(rowCount()){
+        beginRemoveRows(QModelIndex(), 0, rowCount() - 1);
+        entries.clear();
+        front = 0;
+        endRemoveRows();
+    }
+    scanned = trace.get_head();
+}
+
+int stackinterpreter::MemoryModel::rowCount(const QModelIndex &parent) const{
+    return parent.isValid() ? 0 : rows;
+}
+
+int stackinterpreter::MemoryModel::columnCount(const QModelIndex &parent) const{
+    return parent.isValid() ? 0 : columns;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryModel
+ * @brief Format a memory slot.
+ * @param index - Row (Slots row * columns to row * columns + columns - 1) and column of the slot.
+ * @param role - Only Qt::DisplayRole has data.
+ * @return The value of the slot, "--" if it is free.
+*/
+QVariant stackinterpreter::MemoryModel::data(const QModelIndex &index, int role) const{
+    if(role != Qt::DisplayRole || !index.isValid())
+        return QVariant();
+    const qsizetype address = static_cast<qsizetype>(index.row()) * columns + index.column();
+    if(address >= memory.get_max_mem_size())
+        return QVariant();
+    if(use_window){
+        const qsizetype slot = address - window_first;
+        if(slot < 0 || slot >= window_values.size())
+            return QVariant();
+        return window_occupied[slot] ? format(window_values[slot]) : QString("--");
+    }
+    return memory.is_occupied(address) ? format(memory.value_at(address)) : QString("--");
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryModel
+ * @brief Label the columns with the slot offset and the rows with the address of their first slot.
+ * @param section - Row or column.
+ * @param orientation - Qt::Horizontal for the columns.
+ * @param role - Only Qt::DisplayRole has data.
+ * @return The label.
+*/
+QVariant stackinterpreter::MemoryModel::headerData(int section, Qt::Orientation orientation, int role) const{
+    if(role != Qt::DisplayRole)
+        return QVariant();
+    if(orientation == Qt::Horizontal)
+        return "+" + QString::number(section, hex ? 16 : 10).toUpper();
+    const qsizetype address = static_cast<qsizetype>(section) * columns;
+    return hex ? "0x" + QString("%1").arg(address, 8, 16, QChar('0')).toUpper() : QString::number(address);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryModel
+ * @brief Switch between hexadecimal and decimal values (The view repaints what it shows).
+ * @param _hex - True for hexadecimal.
+*/
+void stackinterpreter::MemoryModel::set_hex(bool _hex){
+    if(hex == _hex)
+        return;
+    hex = _hex;
+    if(!rows)
+        return;
+    emit dataChanged(index(0, 0), index(rows - 1, columns - 1), {Qt::DisplayRole});
+    emit headerDataChanged(Qt::Horizontal, 0, columns - 1);
+    emit headerDataChanged(Qt::Vertical, 0, rows - 1);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryModel
+ * @brief Repaint the visible slots written since the last sync (The memory belongs to the GUI) and clear the dirty bits.
+*/
+void stackinterpreter::MemoryModel::sync(){
+    resize_rows();
+    if(use_window){ // The worker cleared the dirty bits, the visible slots are read again
+        use_window = false;
+        window_values.clear();
+        window_occupied.clear();
+        repaint(visible_first, visible_end);
+    }
+    else{
+        memory.dirty_ranges(visible_first, visible_end, dirty);
+        for(const stackinterpreter::memory_range &range : dirty)
+            repaint(range.first, range.end);
+    }
+    memory.clear_dirty();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryModel
+ * @brief Show the window of slots published by a running program, repainting the slots it wrote.
+ * @param state - State published by the VMWorker.
+*/
+void stackinterpreter::MemoryModel::sync(const stackinterpreter::vm_state &state){
+    const bool moved = !use_window || state.memory_first != window_first || state.memory_values.size() != window_values.size();
+    use_window = true;
+    window_first = state.memory_first;
+    window_values = state.memory_values;
+    window_occupied = state.memory_occupied;
+    if(moved){
+        repaint(visible_first, visible_end);
+        return;
+    }
+    for(const stackinterpreter::memory_range &range : state.memory_dirty)
+        repaint(range.first, range.end);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryModel
+ * @brief Insert or remove rows at the end to follow the size of the memory.
+*/
+void stackinterpreter::MemoryModel::resize_rows(){
+    const int count = static_cast<int>((memory.get_max_mem_size() + columns - 1) / columns);
+    if(count > rows){
+        beginInsertRows(QModelIndex(), rows, count - 1);
+        rows = count;
+        endInsertRows();
+    }
+    else if(count < rows){
+        beginRemoveRows(QModelIndex(), count, rows - 1);
+        rows = count;
+        endRemoveRows();
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryModel
+ * @brief Repaint the rows holding the slots [first, end) (The view only repaints the part in its viewport).
+ * @param first - First slot.
+ * @param end - Slot after the last one.
+*/
+void stackinterpreter::MemoryModel::repaint(qsizetype first, qsizetype end){
+    end = qMin(end, static_cast<qsizetype>(rows) * columns);
+    if(first >= end)
+        return;
+    emit dataChanged(index(static_cast<int>(first / columns), 0), index(static_cast<int>((end - 1) / columns), columns - 1), {Qt::DisplayRole});
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class MemoryModel
+ * @brief Format a value as 8 hexadecimal digits (Two's complement) or as a decimal.
+ * @param value - Value of a slot.
+ * @return The formatted value.
+*/
+QString stackinterpreter::MemoryModel::format(int value) const{
+    return hex ? QString("%1").arg(static_cast<quint32>(value), 8, 16, QChar('0')).toUpper() : QString::number(value);
+}
+
+int stackinterpreter::ProgramModel::rowCount(const QModelIndex &parent) const{
+    return parent.isValid() ? 0 : static_cast<int>(program.size());
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class ProgramModel
+ * @brief Format an instruction of the program.
+ * @param index - Row of the instruction (Its offset).
+ * @param role - Qt::DisplayRole, or Qt::ToolTipRole for its source line.
+ * @return The markers, offset, mnemonic and operand of the instruction.
+*/
+QVariant stackinterpreter::ProgramModel::data(const QModelIndex &index, int role) const{
+    if(!index.isValid() || index.row() >= program.size())
+        return QVariant();
+    const qsizetype offset = index.row();
+    if(role == Qt::ToolTipRole)
+        return QString("Line %1").arg(program.line_of(offset));
+    if(role != Qt::DisplayRole)
+        return QVariant();
+    const stackinterpreter::bytecode_cell &cell = program.get_code()[offset];
+    QString line = QString(offset == pc ? "> " : "  ") + (breakpoints[offset] ? "* " : "  ") + QString::number(offset).rightJustified(5) + "  " +
+                   stackinterpreter::instruction_mnemonic(cell.opcode);
+    if(stackinterpreter::instruction_has_operand(cell.opcode))
+        line += " " + QString::number(cell.operand);
+    return line;
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class ProgramModel
+ * @brief Show a newly loaded program, without breakpoints.
+ * @param _program - Assembled program.
+*/
+void stackinterpreter::ProgramModel::set_program(const stackinterpreter::Program &_program){
+    beginResetModel();
+    program = _program;
+    breakpoints.fill(false, program.size());
+    pc = -1;
+    endResetModel();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class ProgramModel
+ * @brief Move the next instruction marker, only both rows are repainted.
+ * @param _pc - Offset of the next instruction (-1 or out of the program: no marker).
+*/
+void stackinterpreter::ProgramModel::set_pc(qsizetype _pc){
+    const qsizetype previous = pc;
+    pc = _pc >= 0 && _pc < program.size() ? _pc : -1;
+    if(previous == pc)
+        return;
+    if(previous >= 0)
+        emit dataChanged(index(static_cast<int>(previous)), index(static_cast<int>(previous)), {Qt::DisplayRole});
+    if(pc >= 0)
+        emit dataChanged(index(static_cast<int>(pc)), index(static_cast<int>(pc)), {Qt::DisplayRole});
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class ProgramModel
+ * @brief Set or remove the breakpoint of an instruction.
+ * @param offset - Offset of the instruction.
+ * @return True if the instruction has a breakpoint now.
+*/
+bool stackinterpreter::ProgramModel::toggle_breakpoint(qsizetype offset){
+    if(offset < 0 || offset >= breakpoints.size())
+        return false;
+    breakpoints[offset] = !breakpoints[offset];
+    emit dataChanged(index(static_cast<int>(offset)), index(static_cast<int>(offset)), {Qt::DisplayRole});
+    return breakpoints[offset];
+}
@@ -0,0 +1,264 @@
+/**
+ * @file vm_worker.cpp
+ * @author Guilherme Martinelli Taglietti
+*/
+#include "../headers/vm_worker.h"
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Constructor - Runs programs over the stack and the trace of the GUI.
+ * @param _stack - Stack of the GUI (Only touched by the worker while a program runs).
+ * @param _handler - Instruction handler of the GUI, its trace records the steps.
+*/
+stackinterpreter::VMWorker::VMWorker(stackinterpreter::Stack &_stack, stackinterpreter::InstructionHandler &_handler) :
+    stack(_stack), handler(_handler), interrupt(false), requests(0), window_first(0), window_count(0){
+    handler.set_interrupt(&interrupt);
+}
+
+stackinterpreter::VMWorker::~VMWorker(){
+    handler.set_interrupt(nullptr);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Set a request and interrupt the run loops (Read at their next taken branch).
+ * @param flag - state_request, pause_request or stop_request.
+ * @details The request is set before the interrupt, the worker clears the interrupt before taking the requests: a
+ *          request is never lost, at worst an interrupt finds no request and the run goes on.
+*/
+void stackinterpreter::VMWorker::request(int flag) noexcept{
+    requests.fetch_or(flag);
+    interrupt.store(true);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Set or remove a breakpoint (Thread safe), a running program applies it at its next taken branch.
+ * @param offset - Offset of the instruction.
+ * @param enabled - True to stop before the instruction, false to remove the breakpoint.
+*/
+void stackinterpreter::VMWorker::set_breakpoint(qsizetype offset, bool enabled){
+    {
+        QMutexLocker locker(&breakpoint_mutex);
+        breakpoint_changes.insert(offset, enabled);
+    }
+    request(breakpoint_request);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Forget the breakpoint changes not applied yet (Thread safe, called before loading another program).
+*/
+void stackinterpreter::VMWorker::discard_breakpoints(){
+    QMutexLocker locker(&breakpoint_mutex);
+    breakpoint_changes.clear();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Patch the breakpoint changes in the loaded program (Worker thread, between two runs of the Interpreter).
+*/
+void stackinterpreter::VMWorker::apply_breakpoints(){
+    QMutexLocker locker(&breakpoint_mutex);
+    if(!interpreter)
+        return;
+    for(auto it = breakpoint_changes.cbegin(); it != breakpoint_changes.cend(); ++it){
+        if(it.value())
+            static_cast<void>(interpreter->set_breakpoint(it.key()));
+        else
+            interpreter->clear_breakpoint(it.key());
+    }
+    breakpoint_changes.clear();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Load a program, the next run starts it from its first instruction.
+ * @param _program - Assembled program (Without constant folding, the offsets stay the ones of the source).
+*/
+void stackinterpreter::VMWorker::load(const stackinterpreter::Program &_program){
+    program = _program;
+    interpreter = std::make_unique<stackinterpreter::Interpreter>(program);
+    interpreter->set_interrupt(&interrupt);
+    interpreter->set_track_writes(true);
+    reset();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Forget the progress of the program (The stack and the memory keep their values), the next run starts it over.
+*/
+void stackinterpreter::VMWorker::reset(){
+    pc = 0;
+    executed = 0;
+    finished = false;
+    started = false;
+    io.input.clear();
+    io.input_position = 0;
+    io.output.clear();
+    requests.store(0);
+    interrupt.store(false);
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Run the program until it halts, traps, is paused or stopped (Publishing a state per request meanwhile).
+*/
+void stackinterpreter::VMWorker::run(){
+    remaining = std::numeric_limits<quint64>::max();
+    until = until_depth = -1;
+    resume();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Run the next count instructions of the program, tracing them.
+ * @param count - Number of instructions.
+*/
+void stackinterpreter::VMWorker::step(quint64 count){
+    remaining = count;
+    until = until_depth = -1;
+    resume();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Run the next instruction, a CALL runs until its subroutine returns (Not traced, stops at the breakpoints met meanwhile).
+*/
+void stackinterpreter::VMWorker::step_over(){
+    if(!interpreter || finished || pc >= program.size() || program.get_code()[pc].opcode != stackinterpreter::Instructions::CALL){
+        step(1);
+        return;
+    }
+    remaining = std::numeric_limits<quint64>::max();
+    until = pc + 1;
+    until_depth = stack.get_return_stack().size(); // A recursive call reaching pc + 1 deeper goes on
+    resume();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Run the program until it reaches an instruction (Or a breakpoint first), the state reports Trap::BREAKPOINT there.
+ * @param target - Offset of the instruction.
+*/
+void stackinterpreter::VMWorker::run_to_cursor(qsizetype target){
+    remaining = std::numeric_limits<quint64>::max();
+    until = target;
+    until_depth = -1;
+    resume();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Append input values and resume the run or the step stopped by Trap::WAITING_INPUT.
+ * @param values - Values consumed by INPUT and INPUTN.
+*/
+void stackinterpreter::VMWorker::provide_input(const QVector<int> &values){
+    io.input.append(values);
+    resume();
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Run loop of the worker, emits stopped() once before returning.
+*/
+void stackinterpreter::VMWorker::resume(){
+    if(!interpreter){
+        emit stopped(take_state(stackinterpreter::Trap::NONE, false));
+        return;
+    }
+    if(finished){
+        const quint64 steps = remaining;
+        reset();
+        remaining = steps;
+    }
+    const bool traced = remaining != std::numeric_limits<quint64>::max();
+    apply_breakpoints();
+    if(!traced && !started && interpreter->has_breakpoint(pc)){ // A run resumed from a breakpoint runs its instruction, a new one stops there first
+        started = true;
+        emit stopped(take_state(stackinterpreter::Trap::BREAKPOINT, false));
+        return;
+    }
+    started = true;
+    for(;;){
+        const stackinterpreter::run_result result = traced ? handler.run(stack, program, pc, io, remaining) : interpreter->run_to(stack, pc, io, until, until_depth);
+        pc = result.pc;
+        executed += result.executed;
+        if(traced)
+            remaining -= result.executed;
+        if(result.trap != stackinterpreter::Trap::INTERRUPTED){
+            finished = result.trap != stackinterpreter::Trap::WAITING_INPUT && result.trap != stackinterpreter::Trap::BREAKPOINT;
+            requests.store(0); // Requests still pending are answered by stopped()
+            interrupt.store(false);
+            emit stopped(take_state(result.trap, false));
+            return;
+        }
+        interrupt.store(false);
+        const int pending = requests.exchange(0);
+        if(pending & breakpoint_request)
+            apply_breakpoints();
+        if(pending & stop_request){
+            finished = true;
+            emit stopped(take_state(stackinterpreter::Trap::INTERRUPTED, false));
+            return;
+        }
+        if((pending & pause_request) || (traced && !remaining)){
+            emit stopped(take_state(stackinterpreter::Trap::INTERRUPTED, false));
+            return;
+        }
+        if(pending & state_request)
+            emit state_changed(take_state(stackinterpreter::Trap::NONE, true));
+    }
+}
+
+/**
+ * @namespace stackinterpreter
+ * @class VMWorker
+ * @brief Copy the state of the program, moving the printed values out of the buffers.
+ * @param trap - Trap reported by the state.
+ * @param running - True if the program goes on after this state.
+ * @return The state.
+*/
+stackinterpreter::vm_state stackinterpreter::VMWorker::take_state(stackinterpreter::Trap trap, bool running){
+    stackinterpreter::vm_state state;
+    state.pc = pc;
+    state.executed = executed;
+    state.depth = stack.get_size();
+    state.trap = trap;
+    state.running = running;
+    const int *data = stack.get_data();
+    for(qsizetype i = state.depth - 1; i >= 0 && state.top.size() < top_values; --i)
+        state.top.append(data[i]);
+    if(io.output.size() > max_output) // The console keeps as many lines
+        io.output.remove(0, io.output.size() - max_output);
+    state.output.swap(io.output);
+    state.memory_first = qBound<qsizetype>(0, window_first.load(), stack.get_max_mem_size());
+    const qsizetype window_end = qMin(state.memory_first + qMax<qsizetype>(window_count.load(), 0), stack.get_max_mem_size());
+    state.memory_values.reserve(window_end - state.memory_first);
+    state.memory_occupied.reserve(window_end - state.memory_first);
+    for(qsizetype address = state.memory_first; address < window_end; ++address){
+        state.memory_occupied.append(stack.is_occupied(address));
+        state.memory_values.append(stack.value_at(address));
+    }
+    stack.dirty_ranges(state.memory_first, window_end, state.memory_dirty);
+    stack.clear_dirty();
+    if(trap == stackinterpreter::Trap::WAITING_INPUT && pc < program.size()){
+        const stackinterpreter::bytecode_cell &cell = program.get_code()[pc];
+        const qsizetype available = io.input.size() - io.input_position;
+        state.input_needed = cell.opcode == stackinterpreter::Instructions::INPUTN ? cell.operand - available : 1;
+    }
+    return state;
+}